@@ -0,0 +1,33 @@
+#version 450
+
+// Written by overdraw_view_t in src/overdraw_view.cpp.
+layout (set = 0, binding = 0) uniform sampler2D overdraw;
+
+// The count that maps to red, the previous frame's maximum.
+layout (push_constant) uniform push_constants
+{
+    float max_count;
+} heat_map;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+    float count = texelFetch(overdraw, ivec2(gl_FragCoord.xy), 0).r;
+    if (count <= 0.0)
+    {
+        out_color = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // Blue at a single fragment, through green and yellow to red.
+    float t = clamp((count - 1.0) / max(heat_map.max_count - 1.0, 1.0), 0.0,
+                    1.0);
+    vec3 color = t < 0.5
+        ? mix(vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), t * 2.0)
+        : t < 0.75
+            ? mix(vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), t * 4.0 - 2.0)
+            : mix(vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t * 4.0 - 3.0);
+
+    out_color = vec4(color, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+// Replaces shader.frag in the overdraw view. The target is blended additively,
+// so every fragment adds one to its pixel's count.
+layout (location = 0) out float count;
+
+void main()
+{
+    count = 1.0;
+}
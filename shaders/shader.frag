@@ -1,10 +1,37 @@
 #version 450
 
+// Matches color_mode_t in src/pipeline_variants.hpp.
+layout (constant_id = 0) const int COLOR_MODE = 0;
+
+// Matches frame_uniforms_t in src/shader_interface.hpp.
+layout (set = 0, binding = 0) uniform frame_uniforms
+{
+    mat4 view_projection;
+    vec4 color_scale;
+} frame;
+
+// Written by texture_t in src/texture.cpp. A single white texel when there's
+// no texture.
+layout (set = 1, binding = 0) uniform sampler2D albedo;
+
 layout (location = 0) out vec4 out_color;
 
 layout (location = 0) in vec3 color;
+layout (location = 1) in vec2 uv;
 
 void main()
 {
-    out_color = vec4(color, 1.0);
-}
\ No newline at end of file
+    vec3 base = color * texture(albedo, uv).rgb;
+    vec3 result = base;
+
+    if (COLOR_MODE == 1)
+    {
+        result = vec3(dot(base, vec3(0.2126, 0.7152, 0.0722)));
+    }
+    else if (COLOR_MODE == 2)
+    {
+        result = vec3(1.0) - base;
+    }
+
+    out_color = vec4(result * frame.color_scale.rgb, 1.0);
+}
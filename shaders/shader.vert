@@ -3,10 +3,30 @@
 layout (location = 0) in vec2 a_position;
 layout (location = 1) in vec3 a_color;
 
+// Matches frame_uniforms_t in src/shader_interface.hpp.
+layout (set = 0, binding = 0) uniform frame_uniforms
+{
+    mat4 view_projection;
+    vec4 color_scale;
+} frame;
+
+// Matches push_constants_t in src/shader_interface.hpp.
+layout (push_constant) uniform push_constants
+{
+    mat2 transform;
+    vec2 translation;
+    float depth;
+    vec4 tint;
+} object;
+
 layout(location = 0) out vec3 color;
+layout(location = 1) out vec2 uv;
 
 void main()
 {
-    gl_Position = vec4(a_position, 0.0, 1.0);
-    color = a_color;
-}
\ No newline at end of file
+    gl_Position = frame.view_projection * vec4(object.transform * a_position + object.translation, object.depth, 1.0);
+    color = a_color * object.tint.rgb;
+
+    // The meshes span -0.5 to 0.5, so the texture covers each object once.
+    uv = a_position + vec2(0.5);
+}
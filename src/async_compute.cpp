@@ -0,0 +1,323 @@
+#include "async_compute.hpp"
+
+namespace
+{
+
+auto get_timestamp_valid_bits(VkPhysicalDevice p_physical_device,
+                              std::uint32_t p_family) -> std::uint32_t
+{
+    auto family_count = std::uint32_t{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device, &family_count,
+                                             nullptr);
+
+    auto families = std::vector<VkQueueFamilyProperties>(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device, &family_count,
+                                             families.data());
+
+    return p_family < families.size() ? families[p_family].timestampValidBits
+                                      : 0;
+}
+
+auto create_query_pool(VkDevice p_device, std::uint32_t p_query_count)
+    -> unique_query_pool_t
+{
+    const auto create_info = VkQueryPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = p_query_count,
+        .pipelineStatistics = 0};
+
+    auto query_pool = static_cast<VkQueryPool>(VK_NULL_HANDLE);
+    const auto result =
+        vkCreateQueryPool(p_device, &create_info, nullptr, &query_pool);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Failed to create the timestamp query pool. "
+                   "Vulkan error {}. Queue overlap won't be measured.\n",
+                   result);
+        return unique_query_pool_t();
+    }
+
+    return unique_query_pool_t(query_pool, {p_device});
+}
+
+} // namespace
+
+async_compute_t::async_compute_t(VkPhysicalDevice p_physical_device,
+                                 VkDevice p_device,
+                                 std::uint32_t p_graphics_family,
+                                 std::uint32_t p_compute_family,
+                                 VkQueue p_compute_queue, bool p_is_separate)
+    : m_device(p_device), m_compute_queue(p_compute_queue),
+      m_is_separate(p_is_separate), m_command_pool(), m_command_buffers(),
+      m_ready_semaphores(), m_query_pool(), m_timestamp_period(0.0),
+      m_frame_number(0), m_written(), m_graphics_times(), m_compute_times(),
+      m_overlap_times()
+{
+    const auto pool_create_info = VkCommandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = p_compute_family};
+
+    auto command_pool = static_cast<VkCommandPool>(VK_NULL_HANDLE);
+    const auto pool_result = vkCreateCommandPool(p_device, &pool_create_info,
+                                                 nullptr, &command_pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the compute command "
+                   "pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_command_pool = unique_command_pool_t(command_pool, {p_device});
+
+    // Freed along with the pool.
+    const auto allocate_info = VkCommandBufferAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = SLOT_COUNT};
+
+    m_command_buffers.resize(SLOT_COUNT);
+    const auto allocate_result = vkAllocateCommandBuffers(
+        p_device, &allocate_info, m_command_buffers.data());
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the compute command "
+                   "buffers. Vulkan error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto semaphore_create_info = VkSemaphoreCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0};
+
+    for (auto i = std::uint32_t{0}; i < SLOT_COUNT; i++)
+    {
+        auto semaphore = static_cast<VkSemaphore>(VK_NULL_HANDLE);
+        const auto semaphore_result = vkCreateSemaphore(
+            p_device, &semaphore_create_info, nullptr, &semaphore);
+        if (semaphore_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create a compute semaphore. "
+                       "Vulkan error {}.\n",
+                       semaphore_result);
+            std::exit(EXIT_FAILURE);
+        }
+        m_ready_semaphores.push_back(
+            unique_semaphore_t(semaphore, {p_device}));
+    }
+
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    if (get_timestamp_valid_bits(p_physical_device, p_graphics_family) == 0 ||
+        get_timestamp_valid_bits(p_physical_device, p_compute_family) == 0)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The graphics or compute queue can't write "
+                   "timestamps. Queue overlap won't be measured.\n");
+    }
+    else
+    {
+        m_query_pool = create_query_pool(
+            p_device, QUERIES_PER_FRAME * FRAMES_IN_QUERY_POOL);
+        m_timestamp_period =
+            static_cast<double>(device_properties.limits.timestampPeriod);
+    }
+
+    fmt::print("[INFO]: Running compute work on {}.\n",
+               m_is_separate
+                   ? fmt::format("its own queue (family {})", p_compute_family)
+                   : std::string("the graphics queue"));
+}
+
+auto async_compute_t::begin_frame(std::uint64_t p_frame_number) -> void
+{
+    m_frame_number = p_frame_number;
+
+    // This frame's queries were last written two frames ago. The graphics
+    // work from then is covered by the fence that was just waited on, and
+    // the compute work by the semaphore that the previous frame waited on.
+    const auto index = m_frame_number % FRAMES_IN_QUERY_POOL;
+    if (m_written[index] == (GRAPHICS_WRITTEN | COMPUTE_WRITTEN))
+    {
+        read_timestamps(get_first_query());
+    }
+    m_written[index] = 0;
+}
+
+auto async_compute_t::submit(std::uint32_t p_slot,
+                             const record_function_t& p_record) -> void
+{
+    const auto command_buffer = m_command_buffers[p_slot];
+    vkResetCommandBuffer(command_buffer, 0);
+
+    const auto begin_info = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr};
+
+    const auto begin_result = vkBeginCommandBuffer(command_buffer, &begin_info);
+    if (begin_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to begin recording a compute "
+                   "command buffer. Vulkan error {}.\n",
+                   begin_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto query_pool = m_query_pool.get();
+    const auto first_query = get_first_query() + 2;
+    if (query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(command_buffer, query_pool, first_query, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            query_pool, first_query);
+    }
+
+    p_record(command_buffer);
+
+    if (query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(command_buffer,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool,
+                            first_query + 1);
+        m_written[m_frame_number % FRAMES_IN_QUERY_POOL] |= COMPUTE_WRITTEN;
+    }
+
+    const auto end_result = vkEndCommandBuffer(command_buffer);
+    if (end_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to stop recording a compute command "
+                   "buffer. Vulkan error {}.\n",
+                   end_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto submit_info = VkSubmitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = m_ready_semaphores[p_slot].get_address()};
+
+    const auto submit_result =
+        vkQueueSubmit(m_compute_queue, 1, &submit_info, VK_NULL_HANDLE);
+    if (submit_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to submit compute work. Vulkan "
+                   "error {}.\n",
+                   submit_result);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+auto async_compute_t::get_ready_semaphore(std::uint32_t p_slot) const
+    -> VkSemaphore
+{
+    return m_ready_semaphores[p_slot].get();
+}
+
+auto async_compute_t::record_graphics_begin(VkCommandBuffer p_command_buffer)
+    -> void
+{
+    const auto query_pool = m_query_pool.get();
+    if (query_pool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    const auto first_query = get_first_query();
+    vkCmdResetQueryPool(p_command_buffer, query_pool, first_query, 2);
+    vkCmdWriteTimestamp(p_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        query_pool, first_query);
+}
+
+auto async_compute_t::record_graphics_end(VkCommandBuffer p_command_buffer)
+    -> void
+{
+    const auto query_pool = m_query_pool.get();
+    if (query_pool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(p_command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        query_pool, get_first_query() + 1);
+    m_written[m_frame_number % FRAMES_IN_QUERY_POOL] |= GRAPHICS_WRITTEN;
+}
+
+auto async_compute_t::print_statistics() const -> void
+{
+    if (m_query_pool.get() == VK_NULL_HANDLE || m_graphics_times.count == 0)
+    {
+        return;
+    }
+
+    const auto hidden =
+        m_compute_times.mean > 0.0
+            ? m_overlap_times.mean / m_compute_times.mean * 100.0
+            : 0.0;
+
+    fmt::print("[INFO]: Compute ran on {}. Per frame, graphics took {:.3f} ms "
+               "and compute {:.3f} ms on average, and they overlapped for "
+               "{:.3f} ms, hiding {:.1f}% of the compute work.\n",
+               m_is_separate ? "its own queue" : "the graphics queue",
+               m_graphics_times.mean, m_compute_times.mean,
+               m_overlap_times.mean, hidden);
+}
+
+auto async_compute_t::get_first_query() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_frame_number % FRAMES_IN_QUERY_POOL) *
+           QUERIES_PER_FRAME;
+}
+
+// Compares timestamps from different queues. The spec only promises that
+// timestamps are comparable within one queue, but every driver in practice
+// reads the same device clock for all of them.
+auto async_compute_t::read_timestamps(std::uint32_t p_first_query) -> void
+{
+    auto timestamps = std::array<std::uint64_t, QUERIES_PER_FRAME>{};
+    const auto result = vkGetQueryPoolResults(
+        m_device, m_query_pool.get(), p_first_query, QUERIES_PER_FRAME,
+        sizeof(timestamps), timestamps.data(), sizeof(std::uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    const auto [graphics_begin, graphics_end, compute_begin, compute_end] =
+        timestamps;
+    if (graphics_end < graphics_begin || compute_end < compute_begin)
+    {
+        return;
+    }
+
+    const auto to_milliseconds = [this](std::uint64_t p_ticks) {
+        return static_cast<double>(p_ticks) * m_timestamp_period * 1e-6;
+    };
+
+    const auto overlap_begin = (std::max)(graphics_begin, compute_begin);
+    const auto overlap_end = (std::min)(graphics_end, compute_end);
+
+    m_graphics_times.add(to_milliseconds(graphics_end - graphics_begin));
+    m_compute_times.add(to_milliseconds(compute_end - compute_begin));
+    m_overlap_times.add(overlap_end > overlap_begin
+                            ? to_milliseconds(overlap_end - overlap_begin)
+                            : 0.0);
+}
@@ -0,0 +1,97 @@
+#ifndef INCLUDED_ASYNC_COMPUTE_HPP
+#define INCLUDED_ASYNC_COMPUTE_HPP
+
+#include "running_statistics.hpp"
+#include "vulkan_handle.hpp"
+
+// Runs the compute work that prepares the next frame, on a queue of its own
+// when the device has a compute family without graphics, so that it overlaps
+// with the graphics queue rendering the current frame.
+//
+// Work is double buffered in slots. Frame N submits compute work into slot
+// (N + 1) % SLOT_COUNT, which signals that slot's ready semaphore, and the
+// graphics submit for frame N + 1 waits on it. Without a separate family, the
+// same submits go to the graphics queue instead, behind the frame, so both
+// paths run exactly the same commands in the same dependency order.
+//
+// Timestamps are written at the start and end of each frame's graphics work
+// and of the compute work submitted alongside it. They're read back two
+// frames later, once both have completed, and show how much of the compute
+// work really was hidden behind graphics.
+class async_compute_t
+{
+  public:
+    static constexpr auto SLOT_COUNT = std::uint32_t{2};
+
+    using record_function_t = std::function<void(VkCommandBuffer)>;
+
+    // p_compute_queue is the graphics queue itself if p_is_separate is
+    // false.
+    async_compute_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                    std::uint32_t p_graphics_family,
+                    std::uint32_t p_compute_family, VkQueue p_compute_queue,
+                    bool p_is_separate);
+
+    async_compute_t(const async_compute_t&) = delete;
+    auto operator=(const async_compute_t&) -> async_compute_t& = delete;
+
+    // Called once the previous frame's fence has been waited on, with the
+    // number of the frame about to be recorded.
+    auto begin_frame(std::uint64_t p_frame_number) -> void;
+
+    // Records p_record into p_slot's command buffer and submits it. The
+    // slot's previous work must have been consumed by a graphics submit that
+    // has since completed.
+    auto submit(std::uint32_t p_slot, const record_function_t& p_record)
+        -> void;
+
+    // Signalled by the work last submitted to p_slot. It has to be waited on
+    // exactly once, by the graphics submit that uses the slot.
+    auto get_ready_semaphore(std::uint32_t p_slot) const -> VkSemaphore;
+
+    // Write the timestamps around this frame's graphics work. Both have to be
+    // recorded outside of a render pass, into the first and last command
+    // buffers of the frame's submit.
+    auto record_graphics_begin(VkCommandBuffer p_command_buffer) -> void;
+    auto record_graphics_end(VkCommandBuffer p_command_buffer) -> void;
+
+    auto is_separate() const -> bool { return m_is_separate; }
+
+    auto print_statistics() const -> void;
+
+  private:
+    // Graphics begin and end, then compute begin and end.
+    static constexpr auto QUERIES_PER_FRAME = std::uint32_t{4};
+    static constexpr auto FRAMES_IN_QUERY_POOL = std::uint32_t{2};
+
+    static constexpr auto GRAPHICS_WRITTEN = std::uint32_t{1};
+    static constexpr auto COMPUTE_WRITTEN = std::uint32_t{2};
+
+    auto get_first_query() const -> std::uint32_t;
+    auto read_timestamps(std::uint32_t p_first_query) -> void;
+
+    VkDevice m_device;
+    VkQueue m_compute_queue;
+    bool m_is_separate;
+
+    unique_command_pool_t m_command_pool;
+    std::vector<VkCommandBuffer> m_command_buffers;
+    std::vector<unique_semaphore_t> m_ready_semaphores;
+
+    // Empty if either queue family can't write timestamps.
+    unique_query_pool_t m_query_pool;
+    double m_timestamp_period;
+    std::uint64_t m_frame_number;
+
+    // Which of each frame's timestamps have been written, as a mask of
+    // GRAPHICS_WRITTEN and COMPUTE_WRITTEN. A frame's results are only read
+    // if both were.
+    std::array<std::uint32_t, FRAMES_IN_QUERY_POOL> m_written;
+
+    // In milliseconds.
+    running_statistics_t m_graphics_times;
+    running_statistics_t m_compute_times;
+    running_statistics_t m_overlap_times;
+};
+
+#endif
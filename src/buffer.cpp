@@ -0,0 +1,94 @@
+#include "buffer.hpp"
+
+auto find_memory_type(VkPhysicalDevice p_physical_device,
+                      std::uint32_t p_type_bits,
+                      VkMemoryPropertyFlags p_properties)
+    -> std::optional<std::uint32_t>
+{
+    auto memory_properties = VkPhysicalDeviceMemoryProperties{};
+    vkGetPhysicalDeviceMemoryProperties(p_physical_device, &memory_properties);
+
+    for (auto i = (uint32_t)0; i < memory_properties.memoryTypeCount; i++)
+    {
+        if ((p_type_bits & (1 << i)) &&
+            (memory_properties.memoryTypes[i].propertyFlags & p_properties) ==
+                p_properties)
+        {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+auto create_buffer(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                   VkDeviceSize p_size, VkBufferUsageFlags p_usage,
+                   VkMemoryPropertyFlags p_properties,
+                   const std::vector<std::uint32_t>& p_queue_families)
+    -> std::tuple<unique_buffer_t, unique_device_memory_t>
+{
+    const auto concurrent = p_queue_families.size() > 1;
+
+    const auto create_info =
+        VkBufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                           .pNext = nullptr,
+                           .flags = 0,
+                           .size = p_size,
+                           .usage = p_usage,
+                           .sharingMode = concurrent
+                                              ? VK_SHARING_MODE_CONCURRENT
+                                              : VK_SHARING_MODE_EXCLUSIVE,
+                           .queueFamilyIndexCount =
+                               concurrent ? static_cast<std::uint32_t>(
+                                                p_queue_families.size())
+                                          : 0,
+                           .pQueueFamilyIndices =
+                               concurrent ? p_queue_families.data() : nullptr};
+
+    auto buffer = (VkBuffer)VK_NULL_HANDLE;
+    const auto result =
+        vkCreateBuffer(p_device, &create_info, nullptr, &buffer);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print(stderr, fmt::fg(fmt::color::red),
+                   "[FATAL ERROR]: Failed to create a buffer. Vulkan error {}.",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto memory_requirements = VkMemoryRequirements{};
+    vkGetBufferMemoryRequirements(p_device, buffer, &memory_requirements);
+
+    const auto memory_type = find_memory_type(
+        p_physical_device, memory_requirements.memoryTypeBits, p_properties);
+    if (!memory_type.has_value())
+    {
+        fmt::print(stderr, fmt::fg(fmt::color::red),
+                   "[FATAL ERROR]: Failed to find a suitable memory type for a "
+                   "buffer.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto allocate_info =
+        VkMemoryAllocateInfo{.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                             .pNext = nullptr,
+                             .allocationSize = memory_requirements.size,
+                             .memoryTypeIndex = *memory_type};
+
+    auto memory = (VkDeviceMemory)VK_NULL_HANDLE;
+    const auto allocate_result =
+        vkAllocateMemory(p_device, &allocate_info, nullptr, &memory);
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print(stderr, fmt::fg(fmt::color::red),
+                   "[FATAL ERROR]: Failed to allocate some GPU memory. Vulkan "
+                   "error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    vkBindBufferMemory(p_device, buffer, memory, 0);
+
+    return {unique_buffer_t(buffer, {p_device}),
+            unique_device_memory_t(memory, {p_device})};
+}
@@ -0,0 +1,26 @@
+#ifndef INCLUDED_BUFFER_HPP
+#define INCLUDED_BUFFER_HPP
+
+#include "vulkan_handle.hpp"
+
+// Returns the index of the first memory type allowed by p_type_bits that has
+// all of p_properties, if there is one.
+auto find_memory_type(VkPhysicalDevice p_physical_device,
+                      std::uint32_t p_type_bits,
+                      VkMemoryPropertyFlags p_properties)
+    -> std::optional<std::uint32_t>;
+
+// The return values for this function is
+// - buffer
+// - the buffer's memory
+//
+// The memory is bound to the buffer, but not mapped. If p_queue_families
+// names more than one family, the buffer is shared between them
+// concurrently, so that it never needs an ownership transfer.
+auto create_buffer(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                   VkDeviceSize p_size, VkBufferUsageFlags p_usage,
+                   VkMemoryPropertyFlags p_properties,
+                   const std::vector<std::uint32_t>& p_queue_families = {})
+    -> std::tuple<unique_buffer_t, unique_device_memory_t>;
+
+#endif
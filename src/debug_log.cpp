@@ -0,0 +1,217 @@
+#include "debug_log.hpp"
+
+debug_log_t::debug_log_t()
+    : m_slots(std::make_unique<slot_t[]>(CAPACITY)), m_enqueue_position(0),
+      m_dequeue_position(0), m_dropped_count(0),
+      m_rate_window_start(std::chrono::steady_clock::now()),
+      m_lines_in_rate_window(0), m_rate_limited_count(0),
+      m_reported_dropped_count(0), m_stop(false)
+{
+    for (auto i = std::size_t{0}; i < CAPACITY; i++)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+debug_log_t::~debug_log_t()
+{
+    m_stop.store(true, std::memory_order_release);
+    m_thread.join();
+}
+
+auto debug_log_t::push(debug_log_severity_t p_severity,
+                       std::string_view p_message) -> bool
+{
+    auto position = m_enqueue_position.load(std::memory_order_relaxed);
+    auto slot = static_cast<slot_t*>(nullptr);
+
+    while (true)
+    {
+        slot = &m_slots[position & (CAPACITY - 1)];
+        const auto sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) -
+                                static_cast<std::ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            if (m_enqueue_position.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The logger thread hasn't caught up yet. Dropping the message is
+            // better than making a driver thread wait on the terminal.
+            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = m_enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    const auto length = (std::min)(p_message.size(), MAX_MESSAGE_LENGTH);
+    std::memcpy(slot->text.data(), p_message.data(), length);
+    slot->length = static_cast<std::uint32_t>(length);
+    slot->severity = p_severity;
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+auto debug_log_t::pop(debug_log_severity_t& p_severity, std::string& p_message)
+    -> bool
+{
+    auto& slot = m_slots[m_dequeue_position & (CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != m_dequeue_position + 1)
+    {
+        return false;
+    }
+
+    p_severity = slot.severity;
+    p_message.assign(slot.text.data(), slot.length);
+
+    slot.sequence.store(m_dequeue_position + CAPACITY,
+                        std::memory_order_release);
+    m_dequeue_position++;
+    return true;
+}
+
+auto debug_log_t::run() -> void
+{
+    auto severity = debug_log_severity_t::warning;
+    auto message = std::string();
+    message.reserve(MAX_MESSAGE_LENGTH);
+
+    while (true)
+    {
+        // Read the flag before draining, so that nothing pushed before the
+        // destructor was called can be missed.
+        const auto stopping = m_stop.load(std::memory_order_acquire);
+
+        auto popped_any = false;
+        while (pop(severity, message))
+        {
+            handle(severity, message);
+            popped_any = true;
+        }
+
+        const auto dropped_count =
+            m_dropped_count.load(std::memory_order_relaxed);
+        if (dropped_count != m_reported_dropped_count)
+        {
+            print(debug_log_severity_t::warning,
+                  fmt::format("The log fell behind, and dropped {} messages.",
+                              dropped_count - m_reported_dropped_count));
+            m_reported_dropped_count = dropped_count;
+        }
+
+        flush_repeats(stopping);
+
+        if (stopping)
+        {
+            break;
+        }
+
+        if (!popped_any)
+        {
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+}
+
+auto debug_log_t::handle(debug_log_severity_t p_severity,
+                         const std::string& p_message) -> void
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    const auto repeat = m_repeats.find(p_message);
+    if (repeat != m_repeats.end())
+    {
+        repeat->second.suppressed_count++;
+        return;
+    }
+
+    m_repeats.emplace(p_message, repeat_state_t{.severity = p_severity,
+                                                .window_start = now,
+                                                .suppressed_count = 0});
+    print(p_severity, p_message);
+}
+
+// Summarizes and forgets every message whose repeat window has run out, or
+// all of them if p_force is set.
+auto debug_log_t::flush_repeats(bool p_force) -> void
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto it = m_repeats.begin(); it != m_repeats.end();)
+    {
+        const auto& [message, repeat] = *it;
+        if (!p_force && now - repeat.window_start < REPEAT_WINDOW)
+        {
+            ++it;
+            continue;
+        }
+
+        if (repeat.suppressed_count > 0)
+        {
+            // Cut the message down, as the whole point is to keep the
+            // terminal readable.
+            constexpr auto PREVIEW_LENGTH = std::size_t{80};
+            const auto preview =
+                std::string_view(message).substr(0, PREVIEW_LENGTH);
+
+            print(repeat.severity,
+                  fmt::format("Repeated {} more times: {}{}",
+                              repeat.suppressed_count, preview,
+                              message.size() > PREVIEW_LENGTH ? "..." : ""));
+        }
+
+        it = m_repeats.erase(it);
+    }
+
+    if (p_force && m_rate_limited_count > 0)
+    {
+        m_lines_in_rate_window = 0;
+        print(debug_log_severity_t::warning,
+              fmt::format("{} lines were held back by the rate limit.",
+                          m_rate_limited_count));
+        m_rate_limited_count = 0;
+    }
+}
+
+auto debug_log_t::print(debug_log_severity_t p_severity,
+                        std::string_view p_message) -> void
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_rate_window_start >= std::chrono::seconds(1))
+    {
+        if (m_rate_limited_count > 0)
+        {
+            fmt::print(fmt::fg(fmt::color::yellow),
+                       "[VULKAN]: {} lines were held back by the rate limit.\n",
+                       m_rate_limited_count);
+            m_rate_limited_count = 0;
+        }
+
+        m_rate_window_start = now;
+        m_lines_in_rate_window = 0;
+    }
+
+    if (m_lines_in_rate_window >= MAX_LINES_PER_SECOND)
+    {
+        m_rate_limited_count++;
+        return;
+    }
+    m_lines_in_rate_window++;
+
+    const auto color = p_severity == debug_log_severity_t::error
+                           ? fmt::fg(fmt::color::red)
+                           : fmt::fg(fmt::color::yellow);
+    fmt::print(color, "[VULKAN]: {}\n", p_message);
+}
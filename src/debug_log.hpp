@@ -0,0 +1,87 @@
+#ifndef INCLUDED_DEBUG_LOG_HPP
+#define INCLUDED_DEBUG_LOG_HPP
+
+enum class debug_log_severity_t
+{
+    warning,
+    error
+};
+
+// An asynchronous log for messages that arrive on threads we don't control,
+// like the driver threads that call the validation layer's messenger callback.
+// push() copies the message into a fixed size, lock-free ring and returns
+// straight away; it never allocates, takes a lock or touches the terminal. A
+// logger thread drains the ring and does the printing.
+//
+// Identical messages are deduplicated: the first one is printed, and repeats
+// within REPEAT_WINDOW are only counted and summarized afterwards. On top of
+// that, at most MAX_LINES_PER_SECOND lines are printed per second.
+class debug_log_t
+{
+  public:
+    debug_log_t();
+    ~debug_log_t();
+
+    debug_log_t(const debug_log_t&) = delete;
+    auto operator=(const debug_log_t&) -> debug_log_t& = delete;
+
+    // Safe to call from any number of threads at once. Messages longer than
+    // MAX_MESSAGE_LENGTH are truncated, and if the ring is full the message is
+    // dropped and counted. Returns false in that case.
+    auto push(debug_log_severity_t p_severity, std::string_view p_message)
+        -> bool;
+
+  private:
+    static constexpr auto CAPACITY = std::size_t{256};
+    static constexpr auto MAX_MESSAGE_LENGTH = std::size_t{2048};
+    static constexpr auto REPEAT_WINDOW = std::chrono::seconds(1);
+    static constexpr auto MAX_LINES_PER_SECOND = std::uint32_t{20};
+    static constexpr auto IDLE_SLEEP = std::chrono::milliseconds(10);
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                  "The capacity has to be a power of two.");
+
+    // A slot is free for the producer claiming position p when its sequence
+    // is p, and holds a message for the consumer when it is p + 1.
+    struct slot_t
+    {
+        std::atomic<std::size_t> sequence;
+        debug_log_severity_t severity;
+        std::uint32_t length;
+        std::array<char, MAX_MESSAGE_LENGTH> text;
+    };
+
+    struct repeat_state_t
+    {
+        debug_log_severity_t severity;
+        std::chrono::steady_clock::time_point window_start;
+        std::uint64_t suppressed_count;
+    };
+
+    auto run() -> void;
+    auto pop(debug_log_severity_t& p_severity, std::string& p_message) -> bool;
+
+    // Only called from the logger thread.
+    auto handle(debug_log_severity_t p_severity, const std::string& p_message)
+        -> void;
+    auto flush_repeats(bool p_force) -> void;
+    auto print(debug_log_severity_t p_severity, std::string_view p_message)
+        -> void;
+
+    std::unique_ptr<slot_t[]> m_slots;
+    std::atomic<std::size_t> m_enqueue_position;
+    std::size_t m_dequeue_position;
+    std::atomic<std::uint64_t> m_dropped_count;
+
+    // Owned by the logger thread. Keyed by the message text.
+    std::unordered_map<std::string, repeat_state_t> m_repeats;
+    std::chrono::steady_clock::time_point m_rate_window_start;
+    std::uint32_t m_lines_in_rate_window;
+    std::uint64_t m_rate_limited_count;
+    std::uint64_t m_reported_dropped_count;
+
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "deletion_queue.hpp"
+
+auto deletion_queue_t::collect(std::uint64_t p_completed_value) -> std::size_t
+{
+    auto destroyed_count = std::size_t{0};
+
+    while (!m_entries.empty() &&
+           m_entries.front().last_used_value <= p_completed_value)
+    {
+        m_entries.pop_front();
+        destroyed_count++;
+    }
+
+    return destroyed_count;
+}
+
+auto deletion_queue_t::flush() -> void { m_entries.clear(); }
@@ -0,0 +1,66 @@
+#ifndef INCLUDED_DELETION_QUEUE_HPP
+#define INCLUDED_DELETION_QUEUE_HPP
+
+// Holds on to resources that have been replaced but that the GPU might still
+// be using, and destroys them once it's done, without ever idling the device.
+//
+// Every retired resource is tagged with the value of the last frame (or
+// timeline semaphore value) that used it. Once the caller knows that value
+// has completed, collect() destroys everything up to and including it. Any
+// move-only owner works, like a unique_handle_t or a std::unique_ptr to an
+// object that cleans up after itself.
+class deletion_queue_t
+{
+  public:
+    deletion_queue_t() = default;
+
+    // Destroys whatever is left. The caller has to make sure the GPU is idle
+    // by then.
+    ~deletion_queue_t() = default;
+
+    deletion_queue_t(const deletion_queue_t&) = delete;
+    auto operator=(const deletion_queue_t&) -> deletion_queue_t& = delete;
+
+    template <typename T>
+    auto retire(std::uint64_t p_last_used_value, T&& p_resource) -> void
+    {
+        m_entries.push_back(entry_t{
+            .last_used_value = p_last_used_value,
+            .resource = std::make_unique<holder_t<std::decay_t<T>>>(
+                std::forward<T>(p_resource))});
+    }
+
+    // Destroys every resource whose last use is at or before
+    // p_completed_value. Returns how many were destroyed.
+    auto collect(std::uint64_t p_completed_value) -> std::size_t;
+
+    // Destroys everything, regardless of when it was last used.
+    auto flush() -> void;
+
+    auto get_pending_count() const -> std::size_t { return m_entries.size(); }
+
+  private:
+    struct holder_base_t
+    {
+        virtual ~holder_base_t() = default;
+    };
+
+    template <typename T> struct holder_t : holder_base_t
+    {
+        explicit holder_t(T&& p_resource) : resource(std::move(p_resource)) {}
+
+        T resource;
+    };
+
+    struct entry_t
+    {
+        std::uint64_t last_used_value;
+        std::unique_ptr<holder_base_t> resource;
+    };
+
+    // Frames complete in order, so the entries are always sorted by
+    // last_used_value as long as they're retired in order too.
+    std::deque<entry_t> m_entries;
+};
+
+#endif
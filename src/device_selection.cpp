@@ -0,0 +1,248 @@
+#include "device_selection.hpp"
+
+namespace
+{
+
+constexpr auto MEBIBYTE = VkDeviceSize{1024 * 1024};
+
+auto to_lower(std::string_view p_string) -> std::string
+{
+    auto result = std::string(p_string);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char p_character) {
+                       return static_cast<char>(std::tolower(p_character));
+                   });
+    return result;
+}
+
+// Follows XDG_CACHE_HOME on Linux and LOCALAPPDATA on Windows, and falls back
+// to the temporary directory otherwise.
+auto get_cache_directory() -> std::filesystem::path
+{
+#ifdef _WIN32
+    if (const auto local_app_data = std::getenv("LOCALAPPDATA"))
+    {
+        return std::filesystem::path(local_app_data) / "vulkan-triangle";
+    }
+#else
+    if (const auto cache_home = std::getenv("XDG_CACHE_HOME"))
+    {
+        return std::filesystem::path(cache_home) / "vulkan-triangle";
+    }
+
+    if (const auto home = std::getenv("HOME"))
+    {
+        return std::filesystem::path(home) / ".cache" / "vulkan-triangle";
+    }
+#endif
+
+    auto error = std::error_code();
+    return std::filesystem::temp_directory_path(error) / "vulkan-triangle";
+}
+
+auto get_device_cache_path() -> std::filesystem::path
+{
+    return get_cache_directory() / "device_uuid";
+}
+
+auto parse_device_uuid(std::string_view p_text) -> std::optional<device_uuid_t>
+{
+    auto digits = std::string();
+    for (const auto character : p_text)
+    {
+        if (character != '-')
+        {
+            digits.push_back(character);
+        }
+    }
+
+    if (digits.size() != VK_UUID_SIZE * 2)
+    {
+        return std::nullopt;
+    }
+
+    auto uuid = device_uuid_t{};
+    for (auto i = std::size_t{0}; i < uuid.size(); i++)
+    {
+        const auto begin = digits.data() + i * 2;
+        const auto [pointer, error] =
+            std::from_chars(begin, begin + 2, uuid[i], 16);
+        if (error != std::errc() || pointer != begin + 2)
+        {
+            return std::nullopt;
+        }
+    }
+
+    return uuid;
+}
+
+} // namespace
+
+auto get_device_uuid(VkPhysicalDevice p_physical_device) -> device_uuid_t
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    auto uuid = device_uuid_t{};
+    if (device_properties.apiVersion < VK_API_VERSION_1_1)
+    {
+        return uuid;
+    }
+
+    auto id_properties = VkPhysicalDeviceIDProperties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext = nullptr,
+        .deviceUUID = {},
+        .driverUUID = {},
+        .deviceLUID = {},
+        .deviceNodeMask = 0,
+        .deviceLUIDValid = VK_FALSE};
+
+    auto properties = VkPhysicalDeviceProperties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &id_properties,
+        .properties = {}};
+    vkGetPhysicalDeviceProperties2(p_physical_device, &properties);
+
+    std::copy(std::begin(id_properties.deviceUUID),
+              std::end(id_properties.deviceUUID), uuid.begin());
+    return uuid;
+}
+
+auto format_device_uuid(const device_uuid_t& p_uuid) -> std::string
+{
+    auto result = std::string();
+    for (const auto byte : p_uuid)
+    {
+        result += fmt::format("{:02x}", byte);
+    }
+    return result;
+}
+
+auto score_physical_device(VkPhysicalDevice p_physical_device)
+    -> std::uint64_t
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    auto score = std::uint64_t{0};
+
+    switch (device_properties.deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        score += 10000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        score += 5000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        score += 2000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        score += 100;
+        break;
+    default:
+        break;
+    }
+
+    // One point per 16 MiB, capped at 32 GiB so that a huge shared heap on
+    // an integrated GPU can't outweigh the device type.
+    auto memory_properties = VkPhysicalDeviceMemoryProperties{};
+    vkGetPhysicalDeviceMemoryProperties(p_physical_device, &memory_properties);
+
+    auto largest_heap = VkDeviceSize{0};
+    for (auto i = std::uint32_t{0}; i < memory_properties.memoryHeapCount; i++)
+    {
+        const auto& heap = memory_properties.memoryHeaps[i];
+        if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            largest_heap = (std::max)(largest_heap, heap.size);
+        }
+    }
+    score += (std::min)(largest_heap / (16 * MEBIBYTE), VkDeviceSize{2048});
+
+    // Separate compute and transfer families usually mean separate hardware
+    // queues, which async compute and uploads can make use of.
+    auto queue_family_count = std::uint32_t{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device,
+                                             &queue_family_count, nullptr);
+
+    auto queue_families =
+        std::vector<VkQueueFamilyProperties>(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        p_physical_device, &queue_family_count, queue_families.data());
+
+    auto has_dedicated_compute = false;
+    auto has_dedicated_transfer = false;
+    for (const auto& queue_family : queue_families)
+    {
+        const auto flags = queue_family.queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            has_dedicated_compute = true;
+        }
+        else if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+                 !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            has_dedicated_transfer = true;
+        }
+    }
+    score += has_dedicated_compute ? 500 : 0;
+    score += has_dedicated_transfer ? 250 : 0;
+
+    const auto& limits = device_properties.limits;
+    score += limits.maxImageDimension2D / 1024;
+    score += limits.maxComputeWorkGroupInvocations / 128;
+
+    return score;
+}
+
+auto matches_device_override(VkPhysicalDevice p_physical_device,
+                             std::string_view p_override) -> bool
+{
+    const auto uuid = parse_device_uuid(p_override);
+    if (uuid.has_value())
+    {
+        return get_device_uuid(p_physical_device) == *uuid;
+    }
+
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    return to_lower(device_properties.deviceName).find(to_lower(p_override)) !=
+           std::string::npos;
+}
+
+auto load_cached_device_uuid() -> std::optional<device_uuid_t>
+{
+    auto file = std::ifstream(get_device_cache_path());
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    auto text = std::string();
+    file >> text;
+    return parse_device_uuid(text);
+}
+
+// Failing to write the cache only costs a rescan on the next launch, so it
+// isn't treated as an error.
+auto save_cached_device_uuid(const device_uuid_t& p_uuid) -> void
+{
+    const auto path = get_device_cache_path();
+
+    auto error = std::error_code();
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    auto file = std::ofstream(path, std::fstream::trunc);
+    if (!file.is_open())
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Failed to cache the chosen device in {}.\n",
+                   path.string());
+        return;
+    }
+
+    file << format_device_uuid(p_uuid) << '\n';
+}
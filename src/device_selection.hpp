@@ -0,0 +1,32 @@
+#ifndef INCLUDED_DEVICE_SELECTION_HPP
+#define INCLUDED_DEVICE_SELECTION_HPP
+
+// Identifies a physical device across runs, unlike the VkPhysicalDevice
+// handle or its index in the enumeration.
+using device_uuid_t = std::array<std::uint8_t, VK_UUID_SIZE>;
+
+// Returns all zeros on devices older than Vulkan 1.1, which can't report one.
+auto get_device_uuid(VkPhysicalDevice p_physical_device) -> device_uuid_t;
+
+// 32 lowercase hex digits, without any dashes.
+auto format_device_uuid(const device_uuid_t& p_uuid) -> std::string;
+
+// Higher is better. The device type dominates (discrete, then integrated,
+// virtual and CPU), followed by the size of the largest device local heap,
+// whether there are dedicated compute or transfer queue families, and a few
+// limits as tie breakers. This doesn't check whether the device is usable at
+// all; that depends on the surface.
+auto score_physical_device(VkPhysicalDevice p_physical_device)
+    -> std::uint64_t;
+
+// p_override is either a device UUID (case and dashes are ignored) or part of
+// the device name (case is ignored).
+auto matches_device_override(VkPhysicalDevice p_physical_device,
+                             std::string_view p_override) -> bool;
+
+// The UUID of the device picked by the last scored selection, if there is
+// one.
+auto load_cached_device_uuid() -> std::optional<device_uuid_t>;
+auto save_cached_device_uuid(const device_uuid_t& p_uuid) -> void;
+
+#endif
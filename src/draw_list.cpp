@@ -0,0 +1,211 @@
+#include "draw_list.hpp"
+
+namespace
+{
+
+constexpr auto KEY_BYTE_COUNT = std::size_t{8};
+
+using histogram_t = std::array<std::uint32_t, 256>;
+
+constexpr auto get_key_byte(std::uint64_t p_key, std::size_t p_byte)
+    -> std::size_t
+{
+    return static_cast<std::size_t>((p_key >> (p_byte * 8)) & 0xff);
+}
+
+} // namespace
+
+draw_list_t::draw_list_t()
+    : m_draws(), m_entries(), m_scratch_entries(), m_is_sorted(true),
+      m_pipeline_ids(), m_vertex_buffer_ids(), m_recorded_draw_count(0),
+      m_pipeline_bind_count(0), m_vertex_buffer_bind_count(0),
+      m_sort_times(), m_sort_pass_counts()
+{
+}
+
+auto draw_list_t::clear() -> void
+{
+    m_draws.clear();
+    m_entries.clear();
+    m_pipeline_ids.clear();
+    m_vertex_buffer_ids.clear();
+    m_is_sorted = true;
+}
+
+template <typename T>
+auto draw_list_t::get_state_id(std::unordered_map<T, std::uint16_t>& p_ids,
+                               T p_handle) -> std::uint16_t
+{
+    const auto [it, inserted] = p_ids.try_emplace(
+        p_handle, static_cast<std::uint16_t>(p_ids.size()));
+    if (inserted && p_ids.size() > MAX_STATE_COUNT)
+    {
+        fmt::print("[FATAL ERROR]: A draw list can't use more than {} "
+                   "pipelines or vertex buffers.\n",
+                   MAX_STATE_COUNT);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return it->second;
+}
+
+auto draw_list_t::add(VkPipeline p_pipeline, VkBuffer p_vertex_buffer,
+                      std::uint32_t p_vertex_count,
+                      const push_constants_t& p_push_constants,
+                      std::uint32_t p_order) -> void
+{
+    add_indexed(p_pipeline, p_vertex_buffer, VK_NULL_HANDLE, p_vertex_count,
+                p_push_constants, p_order);
+}
+
+auto draw_list_t::add_indexed(VkPipeline p_pipeline, VkBuffer p_vertex_buffer,
+                              VkBuffer p_index_buffer,
+                              std::uint32_t p_index_count,
+                              const push_constants_t& p_push_constants,
+                              std::uint32_t p_order) -> void
+{
+    const auto pipeline_id = get_state_id(m_pipeline_ids, p_pipeline);
+    const auto vertex_buffer_id =
+        get_state_id(m_vertex_buffer_ids, p_vertex_buffer);
+
+    const auto key = (static_cast<std::uint64_t>(pipeline_id) << 48) |
+                     (static_cast<std::uint64_t>(vertex_buffer_id) << 32) |
+                     p_order;
+
+    m_entries.push_back(sort_entry_t{
+        .key = key, .draw = static_cast<std::uint32_t>(m_draws.size())});
+    m_draws.push_back(draw_t{.pipeline = p_pipeline,
+                             .vertex_buffer = p_vertex_buffer,
+                             .index_buffer = p_index_buffer,
+                             .count = p_index_count,
+                             .push_constants = p_push_constants});
+    m_is_sorted = false;
+}
+
+auto draw_list_t::sort() -> void
+{
+    if (m_is_sorted)
+    {
+        return;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto count = m_entries.size();
+
+    // Every byte's histogram in a single pass over the keys.
+    auto histograms = std::array<histogram_t, KEY_BYTE_COUNT>();
+    for (const auto& entry : m_entries)
+    {
+        for (auto byte = std::size_t{0}; byte < KEY_BYTE_COUNT; byte++)
+        {
+            histograms[byte][get_key_byte(entry.key, byte)]++;
+        }
+    }
+
+    m_scratch_entries.resize(count);
+    auto pass_count = std::size_t{0};
+
+    for (auto byte = std::size_t{0}; byte < KEY_BYTE_COUNT; byte++)
+    {
+        // A byte that's the same in every key wouldn't move anything. With a
+        // handful of pipelines and buffers, that's most of them.
+        auto& histogram = histograms[byte];
+        if (histogram[get_key_byte(m_entries[0].key, byte)] == count)
+        {
+            continue;
+        }
+
+        auto offset = std::uint32_t{0};
+        for (auto& bucket : histogram)
+        {
+            const auto bucket_count = bucket;
+            bucket = offset;
+            offset += bucket_count;
+        }
+
+        for (const auto& entry : m_entries)
+        {
+            m_scratch_entries[histogram[get_key_byte(entry.key, byte)]++] =
+                entry;
+        }
+        std::swap(m_entries, m_scratch_entries);
+        pass_count++;
+    }
+
+    m_is_sorted = true;
+    m_sort_pass_counts.add(static_cast<double>(pass_count));
+    m_sort_times.add(std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count());
+}
+
+auto draw_list_t::record(VkCommandBuffer p_command_buffer,
+                         VkPipelineLayout p_pipeline_layout) -> VkPipeline
+{
+    sort();
+
+    auto bound_pipeline = static_cast<VkPipeline>(VK_NULL_HANDLE);
+    auto bound_vertex_buffer = static_cast<VkBuffer>(VK_NULL_HANDLE);
+    const auto offset = VkDeviceSize{0};
+
+    for (const auto& entry : m_entries)
+    {
+        const auto& draw = m_draws[entry.draw];
+
+        if (draw.pipeline != bound_pipeline)
+        {
+            vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              draw.pipeline);
+            bound_pipeline = draw.pipeline;
+            m_pipeline_bind_count++;
+        }
+
+        if (draw.vertex_buffer != bound_vertex_buffer)
+        {
+            vkCmdBindVertexBuffers(p_command_buffer, 0, 1, &draw.vertex_buffer,
+                                   &offset);
+            bound_vertex_buffer = draw.vertex_buffer;
+            m_vertex_buffer_bind_count++;
+
+            if (draw.index_buffer != VK_NULL_HANDLE)
+            {
+                vkCmdBindIndexBuffer(p_command_buffer, draw.index_buffer, 0,
+                                     VK_INDEX_TYPE_UINT32);
+            }
+        }
+
+        vkCmdPushConstants(p_command_buffer, p_pipeline_layout,
+                           VK_SHADER_STAGE_VERTEX_BIT, 0,
+                           sizeof(draw.push_constants), &draw.push_constants);
+        if (draw.index_buffer != VK_NULL_HANDLE)
+        {
+            vkCmdDrawIndexed(p_command_buffer, draw.count, 1, 0, 0, 0);
+        }
+        else
+        {
+            vkCmdDraw(p_command_buffer, draw.count, 1, 0, 0);
+        }
+    }
+
+    m_recorded_draw_count += m_entries.size();
+
+    return bound_pipeline;
+}
+
+auto draw_list_t::print_statistics() const -> void
+{
+    if (m_recorded_draw_count == 0)
+    {
+        return;
+    }
+
+    fmt::print("[INFO]: Recorded {} sorted draws with {} pipeline and {} "
+               "vertex buffer binds, skipping {} and {} redundant ones. "
+               "Sorting a list took {:.2f} us on average, with {:.1f} of {} "
+               "radix passes.\n",
+               m_recorded_draw_count, m_pipeline_bind_count,
+               m_vertex_buffer_bind_count,
+               m_recorded_draw_count - m_pipeline_bind_count,
+               m_recorded_draw_count - m_vertex_buffer_bind_count,
+               m_sort_times.mean, m_sort_pass_counts.mean, KEY_BYTE_COUNT);
+}
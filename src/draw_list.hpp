@@ -0,0 +1,108 @@
+#ifndef INCLUDED_DRAW_LIST_HPP
+#define INCLUDED_DRAW_LIST_HPP
+
+#include "running_statistics.hpp"
+#include "shader_interface.hpp"
+#include "vulkan_handle.hpp"
+
+// Collects a frame's draws, and records them sorted by the state they need, so
+// that each pipeline and vertex buffer is only bound once per run of draws
+// that share it. Indexed and non-indexed draws can share a list.
+//
+// Every draw gets a 64-bit key: the pipeline in the top 16 bits, the vertex
+// buffer in the next 16, and a caller chosen order in the low 32, which can be
+// a quantized depth, a material or just the submission order. Pipelines and
+// buffers are numbered in the order they first appear in the frame. The keys
+// are sorted with a least significant digit radix sort, a byte at a time,
+// skipping bytes that are the same in every key. It's stable, so draws with
+// equal keys keep the order they were added in.
+//
+// Sorting changes the order that overlapping draws blend or overwrite each
+// other in, across different states. Only draws whose order doesn't matter,
+// or that carry it in the low bits, should share a list.
+class draw_list_t
+{
+  public:
+    // Pipelines and vertex buffers are numbered in 16 bits.
+    static constexpr auto MAX_STATE_COUNT = std::size_t{65536};
+
+    draw_list_t();
+
+    draw_list_t(const draw_list_t&) = delete;
+    auto operator=(const draw_list_t&) -> draw_list_t& = delete;
+
+    auto clear() -> void;
+
+    // Draws the first p_vertex_count vertices of p_vertex_buffer, as a
+    // triangle list.
+    auto add(VkPipeline p_pipeline, VkBuffer p_vertex_buffer,
+             std::uint32_t p_vertex_count,
+             const push_constants_t& p_push_constants, std::uint32_t p_order)
+        -> void;
+
+    // Draws p_index_count 32-bit indices from p_index_buffer into
+    // p_vertex_buffer, as a triangle list. A vertex buffer has to always be
+    // drawn with the same index buffer, since it's only bound along with it.
+    auto add_indexed(VkPipeline p_pipeline, VkBuffer p_vertex_buffer,
+                     VkBuffer p_index_buffer, std::uint32_t p_index_count,
+                     const push_constants_t& p_push_constants,
+                     std::uint32_t p_order) -> void;
+
+    auto size() const -> std::size_t { return m_draws.size(); }
+
+    // Only needed once per frame. record() sorts the list itself if nothing
+    // was added since the last sort.
+    auto sort() -> void;
+
+    // Records every draw in key order, skipping binds that wouldn't change
+    // anything. The descriptor sets, viewport and scissor have to be set up
+    // already, and all of the pipelines have to share p_pipeline_layout.
+    // Returns the pipeline left bound, VK_NULL_HANDLE for an empty list.
+    auto record(VkCommandBuffer p_command_buffer,
+                VkPipelineLayout p_pipeline_layout) -> VkPipeline;
+
+    auto print_statistics() const -> void;
+
+  private:
+    struct draw_t
+    {
+        VkPipeline pipeline;
+        VkBuffer vertex_buffer;
+
+        // VK_NULL_HANDLE for a non-indexed draw.
+        VkBuffer index_buffer;
+
+        // Vertices, or indices for an indexed draw.
+        std::uint32_t count;
+
+        push_constants_t push_constants;
+    };
+
+    struct sort_entry_t
+    {
+        std::uint64_t key;
+        std::uint32_t draw;
+    };
+
+    template <typename T>
+    static auto get_state_id(std::unordered_map<T, std::uint16_t>& p_ids,
+                             T p_handle) -> std::uint16_t;
+
+    std::vector<draw_t> m_draws;
+    std::vector<sort_entry_t> m_entries;
+    std::vector<sort_entry_t> m_scratch_entries;
+    bool m_is_sorted;
+
+    std::unordered_map<VkPipeline, std::uint16_t> m_pipeline_ids;
+    std::unordered_map<VkBuffer, std::uint16_t> m_vertex_buffer_ids;
+
+    std::uint64_t m_recorded_draw_count;
+    std::uint64_t m_pipeline_bind_count;
+    std::uint64_t m_vertex_buffer_bind_count;
+
+    // In microseconds, and the number of byte passes each sort needed.
+    running_statistics_t m_sort_times;
+    running_statistics_t m_sort_pass_counts;
+};
+
+#endif
@@ -0,0 +1,262 @@
+#include "frame_pacer.hpp"
+
+namespace
+{
+
+// How long each sleep slice asks for. Short enough that overshooting it
+// doesn't matter much, long enough that the thread really goes idle.
+constexpr auto SLEEP_SLICE = std::chrono::milliseconds(1);
+
+// Added to the work estimate in low latency mode, to absorb the odd slow
+// frame without missing the deadline.
+constexpr auto LOW_LATENCY_MARGIN = 0.001;
+
+// Weight of the latest frame in the work estimate.
+constexpr auto WORK_ESTIMATE_WEIGHT = 0.1;
+
+// How long low latency mode waits for the previous frame to be displayed
+// before giving up on it, in nanoseconds.
+constexpr auto PRESENT_WAIT_TIMEOUT = std::uint64_t{100'000'000};
+
+// The CPU time used by every thread in the process so far, in seconds.
+auto get_process_cpu_time() -> double
+{
+#ifdef _WIN32
+    auto creation_time = FILETIME{};
+    auto exit_time = FILETIME{};
+    auto kernel_time = FILETIME{};
+    auto user_time = FILETIME{};
+    GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time,
+                    &kernel_time, &user_time);
+
+    const auto to_ticks = [](const FILETIME& p_time) {
+        return (static_cast<std::uint64_t>(p_time.dwHighDateTime) << 32) |
+               p_time.dwLowDateTime;
+    };
+
+    // FILETIME counts in 100 ns ticks.
+    return static_cast<double>(to_ticks(kernel_time) + to_ticks(user_time)) *
+           1e-7;
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+auto to_seconds(std::chrono::steady_clock::duration p_duration) -> double
+{
+    return std::chrono::duration<double>(p_duration).count();
+}
+
+} // namespace
+
+frame_pacer_t::frame_pacer_t(std::uint32_t p_target_fps, bool p_low_latency,
+                             VkDevice p_device,
+                             PFN_vkWaitForPresentKHR p_wait_for_present)
+    : m_period(p_target_fps > 0
+                   ? std::optional(
+                         std::chrono::duration_cast<clock_t::duration>(
+                             std::chrono::duration<double>(1.0 / p_target_fps)))
+                   : std::nullopt),
+      m_low_latency(p_low_latency), m_device(p_device),
+      m_wait_for_present(p_wait_for_present), m_deadline(clock_t::now()),
+      m_sleep_slices(), m_work_estimate(0.0), m_input_sampling_time(),
+      m_next_present_id(1), m_completed_present_id(0), m_last_present_time(),
+      m_start_time(clock_t::now()), m_start_cpu_time(get_process_cpu_time()),
+      m_last_frame_start(), m_frame_times(), m_present_intervals(),
+      m_sleep_time(clock_t::duration::zero()),
+      m_spin_time(clock_t::duration::zero())
+{
+}
+
+auto frame_pacer_t::begin_frame() -> void
+{
+    if (m_period.has_value() && !m_low_latency)
+    {
+        sleep_until(m_deadline);
+        advance_deadline(clock_t::now());
+    }
+
+    const auto now = clock_t::now();
+    if (m_last_frame_start.has_value())
+    {
+        m_frame_times.add(to_seconds(now - *m_last_frame_start));
+    }
+    m_last_frame_start = now;
+}
+
+auto frame_pacer_t::wait_for_input_sampling(VkSwapchainKHR p_swap_chain)
+    -> void
+{
+    if (m_low_latency)
+    {
+        // Sampling input while the previous frame is still queued for the
+        // display would only make it older by the time it's shown.
+        if (m_wait_for_present != nullptr &&
+            m_completed_present_id + 1 < m_next_present_id)
+        {
+            poll_presents(p_swap_chain, PRESENT_WAIT_TIMEOUT);
+        }
+
+        if (m_period.has_value())
+        {
+            const auto work_estimate =
+                std::chrono::duration_cast<clock_t::duration>(
+                    std::chrono::duration<double>(m_work_estimate +
+                                                  LOW_LATENCY_MARGIN));
+            sleep_until(m_deadline - work_estimate);
+            advance_deadline(clock_t::now() + work_estimate);
+        }
+    }
+
+    m_input_sampling_time = clock_t::now();
+}
+
+auto frame_pacer_t::get_present_id() const -> std::uint64_t
+{
+    return m_wait_for_present != nullptr ? m_next_present_id : 0;
+}
+
+auto frame_pacer_t::end_frame(VkSwapchainKHR p_swap_chain) -> void
+{
+    const auto work_time = to_seconds(clock_t::now() - m_input_sampling_time);
+    m_work_estimate = m_work_estimate == 0.0
+                          ? work_time
+                          : m_work_estimate +
+                                WORK_ESTIMATE_WEIGHT *
+                                    (work_time - m_work_estimate);
+
+    if (m_wait_for_present != nullptr)
+    {
+        m_next_present_id++;
+
+        // Outside of low latency mode, presents are only checked once per
+        // frame, so the intervals are only as precise as the frame rate.
+        if (!m_low_latency)
+        {
+            poll_presents(p_swap_chain, 0);
+        }
+    }
+}
+
+auto frame_pacer_t::print_statistics() const -> void
+{
+    const auto wall_time = to_seconds(clock_t::now() - m_start_time);
+    if (m_frame_times.count == 0 || wall_time <= 0.0)
+    {
+        return;
+    }
+
+    const auto cpu_time = get_process_cpu_time() - m_start_cpu_time;
+
+    fmt::print("[INFO]: Frame pacing: {}{}. Frame time {:.3f} ms on "
+               "average, {:.3f} ms standard deviation, {:.3f} to {:.3f} ms.\n",
+               m_period.has_value()
+                   ? fmt::format("limited to {:.1f} fps",
+                                 1.0 / to_seconds(*m_period))
+                   : std::string("unlimited"),
+               m_low_latency ? ", low latency mode" : "",
+               m_frame_times.mean * 1000.0,
+               m_frame_times.get_standard_deviation() * 1000.0,
+               m_frame_times.min * 1000.0, m_frame_times.max * 1000.0);
+
+    fmt::print("[INFO]: The process used {:.1f}% of a core. The pacer slept "
+               "for {:.1f}% of the time and spun for {:.1f}%.\n",
+               cpu_time / wall_time * 100.0,
+               to_seconds(m_sleep_time) / wall_time * 100.0,
+               to_seconds(m_spin_time) / wall_time * 100.0);
+
+    if (m_present_intervals.count > 0)
+    {
+        fmt::print("[INFO]: Measured {} presents with VK_KHR_present_wait. "
+                   "Interval {:.3f} ms on average, {:.3f} ms standard "
+                   "deviation.\n",
+                   m_present_intervals.count + 1,
+                   m_present_intervals.mean * 1000.0,
+                   m_present_intervals.get_standard_deviation() * 1000.0);
+    }
+}
+
+auto frame_pacer_t::sleep_until(clock_t::time_point p_deadline) -> void
+{
+    const auto sleep_start = clock_t::now();
+
+    // Keep sleeping while the remaining time comfortably covers a typical
+    // slice plus the typical overshoot.
+    auto now = sleep_start;
+    while (true)
+    {
+        const auto expected_slice = std::chrono::duration<double>(
+            m_sleep_slices.count > 0
+                ? m_sleep_slices.mean +
+                      m_sleep_slices.get_standard_deviation()
+                : to_seconds(SLEEP_SLICE));
+
+        if (p_deadline - now <= expected_slice)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(SLEEP_SLICE);
+
+        const auto slice_end = clock_t::now();
+        m_sleep_slices.add(to_seconds(slice_end - now));
+        now = slice_end;
+    }
+
+    const auto spin_start = now;
+    while (now < p_deadline)
+    {
+        std::this_thread::yield();
+        now = clock_t::now();
+    }
+
+    m_sleep_time += spin_start - sleep_start;
+    m_spin_time += now - spin_start;
+}
+
+// Frames that fall more than a period behind don't try to catch up, since
+// that would just render a burst of frames back to back.
+auto frame_pacer_t::advance_deadline(clock_t::time_point p_now) -> void
+{
+    m_deadline += *m_period;
+    if (m_deadline < p_now)
+    {
+        m_deadline = p_now + *m_period;
+    }
+}
+
+// Waits up to p_timeout nanoseconds for each present that hasn't completed
+// yet, and records when it did.
+auto frame_pacer_t::poll_presents(VkSwapchainKHR p_swap_chain,
+                                  std::uint64_t p_timeout) -> void
+{
+    while (m_completed_present_id + 1 < m_next_present_id)
+    {
+        const auto present_id = m_completed_present_id + 1;
+        const auto result =
+            m_wait_for_present(m_device, p_swap_chain, present_id, p_timeout);
+
+        if (result == VK_TIMEOUT)
+        {
+            return;
+        }
+
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        {
+            fmt::print(fmt::fg(fmt::color::yellow),
+                       "[WARNING]: vkWaitForPresentKHR failed with Vulkan "
+                       "error {}. No longer measuring presents.\n",
+                       result);
+            m_wait_for_present = nullptr;
+            return;
+        }
+
+        const auto now = clock_t::now();
+        if (m_last_present_time.has_value())
+        {
+            m_present_intervals.add(to_seconds(now - *m_last_present_time));
+        }
+        m_last_present_time = now;
+        m_completed_present_id = present_id;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef INCLUDED_FRAME_PACER_HPP
+#define INCLUDED_FRAME_PACER_HPP
+
+#include "running_statistics.hpp"
+
+// Decides when the main loop starts each frame.
+//
+// With a target frame rate, every frame gets a deadline one period after the
+// last. The pacer sleeps in short slices until it's within its estimate of how
+// much the OS oversleeps, then spins for the rest, which is both accurate and
+// leaves the core idle for most of the wait.
+//
+// In low latency mode, the wait moves from the start of the frame to just
+// before input is sampled, and is shortened by how long the CPU is expected
+// to take from there to present. If VK_KHR_present_wait is available, it also
+// waits for the previous frame to actually reach the screen, so that frames
+// never queue up behind the display.
+//
+// Present ids are attached to every present when the extension is available,
+// which lets the pacer report how regularly frames were really displayed
+// rather than how regularly they were submitted.
+class frame_pacer_t
+{
+  public:
+    // A p_target_fps of 0 means no limit. p_wait_for_present is nullptr if
+    // VK_KHR_present_wait isn't enabled.
+    frame_pacer_t(std::uint32_t p_target_fps, bool p_low_latency,
+                  VkDevice p_device,
+                  PFN_vkWaitForPresentKHR p_wait_for_present);
+
+    frame_pacer_t(const frame_pacer_t&) = delete;
+    auto operator=(const frame_pacer_t&) -> frame_pacer_t& = delete;
+
+    // Called at the top of the main loop, before waiting for the previous
+    // frame's fence.
+    auto begin_frame() -> void;
+
+    // Called right before input is polled and the frame is recorded.
+    auto wait_for_input_sampling(VkSwapchainKHR p_swap_chain) -> void;
+
+    // The id to pass in VkPresentIdKHR for this frame's present, or 0 if
+    // present ids aren't in use.
+    auto get_present_id() const -> std::uint64_t;
+
+    // Called after the frame has been presented.
+    auto end_frame(VkSwapchainKHR p_swap_chain) -> void;
+
+    auto print_statistics() const -> void;
+
+  private:
+    using clock_t = std::chrono::steady_clock;
+
+    auto sleep_until(clock_t::time_point p_deadline) -> void;
+    auto advance_deadline(clock_t::time_point p_now) -> void;
+    auto poll_presents(VkSwapchainKHR p_swap_chain, std::uint64_t p_timeout)
+        -> void;
+
+    std::optional<clock_t::duration> m_period;
+    bool m_low_latency;
+
+    VkDevice m_device;
+    PFN_vkWaitForPresentKHR m_wait_for_present;
+
+    clock_t::time_point m_deadline;
+
+    // How long sleep slices really take, and how long the CPU takes from
+    // sampling input to presenting, both in seconds.
+    running_statistics_t m_sleep_slices;
+    double m_work_estimate;
+    clock_t::time_point m_input_sampling_time;
+
+    std::uint64_t m_next_present_id;
+    std::uint64_t m_completed_present_id;
+    std::optional<clock_t::time_point> m_last_present_time;
+
+    // For the statistics printed on exit.
+    clock_t::time_point m_start_time;
+    double m_start_cpu_time;
+    std::optional<clock_t::time_point> m_last_frame_start;
+    running_statistics_t m_frame_times;
+    running_statistics_t m_present_intervals;
+    clock_t::duration m_sleep_time;
+    clock_t::duration m_spin_time;
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "geometry_generator.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+// Matches local_size_x in geometry.comp.
+constexpr auto WORKGROUP_SIZE = std::uint32_t{64};
+
+// Each particle is drawn as a single triangle.
+constexpr auto VERTICES_PER_PARTICLE = std::uint32_t{3};
+
+// Matches the push_constant block in geometry.comp.
+struct generator_push_constants_t
+{
+    float time;
+    std::uint32_t particle_count;
+};
+
+auto create_descriptor_set_layout(VkDevice p_device)
+    -> unique_descriptor_set_layout_t
+{
+    const auto bindings = std::array<VkDescriptorSetLayoutBinding, 2>{
+        VkDescriptorSetLayoutBinding{
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr},
+        VkDescriptorSetLayoutBinding{
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr}};
+
+    const auto create_info = VkDescriptorSetLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings = bindings.data()};
+
+    auto layout = static_cast<VkDescriptorSetLayout>(VK_NULL_HANDLE);
+    const auto result =
+        vkCreateDescriptorSetLayout(p_device, &create_info, nullptr, &layout);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the geometry generator's "
+                   "descriptor set layout. Vulkan error {}.\n",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return unique_descriptor_set_layout_t(layout, {p_device});
+}
+
+// Return values
+// - descriptor pool
+// - p_count descriptor sets, allocated from the pool
+auto create_descriptor_sets(VkDevice p_device, VkDescriptorSetLayout p_layout,
+                            std::uint32_t p_count)
+    -> std::tuple<unique_descriptor_pool_t, std::vector<VkDescriptorSet>>
+{
+    const auto pool_size =
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                             .descriptorCount = 2 * p_count};
+
+    const auto pool_create_info = VkDescriptorPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = p_count,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size};
+
+    auto pool = static_cast<VkDescriptorPool>(VK_NULL_HANDLE);
+    const auto pool_result =
+        vkCreateDescriptorPool(p_device, &pool_create_info, nullptr, &pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the geometry generator's "
+                   "descriptor pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto layouts = std::vector<VkDescriptorSetLayout>(p_count, p_layout);
+    const auto allocate_info = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = pool,
+        .descriptorSetCount = p_count,
+        .pSetLayouts = layouts.data()};
+
+    auto sets = std::vector<VkDescriptorSet>(p_count);
+    const auto allocate_result =
+        vkAllocateDescriptorSets(p_device, &allocate_info, sets.data());
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the geometry generator's "
+                   "descriptor sets. Vulkan error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return {unique_descriptor_pool_t(pool, {p_device}), std::move(sets)};
+}
+
+auto create_compute_pipeline(VkDevice p_device, VkShaderModule p_shader_module,
+                             VkPipelineCache p_pipeline_cache,
+                             VkPipelineLayout p_layout) -> unique_pipeline_t
+{
+    const auto create_info = VkComputePipelineCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .stage =
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = p_shader_module,
+                .pName = "main",
+                .pSpecializationInfo = nullptr},
+        .layout = p_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1};
+
+    auto pipeline = static_cast<VkPipeline>(VK_NULL_HANDLE);
+    const auto result = vkCreateComputePipelines(
+        p_device, p_pipeline_cache, 1, &create_info, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the geometry generator's "
+                   "compute pipeline. Vulkan error {}.\n",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return unique_pipeline_t(pipeline, {p_device});
+}
+
+} // namespace
+
+geometry_generator_t::geometry_generator_t(VkPhysicalDevice p_physical_device,
+                                           VkDevice p_device,
+                                           VkShaderModule p_shader_module,
+                                           VkPipelineCache p_pipeline_cache,
+                                           std::uint32_t p_particle_count,
+                                           VkDeviceSize p_vertex_size,
+                                           std::uint32_t p_slot_count,
+                                           const std::vector<std::uint32_t>&
+                                               p_queue_families)
+    : m_particle_count(p_particle_count)
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    // The dispatch is one dimensional, so the workgroup count limit caps the
+    // number of particles.
+    const auto max_particle_count =
+        static_cast<std::uint64_t>(
+            device_properties.limits.maxComputeWorkGroupCount[0]) *
+        WORKGROUP_SIZE;
+    if (m_particle_count > max_particle_count)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The device can only generate {} particles in a "
+                   "single dispatch, not {}.\n",
+                   max_particle_count, m_particle_count);
+        m_particle_count = static_cast<std::uint32_t>(max_particle_count);
+    }
+
+    m_descriptor_set_layout = create_descriptor_set_layout(p_device);
+    auto [descriptor_pool, descriptor_sets] = create_descriptor_sets(
+        p_device, m_descriptor_set_layout.get(), p_slot_count);
+    m_descriptor_pool = std::move(descriptor_pool);
+
+    for (const auto descriptor_set : descriptor_sets)
+    {
+        auto slot = slot_t{.vertex_buffer = {},
+                           .vertex_buffer_memory = {},
+                           .draw_command_buffer = {},
+                           .draw_command_buffer_memory = {},
+                           .descriptor_set = descriptor_set};
+
+        // Written by the compute shader, then read as vertices. Nothing on
+        // the CPU ever touches it, so it can live in device local memory.
+        std::tie(slot.vertex_buffer, slot.vertex_buffer_memory) =
+            create_buffer(p_physical_device, p_device,
+                          static_cast<VkDeviceSize>(m_particle_count) *
+                              VERTICES_PER_PARTICLE * p_vertex_size,
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                          p_queue_families);
+
+        // Reset with vkCmdUpdateBuffer at the start of every dispatch, then
+        // counted up by the shader.
+        std::tie(slot.draw_command_buffer, slot.draw_command_buffer_memory) =
+            create_buffer(p_physical_device, p_device,
+                          sizeof(VkDrawIndirectCommand),
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                              VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                          p_queue_families);
+
+        const auto buffer_infos = std::array<VkDescriptorBufferInfo, 2>{
+            VkDescriptorBufferInfo{.buffer = slot.vertex_buffer.get(),
+                                   .offset = 0,
+                                   .range = VK_WHOLE_SIZE},
+            VkDescriptorBufferInfo{.buffer = slot.draw_command_buffer.get(),
+                                   .offset = 0,
+                                   .range = VK_WHOLE_SIZE}};
+
+        const auto write = VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptor_set,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = static_cast<std::uint32_t>(buffer_infos.size()),
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = buffer_infos.data(),
+            .pTexelBufferView = nullptr};
+
+        vkUpdateDescriptorSets(p_device, 1, &write, 0, nullptr);
+
+        m_slots.push_back(std::move(slot));
+    }
+
+    const auto push_constant_range =
+        VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                            .offset = 0,
+                            .size = sizeof(generator_push_constants_t)};
+
+    const auto layout_create_info = VkPipelineLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount = 1,
+        .pSetLayouts = m_descriptor_set_layout.get_address(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range};
+
+    auto pipeline_layout = static_cast<VkPipelineLayout>(VK_NULL_HANDLE);
+    const auto layout_result = vkCreatePipelineLayout(
+        p_device, &layout_create_info, nullptr, &pipeline_layout);
+    if (layout_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the geometry generator's "
+                   "pipeline layout. Vulkan error {}.\n",
+                   layout_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_pipeline_layout = unique_pipeline_layout_t(pipeline_layout, {p_device});
+
+    m_pipeline =
+        create_compute_pipeline(p_device, p_shader_module, p_pipeline_cache,
+                                m_pipeline_layout.get());
+}
+
+auto geometry_generator_t::record_reset(VkCommandBuffer p_command_buffer,
+                                        std::uint32_t p_slot) const -> void
+{
+    const auto empty_draw = VkDrawIndirectCommand{
+        .vertexCount = 0, .instanceCount = 1, .firstVertex = 0,
+        .firstInstance = 0};
+    vkCmdUpdateBuffer(p_command_buffer,
+                      m_slots[p_slot].draw_command_buffer.get(), 0,
+                      sizeof(empty_draw), &empty_draw);
+}
+
+auto geometry_generator_t::record_dispatch(VkCommandBuffer p_command_buffer,
+                                           std::uint32_t p_slot,
+                                           float p_time) const -> void
+{
+    vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      m_pipeline.get());
+    vkCmdBindDescriptorSets(p_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            m_pipeline_layout.get(), 0, 1,
+                            &m_slots[p_slot].descriptor_set, 0, nullptr);
+
+    const auto push_constants = generator_push_constants_t{
+        .time = p_time, .particle_count = m_particle_count};
+    vkCmdPushConstants(p_command_buffer, m_pipeline_layout.get(),
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants),
+                       &push_constants);
+
+    vkCmdDispatch(p_command_buffer,
+                  (m_particle_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1,
+                  1);
+}
+
+auto geometry_generator_t::record_draw(VkCommandBuffer p_command_buffer,
+                                       std::uint32_t p_slot) const -> void
+{
+    const auto& slot = m_slots[p_slot];
+    const auto offset = static_cast<VkDeviceSize>(0);
+    vkCmdBindVertexBuffers(p_command_buffer, 0, 1,
+                           slot.vertex_buffer.get_address(), &offset);
+    vkCmdDrawIndirect(p_command_buffer, slot.draw_command_buffer.get(), 0, 1,
+                      sizeof(VkDrawIndirectCommand));
+}
+
+auto geometry_generator_t::get_vertex_buffer(std::uint32_t p_slot) const
+    -> VkBuffer
+{
+    return m_slots[p_slot].vertex_buffer.get();
+}
+
+auto geometry_generator_t::get_draw_command_buffer(std::uint32_t p_slot) const
+    -> VkBuffer
+{
+    return m_slots[p_slot].draw_command_buffer.get();
+}
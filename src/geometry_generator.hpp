@@ -0,0 +1,71 @@
+#ifndef INCLUDED_GEOMETRY_GENERATOR_HPP
+#define INCLUDED_GEOMETRY_GENERATOR_HPP
+
+#include "vulkan_handle.hpp"
+
+// Generates particle triangles on the GPU every frame. A compute shader writes
+// vertex_t records straight into a device local buffer that is also bound as a
+// vertex buffer, and counts the vertices it wrote into a
+// VkDrawIndirectCommand, so the CPU never uploads or even knows how much
+// geometry there is.
+//
+// There are p_slot_count independent sets of buffers, so that one set can be
+// generated while another is drawn. Every method takes the slot to work on.
+class geometry_generator_t
+{
+  public:
+    // p_shader_module is only used during construction, so the caller can
+    // destroy it straight afterwards. p_vertex_size has to match the stride
+    // that geometry.comp writes with. p_queue_families lists every queue
+    // family that uses the buffers, which are shared between them if there's
+    // more than one.
+    geometry_generator_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                         VkShaderModule p_shader_module,
+                         VkPipelineCache p_pipeline_cache,
+                         std::uint32_t p_particle_count,
+                         VkDeviceSize p_vertex_size, std::uint32_t p_slot_count,
+                         const std::vector<std::uint32_t>& p_queue_families);
+
+    geometry_generator_t(const geometry_generator_t&) = delete;
+    auto operator=(const geometry_generator_t&) -> geometry_generator_t& =
+                                                       delete;
+
+    // Records the transfer that zeroes the vertex count. It has to be made
+    // visible to the dispatch, which reads and writes the draw command buffer.
+    auto record_reset(VkCommandBuffer p_command_buffer,
+                      std::uint32_t p_slot) const -> void;
+
+    // Records the dispatch. Its writes to both buffers have to be made
+    // visible to vertex input and indirect draws before record_draw(). This
+    // has to be recorded outside of a render pass.
+    auto record_dispatch(VkCommandBuffer p_command_buffer, std::uint32_t p_slot,
+                         float p_time) const -> void;
+
+    // Records the indirect draw. The graphics pipeline and anything else it
+    // needs have to be bound already.
+    auto record_draw(VkCommandBuffer p_command_buffer,
+                     std::uint32_t p_slot) const -> void;
+
+    auto get_vertex_buffer(std::uint32_t p_slot) const -> VkBuffer;
+    auto get_draw_command_buffer(std::uint32_t p_slot) const -> VkBuffer;
+
+  private:
+    struct slot_t
+    {
+        unique_buffer_t vertex_buffer;
+        unique_device_memory_t vertex_buffer_memory;
+        unique_buffer_t draw_command_buffer;
+        unique_device_memory_t draw_command_buffer_memory;
+        VkDescriptorSet descriptor_set;
+    };
+
+    std::uint32_t m_particle_count;
+
+    unique_descriptor_set_layout_t m_descriptor_set_layout;
+    unique_descriptor_pool_t m_descriptor_pool;
+    std::vector<slot_t> m_slots;
+    unique_pipeline_layout_t m_pipeline_layout;
+    unique_pipeline_t m_pipeline;
+};
+
+#endif
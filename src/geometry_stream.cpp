@@ -0,0 +1,461 @@
+#include "geometry_stream.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+constexpr auto TRIANGLE_SIZE = std::uint64_t{3 * sizeof(vertex_t)};
+
+auto get_milliseconds_since(std::chrono::steady_clock::time_point p_start)
+    -> double
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - p_start)
+        .count();
+}
+
+} // namespace
+
+geometry_stream_t::geometry_stream_t(VkPhysicalDevice p_physical_device,
+                                     VkDevice p_device, VkQueue p_queue,
+                                     std::uint32_t p_queue_family,
+                                     const std::filesystem::path& p_path,
+                                     std::uint32_t p_chunk_triangle_count,
+                                     std::uint32_t p_buffer_count)
+    : m_device(p_device), m_queue(p_queue), m_path(p_path),
+#ifdef _WIN32
+      m_file(INVALID_HANDLE_VALUE), m_file_mapping(nullptr),
+#elif defined(__linux__)
+      m_fd(-1),
+#else
+      m_file(),
+#endif
+      m_triangle_count(0), m_chunk_triangle_count(0), m_chunk_count(0),
+      m_command_pool(), m_slots(), m_next_number(1), m_completed_number(0),
+      m_read_times(), m_wait_times(), m_streamed_bytes(0)
+{
+    auto error = std::error_code();
+    const auto file_size = std::filesystem::file_size(p_path, error);
+    if (error)
+    {
+        fmt::print("[FATAL ERROR]: Failed to read the size of {}: {}.\n",
+                   p_path.string(), error.message());
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_triangle_count = file_size / TRIANGLE_SIZE;
+    if (m_triangle_count == 0)
+    {
+        fmt::print("[FATAL ERROR]: {} doesn't hold a single triangle.\n",
+                   p_path.string());
+        std::exit(EXIT_FAILURE);
+    }
+    if (file_size % TRIANGLE_SIZE != 0)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: {} ends in {} bytes that don't make up a whole "
+                   "triangle. They're ignored.\n",
+                   p_path.string(), file_size % TRIANGLE_SIZE);
+    }
+
+    // Rounded up to the granularity, but no bigger than the file needs.
+    const auto granules =
+        (std::clamp(p_chunk_triangle_count, std::uint32_t{1},
+                    MAX_CHUNK_TRIANGLE_COUNT) +
+         TRIANGLE_GRANULARITY - 1) /
+        TRIANGLE_GRANULARITY;
+    const auto file_granules =
+        (m_triangle_count + TRIANGLE_GRANULARITY - 1) / TRIANGLE_GRANULARITY;
+    m_chunk_triangle_count =
+        static_cast<std::uint32_t>((std::min)(
+            static_cast<std::uint64_t>(granules), file_granules)) *
+        TRIANGLE_GRANULARITY;
+    m_chunk_count = (m_triangle_count + m_chunk_triangle_count - 1) /
+                    m_chunk_triangle_count;
+
+    open_file(p_path);
+
+    const auto pool_create_info = VkCommandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = p_queue_family};
+
+    auto command_pool = static_cast<VkCommandPool>(VK_NULL_HANDLE);
+    const auto pool_result = vkCreateCommandPool(p_device, &pool_create_info,
+                                                 nullptr, &command_pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the geometry stream's "
+                   "command pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_command_pool = unique_command_pool_t(command_pool, {p_device});
+
+    const auto buffer_count =
+        std::clamp(p_buffer_count, MIN_BUFFER_COUNT, MAX_BUFFER_COUNT);
+
+    // Freed along with the pool.
+    auto command_buffers = std::vector<VkCommandBuffer>(buffer_count);
+    const auto allocate_info = VkCommandBufferAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = buffer_count};
+
+    const auto allocate_result = vkAllocateCommandBuffers(
+        p_device, &allocate_info, command_buffers.data());
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the geometry stream's "
+                   "command buffers. Vulkan error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Created signaled, so that the first wait on each slot returns straight
+    // away.
+    const auto fence_create_info =
+        VkFenceCreateInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                          .pNext = nullptr,
+                          .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+
+    const auto chunk_size =
+        static_cast<VkDeviceSize>(m_chunk_triangle_count) * TRIANGLE_SIZE;
+
+    for (const auto command_buffer : command_buffers)
+    {
+        auto [staging_buffer, staging_memory] = create_buffer(
+            p_physical_device, p_device, chunk_size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        // Unmapped when the memory is freed.
+        auto staging_data = static_cast<void*>(nullptr);
+        vkMapMemory(p_device, staging_memory.get(), 0, chunk_size, 0,
+                    &staging_data);
+
+        auto [vertex_buffer, vertex_memory] = create_buffer(
+            p_physical_device, p_device, chunk_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        auto fence = static_cast<VkFence>(VK_NULL_HANDLE);
+        const auto fence_result =
+            vkCreateFence(p_device, &fence_create_info, nullptr, &fence);
+        if (fence_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create a geometry stream "
+                       "fence. Vulkan error {}.\n",
+                       fence_result);
+            std::exit(EXIT_FAILURE);
+        }
+
+        m_slots.push_back(
+            slot_t{.staging_buffer = std::move(staging_buffer),
+                   .staging_memory = std::move(staging_memory),
+                   .staging_data = static_cast<std::byte*>(staging_data),
+                   .vertex_buffer = std::move(vertex_buffer),
+                   .vertex_memory = std::move(vertex_memory),
+                   .command_buffer = command_buffer,
+                   .fence = unique_fence_t(fence, {p_device}),
+                   .number = 0});
+    }
+
+    fmt::print("[INFO]: Streaming {} triangles from {} in {} chunks of {} "
+               "triangles, through {} buffers of {:.1f} MB.\n",
+               m_triangle_count, p_path.string(), m_chunk_count,
+               m_chunk_triangle_count, buffer_count,
+               static_cast<double>(chunk_size) / 1e6);
+}
+
+geometry_stream_t::~geometry_stream_t()
+{
+    wait_idle();
+    close_file();
+}
+
+auto geometry_stream_t::begin_chunk(std::uint64_t p_index)
+    -> geometry_stream_chunk_t
+{
+    const auto number = m_next_number++;
+    const auto slot_index = static_cast<std::uint32_t>(number % m_slots.size());
+    auto& slot = m_slots[slot_index];
+
+    // Only the slot's own previous chunk has to be done. Anything submitted
+    // after it can still be running.
+    const auto wait_start = std::chrono::steady_clock::now();
+    vkWaitForFences(m_device, 1, slot.fence.get_address(), VK_TRUE,
+                    UINT64_MAX);
+    m_wait_times.add(get_milliseconds_since(wait_start));
+    m_completed_number = (std::max)(m_completed_number, slot.number);
+
+    const auto first_triangle = p_index * m_chunk_triangle_count;
+    const auto triangle_count = static_cast<std::uint32_t>((std::min)(
+        static_cast<std::uint64_t>(m_chunk_triangle_count),
+        m_triangle_count - first_triangle));
+    const auto size =
+        static_cast<std::size_t>(triangle_count * TRIANGLE_SIZE);
+
+    const auto read_start = std::chrono::steady_clock::now();
+    if (!read_file(first_triangle * TRIANGLE_SIZE, size, slot.staging_data))
+    {
+        std::exit(EXIT_FAILURE);
+    }
+    m_read_times.add(get_milliseconds_since(read_start));
+    m_streamed_bytes += size;
+
+    return geometry_stream_chunk_t{.number = number,
+                                   .slot = slot_index,
+                                   .vertex_buffer = slot.vertex_buffer.get(),
+                                   .vertex_count = triangle_count * 3};
+}
+
+auto geometry_stream_t::record_upload(
+    VkCommandBuffer p_command_buffer,
+    const geometry_stream_chunk_t& p_chunk) const -> void
+{
+    const auto& slot = m_slots[p_chunk.slot];
+    const auto region = VkBufferCopy{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = static_cast<VkDeviceSize>(p_chunk.vertex_count) *
+                sizeof(vertex_t)};
+    vkCmdCopyBuffer(p_command_buffer, slot.staging_buffer.get(),
+                    slot.vertex_buffer.get(), 1, &region);
+}
+
+auto geometry_stream_t::submit(const geometry_stream_chunk_t& p_chunk,
+                               const record_function_t& p_record) -> void
+{
+    auto& slot = m_slots[p_chunk.slot];
+    vkResetFences(m_device, 1, slot.fence.get_address());
+    vkResetCommandBuffer(slot.command_buffer, 0);
+
+    const auto begin_info = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr};
+
+    const auto begin_result =
+        vkBeginCommandBuffer(slot.command_buffer, &begin_info);
+    if (begin_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to begin recording a geometry "
+                   "stream command buffer. Vulkan error {}.\n",
+                   begin_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    p_record(slot.command_buffer);
+
+    const auto end_result = vkEndCommandBuffer(slot.command_buffer);
+    if (end_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to stop recording a geometry "
+                   "stream command buffer. Vulkan error {}.\n",
+                   end_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto submit_info =
+        VkSubmitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                     .pNext = nullptr,
+                     .waitSemaphoreCount = 0,
+                     .pWaitSemaphores = nullptr,
+                     .pWaitDstStageMask = nullptr,
+                     .commandBufferCount = 1,
+                     .pCommandBuffers = &slot.command_buffer,
+                     .signalSemaphoreCount = 0,
+                     .pSignalSemaphores = nullptr};
+
+    const auto submit_result =
+        vkQueueSubmit(m_queue, 1, &submit_info, slot.fence.get());
+    if (submit_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to submit a geometry stream chunk. "
+                   "Vulkan error {}.\n",
+                   submit_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    slot.number = p_chunk.number;
+}
+
+auto geometry_stream_t::wait_idle() -> void
+{
+    for (auto& slot : m_slots)
+    {
+        vkWaitForFences(m_device, 1, slot.fence.get_address(), VK_TRUE,
+                        UINT64_MAX);
+        m_completed_number = (std::max)(m_completed_number, slot.number);
+    }
+}
+
+auto geometry_stream_t::print_statistics() const -> void
+{
+    if (m_read_times.count == 0)
+    {
+        return;
+    }
+
+    const auto chunk_size =
+        static_cast<double>(m_chunk_triangle_count * TRIANGLE_SIZE);
+    const auto read_seconds =
+        m_read_times.mean * static_cast<double>(m_read_times.count) / 1000.0;
+
+    fmt::print("[INFO]: Streamed {:.2f} GB in {} chunks. Reading a chunk took "
+               "{:.3f} ms on average ({:.2f} GB/s), and waiting for a free "
+               "buffer {:.3f} ms (at most {:.3f} ms). Host memory for the "
+               "stream stayed at {:.1f} MB of staging buffers and one {:.1f} "
+               "MB window of the file.\n",
+               static_cast<double>(m_streamed_bytes) / 1e9, m_read_times.count,
+               m_read_times.mean,
+               read_seconds > 0.0
+                   ? static_cast<double>(m_streamed_bytes) / 1e9 / read_seconds
+                   : 0.0,
+               m_wait_times.mean, m_wait_times.max,
+               chunk_size * static_cast<double>(m_slots.size()) / 1e6,
+               chunk_size / 1e6);
+}
+
+#ifdef _WIN32
+
+auto geometry_stream_t::open_file(const std::filesystem::path& p_path)
+    -> void
+{
+    m_file = CreateFileW(p_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                         nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                         nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}. Windows error {}.\n",
+                   p_path.string(), GetLastError());
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_file_mapping =
+        CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_file_mapping == nullptr)
+    {
+        fmt::print("[FATAL ERROR]: Failed to map {}. Windows error {}.\n",
+                   p_path.string(), GetLastError());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+auto geometry_stream_t::close_file() -> void
+{
+    if (m_file_mapping != nullptr)
+    {
+        CloseHandle(m_file_mapping);
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+    }
+}
+
+auto geometry_stream_t::read_file(std::uint64_t p_offset, std::size_t p_size,
+                                  std::byte* p_destination) -> bool
+{
+    const auto view = MapViewOfFile(
+        m_file_mapping, FILE_MAP_READ, static_cast<DWORD>(p_offset >> 32),
+        static_cast<DWORD>(p_offset & 0xffffffff), p_size);
+    if (view == nullptr)
+    {
+        fmt::print("[FATAL ERROR]: Failed to map {} bytes of {} at offset {}. "
+                   "Windows error {}.\n",
+                   p_size, m_path.string(), p_offset, GetLastError());
+        return false;
+    }
+
+    std::memcpy(p_destination, view, p_size);
+    UnmapViewOfFile(view);
+
+    return true;
+}
+
+#elif defined(__linux__)
+
+auto geometry_stream_t::open_file(const std::filesystem::path& p_path)
+    -> void
+{
+    m_fd = open(p_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}: {}.\n", p_path.string(),
+                   std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+auto geometry_stream_t::close_file() -> void
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+}
+
+auto geometry_stream_t::read_file(std::uint64_t p_offset, std::size_t p_size,
+                                  std::byte* p_destination) -> bool
+{
+    const auto view = mmap(nullptr, p_size, PROT_READ, MAP_PRIVATE, m_fd,
+                           static_cast<off_t>(p_offset));
+    if (view == MAP_FAILED)
+    {
+        fmt::print("[FATAL ERROR]: Failed to map {} bytes of {} at offset {}: "
+                   "{}.\n",
+                   p_size, m_path.string(), p_offset, std::strerror(errno));
+        return false;
+    }
+
+    // The window is read front to back exactly once, so the kernel can read
+    // ahead aggressively and drop the pages behind it.
+    madvise(view, p_size, MADV_SEQUENTIAL);
+    std::memcpy(p_destination, view, p_size);
+    munmap(view, p_size);
+
+    return true;
+}
+
+#else
+
+auto geometry_stream_t::open_file(const std::filesystem::path& p_path)
+    -> void
+{
+    m_file.open(p_path, std::ios::binary);
+    if (!m_file)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}.\n", p_path.string());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+auto geometry_stream_t::close_file() -> void {}
+
+auto geometry_stream_t::read_file(std::uint64_t p_offset, std::size_t p_size,
+                                  std::byte* p_destination) -> bool
+{
+    m_file.seekg(static_cast<std::streamoff>(p_offset));
+    m_file.read(reinterpret_cast<char*>(p_destination),
+                static_cast<std::streamsize>(p_size));
+    if (!m_file)
+    {
+        fmt::print("[FATAL ERROR]: Failed to read {} bytes of {} at offset "
+                   "{}.\n",
+                   p_size, m_path.string(), p_offset);
+        return false;
+    }
+
+    return true;
+}
+
+#endif
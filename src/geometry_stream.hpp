@@ -0,0 +1,149 @@
+#ifndef INCLUDED_GEOMETRY_STREAM_HPP
+#define INCLUDED_GEOMETRY_STREAM_HPP
+
+#include "running_statistics.hpp"
+#include "shader_interface.hpp"
+#include "vulkan_handle.hpp"
+
+// One chunk of the file, copied into a staging buffer and waiting to be
+// uploaded and drawn.
+struct geometry_stream_chunk_t
+{
+    // Counts every chunk streamed so far, starting from 1, across any number
+    // of passes over the file.
+    std::uint64_t number;
+    std::uint32_t slot;
+    VkBuffer vertex_buffer;
+    std::uint32_t vertex_count;
+};
+
+// Draws a file of vertex_t triangles that may be far larger than device
+// memory, by streaming it through a small ring of chunk sized buffers.
+//
+// Each slot of the ring has a host visible staging buffer, a device local
+// vertex buffer, a command buffer and a fence. Streaming a chunk waits for its
+// slot's previous chunk to finish, copies the chunk from the file into the
+// staging buffer, and then submits the upload to the vertex buffer and the
+// draw from it on their own. Nothing orders chunk k + 1's upload after chunk
+// k's draw, so the copy overlaps with the draw on the GPU, while the CPU is
+// already reading chunk k + 2.
+//
+// The file is mapped one chunk sized window at a time, which is unmapped as
+// soon as it's been copied, so the host memory used is the staging buffers
+// and a single window no matter how big the file is. Without mmap or
+// MapViewOfFile, the chunks are read with std::ifstream instead.
+class geometry_stream_t
+{
+  public:
+    static constexpr auto MIN_BUFFER_COUNT = std::uint32_t{2};
+    static constexpr auto MAX_BUFFER_COUNT = std::uint32_t{3};
+
+    // Chunks are a whole number of this many triangles. That also keeps
+    // their offsets in the file multiples of 64 KiB, the coarsest granularity
+    // that a mapping can start at.
+    static constexpr auto TRIANGLE_GRANULARITY = std::uint32_t{65536};
+    static constexpr auto MAX_CHUNK_TRIANGLE_COUNT =
+        std::uint32_t{64} * TRIANGLE_GRANULARITY;
+
+    // p_chunk_triangle_count is rounded up to TRIANGLE_GRANULARITY, and
+    // p_buffer_count clamped to MIN_BUFFER_COUNT and MAX_BUFFER_COUNT. The
+    // file is opened here, and its size only read once.
+    geometry_stream_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                      VkQueue p_queue, std::uint32_t p_queue_family,
+                      const std::filesystem::path& p_path,
+                      std::uint32_t p_chunk_triangle_count,
+                      std::uint32_t p_buffer_count);
+
+    // Waits for every chunk in flight.
+    ~geometry_stream_t();
+
+    geometry_stream_t(const geometry_stream_t&) = delete;
+    auto operator=(const geometry_stream_t&) -> geometry_stream_t& = delete;
+
+    using record_function_t = std::function<void(VkCommandBuffer)>;
+
+    auto get_triangle_count() const -> std::uint64_t
+    {
+        return m_triangle_count;
+    }
+
+    auto get_chunk_count() const -> std::uint64_t { return m_chunk_count; }
+
+    // The number of the last chunk known to have completed on the GPU.
+    auto get_completed_number() const -> std::uint64_t
+    {
+        return m_completed_number;
+    }
+
+    // Waits for the next slot to be free, and copies chunk p_index of the
+    // file into its staging buffer.
+    auto begin_chunk(std::uint64_t p_index) -> geometry_stream_chunk_t;
+
+    // Copies p_chunk from the staging buffer into its vertex buffer. Has to
+    // be recorded outside of a render pass, and before anything reads the
+    // vertex buffer.
+    auto record_upload(VkCommandBuffer p_command_buffer,
+                       const geometry_stream_chunk_t& p_chunk) const -> void;
+
+    // Records p_record into p_chunk's command buffer and submits it.
+    // p_record should call record_upload(), and then draw the chunk.
+    auto submit(const geometry_stream_chunk_t& p_chunk,
+                const record_function_t& p_record) -> void;
+
+    // Waits for every chunk submitted so far.
+    auto wait_idle() -> void;
+
+    auto print_statistics() const -> void;
+
+  private:
+    struct slot_t
+    {
+        unique_buffer_t staging_buffer;
+        unique_device_memory_t staging_memory;
+        std::byte* staging_data;
+
+        unique_buffer_t vertex_buffer;
+        unique_device_memory_t vertex_memory;
+
+        VkCommandBuffer command_buffer;
+        unique_fence_t fence;
+
+        // The chunk last submitted from this slot, 0 if there was none.
+        std::uint64_t number;
+    };
+
+    auto open_file(const std::filesystem::path& p_path) -> void;
+    auto close_file() -> void;
+    auto read_file(std::uint64_t p_offset, std::size_t p_size,
+                   std::byte* p_destination) -> bool;
+
+    VkDevice m_device;
+    VkQueue m_queue;
+
+    std::filesystem::path m_path;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_file_mapping;
+#elif defined(__linux__)
+    int m_fd;
+#else
+    std::ifstream m_file;
+#endif
+
+    std::uint64_t m_triangle_count;
+    std::uint32_t m_chunk_triangle_count;
+    std::uint64_t m_chunk_count;
+
+    unique_command_pool_t m_command_pool;
+    std::vector<slot_t> m_slots;
+
+    std::uint64_t m_next_number;
+    std::uint64_t m_completed_number;
+
+    // In milliseconds, per chunk.
+    running_statistics_t m_read_times;
+    running_statistics_t m_wait_times;
+    std::uint64_t m_streamed_bytes;
+};
+
+#endif
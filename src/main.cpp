@@ -1,3 +1,30 @@
+#include "async_compute.hpp"
+#include "buffer.hpp"
+#include "debug_log.hpp"
+#include "deletion_queue.hpp"
+#include "device_selection.hpp"
+#include "draw_list.hpp"
+#include "frame_pacer.hpp"
+#include "geometry_generator.hpp"
+#include "geometry_stream.hpp"
+#include "mesh_optimizer.hpp"
+#include "object_culler.hpp"
+#include "options.hpp"
+#include "overdraw_view.hpp"
+#include "pipeline_statistics.hpp"
+#include "pipeline_variants.hpp"
+#include "redraw_scheduler.hpp"
+#include "render_graph.hpp"
+#include "render_service.hpp"
+#include "running_statistics.hpp"
+#include "shader_hot_reload.hpp"
+#include "shader_interface.hpp"
+#include "software_rasterizer.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include "uniform_ring.hpp"
+#include "vulkan_handle.hpp"
+
 #define LOAD_VK_FUNCTION(function, instance)                                   \
     const auto hello56721_##function = reinterpret_cast<PFN_##function>(       \
         vkGetInstanceProcAddr(instance, #function))
@@ -10,11 +37,20 @@ template <typename T, size_t S> using raw_array = T[S];
 constexpr uint16_t WINDOW_WIDTH = 1024;
 constexpr uint16_t WINDOW_HEIGHT = 768;
 
-constexpr bool ENABLE_VALIDATION = true;
-
 constexpr auto DEVICE_EXTENSIONS =
     std::array<const char*, 1>{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
+// These are only enabled on top of DEVICE_EXTENSIONS when the dynamic rendering
+// backend has been asked for and the device supports it.
+constexpr auto DYNAMIC_RENDERING_DEVICE_EXTENSIONS =
+    std::array<const char*, 1>{VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME};
+
+// Enabled whenever the device supports them, to measure when frames are really
+// displayed and to wait for them in low latency mode.
+constexpr auto PRESENT_WAIT_DEVICE_EXTENSIONS =
+    std::array<const char*, 2>{VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                               VK_KHR_PRESENT_WAIT_EXTENSION_NAME};
+
 struct swap_chain_support_details_t
 {
     VkSurfaceCapabilitiesKHR surface_capabilities;
@@ -22,38 +58,104 @@ struct swap_chain_support_details_t
     std::vector<VkPresentModeKHR> present_modes;
 };
 
-struct vertex_t
+// The parts of a graphics pipeline that are shared by all of its variants.
+struct pipeline_base_info_t
 {
-    glm::vec2 position;
-    glm::vec3 color;
+    VkExtent2D extent;
 
-    constexpr static auto get_binding_description()
-        -> VkVertexInputBindingDescription
-    {
-        return VkVertexInputBindingDescription{.binding = 0,
-                                               .stride = sizeof(vertex_t),
-                                               .inputRate =
-                                                   VK_VERTEX_INPUT_RATE_VERTEX};
-    }
+    // VK_NULL_HANDLE with the dynamic rendering backend, in which case the
+    // pipeline is built against the color format instead.
+    VkRenderPass render_pass;
+    VkFormat color_format;
 
-    constexpr static auto get_attribute_descriptions()
-        -> std::array<VkVertexInputAttributeDescription, 2>
-    {
-        return std::array<VkVertexInputAttributeDescription, 2>{
-            VkVertexInputAttributeDescription{.location = 0,
-                                              .binding = 0,
-                                              .format = VK_FORMAT_R32G32_SFLOAT,
-                                              .offset =
-                                                  offsetof(vertex_t, position)},
-            VkVertexInputAttributeDescription{
-                .location = 1,
-                .binding = 0,
-                .format = VK_FORMAT_R32G32B32_SFLOAT,
-                .offset = offsetof(vertex_t, color)},
-        };
-    }
+    // VK_FORMAT_UNDEFINED without a depth buffer, which also turns the depth
+    // test off.
+    VkFormat depth_format;
+
+    VkPipelineLayout layout;
+};
+
+// What a frame gets rendered into. The render pass backend only needs the
+// framebuffer, while dynamic rendering uses the image and its view directly.
+struct render_target_t
+{
+    VkRenderPass render_pass;
+    VkFramebuffer framebuffer;
+    VkImage image;
+    VkImageView image_view;
+    VkExtent2D extent;
+
+    // Whether the image is cleared first, or drawn on top of. The render pass
+    // has to have been created with the same load op.
+    VkAttachmentLoadOp load_op;
+
+    // VK_NULL_HANDLE without a depth buffer. Its contents never outlive the
+    // frame, so it's always cleared first.
+    VkImage depth_image;
+    VkImageView depth_image_view;
+};
+
+struct depth_buffer_t
+{
+    unique_image_t image;
+    unique_device_memory_t memory;
+    unique_image_view_t image_view;
+};
+
+// Everything that belongs to one window. The device, pipelines, buffers and
+// sync objects are shared by all of them.
+struct output_t
+{
+    GLFWwindow* window;
+    VkSurfaceKHR surface;
+
+    unique_swapchain_t swap_chain;
+    std::vector<VkImage> images;
+    VkFormat format;
+    VkExtent2D extent;
+    std::vector<unique_image_view_t> image_views;
+    std::vector<unique_framebuffer_t> framebuffers;
+
+    // Empty without a depth buffer. With a single frame in flight, one is
+    // enough for all of the swap chain images.
+    depth_buffer_t depth_buffer;
+
+    unique_semaphore_t image_available_semaphore;
+    VkCommandBuffer command_buffer;
+
+    // One per output, so that each one's compiled graph stays cached.
+    std::unique_ptr<render_graph_t> render_graph;
+
+    // Set by each frame's acquire.
+    std::uint32_t image_index;
 };
 
+// VK_KHR_dynamic_rendering is an extension on Vulkan 1.2, so its commands have
+// to be loaded by hand.
+struct dynamic_rendering_functions_t
+{
+    PFN_vkCmdBeginRenderingKHR begin_rendering;
+    PFN_vkCmdEndRenderingKHR end_rendering;
+};
+
+// With VULKAN_TRIANGLE_MIXED_STATE, the objects cycle through the triangle
+// subdivided zero to three times.
+constexpr auto MIXED_STATE_MESH_COUNT = std::uint32_t{4};
+
+// More slots than frames in flight, so a slot is never written while a
+// previous frame may still be reading it.
+constexpr auto UNIFORM_RING_SLOT_COUNT = std::uint32_t{3};
+
+// The triangle that every object is drawn with. It's clockwise on screen,
+// which the pipelines treat as front facing.
+auto get_triangle_vertices() -> std::array<vertex_t, 3>
+{
+    return std::array<vertex_t, 3>{
+        vertex_t{glm::vec2{0.0f, -0.5f}, glm::vec3{1.0f, 0.0f, 0.0f}},
+        vertex_t{glm::vec2{0.5f, 0.5f}, glm::vec3{0.0f, 1.0f, 0.0f}},
+        vertex_t{glm::vec2{-0.5f, 0.5f}, glm::vec3{0.0f, 0.0f, 1.0f}}};
+}
+
 auto do_nothing() {}
 
 inline auto print_error(std::string_view p_msg, VkResult p_err)
@@ -61,18 +163,22 @@ inline auto print_error(std::string_view p_msg, VkResult p_err)
     fmt::print(stderr, fmt::fg(fmt::color::red), p_msg, p_err);
 }
 
+// This is called on whichever thread the driver happens to be on, so it only
+// hands the message off to the debug log passed as p_user_data. The printing
+// happens on the log's own thread.
 VkBool32 debug_messenger_callback(
     VkDebugUtilsMessageSeverityFlagBitsEXT p_severity,
     VkDebugUtilsMessageTypeFlagsEXT,
-    const VkDebugUtilsMessengerCallbackDataEXT* p_callback_data, void*)
+    const VkDebugUtilsMessengerCallbackDataEXT* p_callback_data,
+    void* p_user_data)
 {
-    auto color = fmt::fg(fmt::color::yellow);
-    if (p_severity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
-    {
-        color = fmt::fg(fmt::color::red);
-    }
+    const auto severity =
+        p_severity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT
+            ? debug_log_severity_t::error
+            : debug_log_severity_t::warning;
 
-    fmt::print(color, "[VULKAN]: {}\n", p_callback_data->pMessage);
+    static_cast<debug_log_t*>(p_user_data)
+        ->push(severity, p_callback_data->pMessage);
 
     if (p_severity == VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
     {
@@ -82,27 +188,113 @@ VkBool32 debug_messenger_callback(
     return VK_FALSE;
 }
 
-constexpr VkDebugUtilsMessengerCreateInfoEXT DEBUG_MESSENGER_CREATE_INFO{
-    .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
-    .pNext = nullptr,
-    .flags = 0,
-    .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT |
-                       VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT,
-    //    VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
-    //    VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT,
-    .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
-                   VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
-                   VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
-    .pfnUserCallback = debug_messenger_callback,
-    .pUserData = nullptr};
+auto get_debug_messenger_create_info(debug_log_t* p_debug_log)
+    -> VkDebugUtilsMessengerCreateInfoEXT
+{
+    return VkDebugUtilsMessengerCreateInfoEXT{
+        .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+        .pNext = nullptr,
+        .flags = 0,
+        .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT |
+                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT,
+        //    VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+        //    VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT,
+        .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                       VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                       VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+        .pfnUserCallback = debug_messenger_callback,
+        .pUserData = p_debug_log};
+}
 
 void glfw_error_callback(int p_error_code, const char* p_message)
 {
     fmt::print("[GLFW ERROR {}]: {}\n", p_error_code, p_message);
 }
 
-VkInstance create_instance()
+// The state that the GLFW callbacks need to get at. It lives in the window's
+// user pointer.
+struct window_state_t
+{
+    pipeline_variant_key_t pipeline_variant;
+    redraw_scheduler_t* redraw_scheduler;
+
+    // Whether the windows show the overdraw heat map instead of the scene.
+    bool show_overdraw;
+};
+
+void key_callback(GLFWwindow* p_window, int p_key, int, int p_action, int)
+{
+    if (p_action != GLFW_PRESS)
+    {
+        return;
+    }
+
+    auto& state =
+        *static_cast<window_state_t*>(glfwGetWindowUserPointer(p_window));
+    auto& variant = state.pipeline_variant;
+
+    state.redraw_scheduler->request_redraw(redraw_reason_t::input);
+
+    // The color and cull modes are compiled up front, so switching them is
+    // instant. Additive blending is compiled the first time it's turned on,
+    // and the opaque pipeline is drawn with until it's ready. The overdraw
+    // view is also set up the first time it's turned on, by the main loop.
+    if (p_key == GLFW_KEY_F1)
+    {
+        variant.color_mode = static_cast<color_mode_t>(
+            (static_cast<std::uint32_t>(variant.color_mode) + 1) %
+            COLOR_MODE_COUNT);
+        fmt::print("[INFO]: Switched to color mode {}.\n",
+                   static_cast<std::uint32_t>(variant.color_mode));
+    }
+    else if (p_key == GLFW_KEY_F2)
+    {
+        variant.cull_mode = variant.cull_mode == VK_CULL_MODE_NONE
+                                ? VK_CULL_MODE_BACK_BIT
+                                : VK_CULL_MODE_NONE;
+        fmt::print("[INFO]: Back face culling is now {}.\n",
+                   variant.cull_mode == VK_CULL_MODE_NONE ? "off" : "on");
+    }
+    else if (p_key == GLFW_KEY_F3)
+    {
+        variant.blend_mode = variant.blend_mode == blend_mode_t::opaque
+                                 ? blend_mode_t::additive
+                                 : blend_mode_t::opaque;
+        fmt::print("[INFO]: Additive blending is now {}.\n",
+                   variant.blend_mode == blend_mode_t::opaque ? "off" : "on");
+    }
+    else if (p_key == GLFW_KEY_F4)
+    {
+        state.show_overdraw = !state.show_overdraw;
+        fmt::print("[INFO]: The overdraw view is now {}.\n",
+                   state.show_overdraw ? "on" : "off");
+    }
+}
+
+// The window was exposed or changed size, so its contents may need to be
+// drawn again.
+void window_refresh_callback(GLFWwindow* p_window)
+{
+    const auto& state =
+        *static_cast<window_state_t*>(glfwGetWindowUserPointer(p_window));
+    state.redraw_scheduler->request_redraw(redraw_reason_t::window);
+}
+
+void framebuffer_size_callback(GLFWwindow* p_window, int, int)
+{
+    window_refresh_callback(p_window);
+}
+
+// Passing nullptr for p_debug_log creates the instance without the validation
+// layer or the debug utils extension.
+// A headless instance doesn't enable the surface extensions, so it works
+// without a display, and without GLFW having been initialized.
+// Returns an empty handle if there's no Vulkan driver to create it with, so
+// that the caller can fall back to the software rasterizer.
+unique_instance_t create_instance(debug_log_t* p_debug_log, bool p_headless)
 {
+    const auto enable_validation = p_debug_log != nullptr;
+
     VkApplicationInfo application_info{
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pNext = nullptr,
@@ -112,20 +304,22 @@ VkInstance create_instance()
         .engineVersion = 0,
         .apiVersion = VK_API_VERSION_1_2};
 
-    uint32_t glfw_vulkan_extension_count;
+    uint32_t glfw_vulkan_extension_count = 0;
     const char** glfw_vulkan_extensions =
-        glfwGetRequiredInstanceExtensions(&glfw_vulkan_extension_count);
+        p_headless
+            ? nullptr
+            : glfwGetRequiredInstanceExtensions(&glfw_vulkan_extension_count);
 
     std::vector<const char*> enabled_extensions(
         glfw_vulkan_extensions,
         glfw_vulkan_extensions + glfw_vulkan_extension_count);
-    if (ENABLE_VALIDATION)
+    if (enable_validation)
     {
         enabled_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
 
     std::vector<const char*> enabled_layers;
-    if (ENABLE_VALIDATION)
+    if (enable_validation)
     {
         enabled_layers.push_back("VK_LAYER_KHRONOS_validation");
     }
@@ -147,30 +341,54 @@ VkInstance create_instance()
             static_cast<uint32_t>(enabled_extensions.size()),
         .ppEnabledExtensionNames = enabled_extensions.data()};
 
-    if (ENABLE_VALIDATION)
+    // Covers messages from vkCreateInstance and vkDestroyInstance, which the
+    // real messenger can't.
+    const auto debug_messenger_create_info =
+        get_debug_messenger_create_info(p_debug_log);
+    if (enable_validation)
     {
-        create_info.pNext = &DEBUG_MESSENGER_CREATE_INFO;
+        create_info.pNext = &debug_messenger_create_info;
     }
 
     VkInstance instance;
     VkResult result = vkCreateInstance(&create_info, nullptr, &instance);
     if (result != VK_SUCCESS)
     {
-        fmt::print("[FATAL ERROR]: Failed to create the Vulkan instance. "
-                   "Vulkan Error {}",
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Failed to create the Vulkan instance. Vulkan "
+                   "error {}.\n",
                    result);
-        std::exit(EXIT_FAILURE);
+        return unique_instance_t();
     }
 
-    return instance;
+    return unique_instance_t(instance, {});
 }
 
-VkDebugUtilsMessengerEXT create_debug_messenger(VkInstance p_instance)
+// The debug utils functions come from an extension, so they have to be loaded
+// by hand.
+struct debug_messenger_deleter_t
+{
+    VkInstance instance;
+
+    auto operator()(VkDebugUtilsMessengerEXT p_debug_messenger) const -> void
+    {
+        LOAD_VK_FUNCTION(vkDestroyDebugUtilsMessengerEXT, instance);
+        hello56721_vkDestroyDebugUtilsMessengerEXT(instance, p_debug_messenger,
+                                                   nullptr);
+    }
+};
+
+using unique_debug_messenger_t =
+    unique_handle_t<VkDebugUtilsMessengerEXT, debug_messenger_deleter_t>;
+
+unique_debug_messenger_t create_debug_messenger(VkInstance p_instance,
+                                                debug_log_t* p_debug_log)
 {
     LOAD_VK_FUNCTION(vkCreateDebugUtilsMessengerEXT, p_instance);
+    const auto create_info = get_debug_messenger_create_info(p_debug_log);
     VkDebugUtilsMessengerEXT debug_messenger;
     VkResult result = hello56721_vkCreateDebugUtilsMessengerEXT(
-        p_instance, &DEBUG_MESSENGER_CREATE_INFO, nullptr, &debug_messenger);
+        p_instance, &create_info, nullptr, &debug_messenger);
     if (result != VK_SUCCESS)
     {
         fmt::print("[FATAL ERROR]: Failed to create the debug messenger. "
@@ -179,10 +397,10 @@ VkDebugUtilsMessengerEXT create_debug_messenger(VkInstance p_instance)
         std::exit(EXIT_FAILURE);
     }
 
-    return debug_messenger;
+    return unique_debug_messenger_t(debug_messenger, {p_instance});
 }
 
-VkSurfaceKHR create_surface(VkInstance p_instance, GLFWwindow* p_window)
+unique_surface_t create_surface(VkInstance p_instance, GLFWwindow* p_window)
 {
     VkSurfaceKHR surface;
     VkResult result =
@@ -195,7 +413,7 @@ VkSurfaceKHR create_surface(VkInstance p_instance, GLFWwindow* p_window)
         std::exit(EXIT_FAILURE);
     }
 
-    return surface;
+    return unique_surface_t(surface, {p_instance});
 }
 
 auto find_queue_families(VkPhysicalDevice p_physical_device,
@@ -220,6 +438,11 @@ auto find_queue_families(VkPhysicalDevice p_physical_device,
             graphics_family = i;
         }
 
+        if (p_surface == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
         VkBool32 present_support;
         vkGetPhysicalDeviceSurfaceSupportKHR(p_physical_device, i, p_surface,
                                              &present_support);
@@ -230,9 +453,43 @@ auto find_queue_families(VkPhysicalDevice p_physical_device,
         }
     }
 
+    // Without a surface, nothing is ever presented.
+    if (p_surface == VK_NULL_HANDLE)
+    {
+        present_family = graphics_family;
+    }
+
     return {graphics_family, present_family};
 }
 
+// A family that supports compute but not graphics, for work that should run
+// alongside the graphics queue rather than behind it. These are usually backed
+// by the GPU's dedicated compute engines.
+auto find_async_compute_family(VkPhysicalDevice p_physical_device)
+    -> std::optional<std::uint32_t>
+{
+    auto queue_family_count = std::uint32_t{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device,
+                                             &queue_family_count, nullptr);
+
+    auto queue_families =
+        std::vector<VkQueueFamilyProperties>(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        p_physical_device, &queue_family_count, queue_families.data());
+
+    for (auto i = std::uint32_t{0}; i < queue_family_count; i++)
+    {
+        const auto flags = queue_families[i].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) != 0 &&
+            (flags & VK_QUEUE_GRAPHICS_BIT) == 0)
+        {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
 auto query_swap_chain_support_details(VkPhysicalDevice p_physical_device,
                                       VkSurfaceKHR p_surface)
     -> swap_chain_support_details_t
@@ -269,9 +526,67 @@ auto query_swap_chain_support_details(VkPhysicalDevice p_physical_device,
     return support_details;
 }
 
+// A physical device must have both a present family and a graphics family for
+// it to be usable. And it must have all the required extensions, plus an
+// adequate swap chain. Without a surface, only the graphics family matters.
+auto is_physical_device_usable(VkPhysicalDevice p_physical_device,
+                               VkSurfaceKHR p_surface) -> bool
+{
+    const auto [graphics_family, present_family] =
+        find_queue_families(p_physical_device, p_surface);
+    if (!graphics_family.has_value() || !present_family.has_value())
+    {
+        return false;
+    }
+
+    if (p_surface == VK_NULL_HANDLE)
+    {
+        return true;
+    }
+
+    auto available_extension_count = static_cast<std::uint32_t>(0);
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &available_extension_count, nullptr);
+
+    auto available_extensions =
+        std::vector<VkExtensionProperties>(available_extension_count);
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &available_extension_count,
+                                         available_extensions.data());
+
+    for (const auto& extension : DEVICE_EXTENSIONS)
+    {
+        const auto found = std::any_of(
+            available_extensions.begin(), available_extensions.end(),
+            [extension](const VkExtensionProperties& p_extension) {
+                return std::strcmp(p_extension.extensionName, extension) == 0;
+            });
+
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    const auto [surface_capabilities, formats, present_modes] =
+        query_swap_chain_support_details(p_physical_device, p_surface);
+
+    return !formats.empty() && !present_modes.empty();
+}
+
+// The device is chosen in this order:
+// 1. The first usable device matching p_override, if it isn't empty.
+// 2. The device cached by a previous run, if it's still present and usable.
+//    Only that one device is checked.
+// 3. The usable device with the highest score_physical_device(), which is
+//    then cached for the next run.
+// Returns VK_NULL_HANDLE if no device is usable at all.
 VkPhysicalDevice pick_physical_device(VkInstance p_instance,
-                                      VkSurfaceKHR p_surface)
+                                      VkSurfaceKHR p_surface,
+                                      std::string_view p_override)
 {
+    const auto start_time = std::chrono::steady_clock::now();
+
     uint32_t physical_device_count;
     vkEnumeratePhysicalDevices(p_instance, &physical_device_count, nullptr);
 
@@ -279,149 +594,298 @@ VkPhysicalDevice pick_physical_device(VkInstance p_instance,
     vkEnumeratePhysicalDevices(p_instance, &physical_device_count,
                                physical_devices.data());
 
-    std::vector<VkPhysicalDevice> usable_physical_devices;
-    for (const auto& physical_device : physical_devices)
-    {
-        auto [graphics_family, present_family] =
-            find_queue_families(physical_device, p_surface);
-
-        auto has_required_extensions = true;
+    auto chosen_device = static_cast<VkPhysicalDevice>(VK_NULL_HANDLE);
+    auto reason = std::string_view();
 
-        auto available_extension_count = static_cast<std::uint32_t>(0);
-        vkEnumerateDeviceExtensionProperties(
-            physical_device, nullptr, &available_extension_count, nullptr);
-
-        auto available_extensions =
-            std::vector<VkExtensionProperties>(available_extension_count);
-        vkEnumerateDeviceExtensionProperties(physical_device, nullptr,
-                                             &available_extension_count,
-                                             available_extensions.data());
+    if (!p_override.empty())
+    {
+        const auto match = std::find_if(
+            physical_devices.begin(), physical_devices.end(),
+            [p_surface, p_override](VkPhysicalDevice p_physical_device) {
+                return matches_device_override(p_physical_device,
+                                               p_override) &&
+                       is_physical_device_usable(p_physical_device,
+                                                 p_surface);
+            });
+
+        if (match != physical_devices.end())
+        {
+            chosen_device = *match;
+            reason = "requested";
+        }
+        else
+        {
+            fmt::print(fmt::fg(fmt::color::yellow),
+                       "[WARNING]: No usable physical device matches \"{}\". "
+                       "Picking one automatically instead.\n",
+                       p_override);
+        }
+    }
 
-        auto device_properties = VkPhysicalDeviceProperties{};
-        vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    const auto cached_uuid = load_cached_device_uuid();
+    if (chosen_device == VK_NULL_HANDLE && cached_uuid.has_value())
+    {
+        const auto match = std::find_if(
+            physical_devices.begin(), physical_devices.end(),
+            [&cached_uuid](VkPhysicalDevice p_physical_device) {
+                return get_device_uuid(p_physical_device) == *cached_uuid;
+            });
+
+        if (match != physical_devices.end() &&
+            is_physical_device_usable(*match, p_surface))
+        {
+            chosen_device = *match;
+            reason = "cached";
+        }
+    }
 
-        fmt::print("[INFO]: Found physical device {}\n",
-                   device_properties.deviceName);
+    if (chosen_device == VK_NULL_HANDLE)
+    {
+        auto best_score = std::uint64_t{0};
 
-        for (const auto& extension : DEVICE_EXTENSIONS)
+        for (const auto& physical_device : physical_devices)
         {
-            auto extension_found = false;
+            auto device_properties = VkPhysicalDeviceProperties{};
+            vkGetPhysicalDeviceProperties(physical_device, &device_properties);
 
-            for (const auto& available_extension : available_extensions)
+            if (!is_physical_device_usable(physical_device, p_surface))
             {
-                if (std::strcmp(available_extension.extensionName, extension) ==
-                    0)
-                {
-                    extension_found = true;
-                    break;
-                }
+                fmt::print("[INFO]: Found physical device {}, which isn't "
+                           "usable.\n",
+                           device_properties.deviceName);
+                continue;
             }
 
-            if (!extension_found)
+            const auto score = score_physical_device(physical_device);
+            fmt::print("[INFO]: Found physical device {} with a score of {}.\n",
+                       device_properties.deviceName, score);
+
+            if (chosen_device == VK_NULL_HANDLE || score > best_score)
             {
-                has_required_extensions = false;
-                break;
+                chosen_device = physical_device;
+                best_score = score;
             }
         }
 
-        auto swap_chain_adequate = false;
-
-        if (has_required_extensions && graphics_family.has_value() &&
-            present_family.has_value())
+        if (chosen_device == VK_NULL_HANDLE)
         {
-            const auto [surface_capabilities, formats, present_modes] =
-                query_swap_chain_support_details(physical_device, p_surface);
-
-            swap_chain_adequate = !formats.empty() && !present_modes.empty();
+            fmt::print(fmt::fg(fmt::color::yellow),
+                       "[WARNING]: Failed to find any adequate physical "
+                       "devices.\n");
+            return VK_NULL_HANDLE;
         }
 
-        // A physical device must have both a present family and a graphics fa-
-        // mily for it to be usable. And it must have all the required extensi-
-        // ons, plus an adequate swap chain.
-        if (graphics_family.has_value() && present_family.has_value() &&
-            has_required_extensions && swap_chain_adequate)
+        save_cached_device_uuid(get_device_uuid(chosen_device));
+        reason = "highest scoring";
+    }
+
+    const auto selection_time =
+        std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time)
+            .count();
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(chosen_device, &device_properties);
+
+    fmt::print("[INFO]: We chose to use the {} graphics card ({}, UUID {}). "
+               "Selection took {:.2f} ms.\n",
+               device_properties.deviceName, reason,
+               format_device_uuid(get_device_uuid(chosen_device)),
+               selection_time);
+
+    return chosen_device;
+}
+
+template <std::size_t N>
+auto supports_device_extensions(
+    VkPhysicalDevice p_physical_device,
+    const std::array<const char*, N>& p_required_extensions) -> bool
+{
+    auto extension_count = static_cast<std::uint32_t>(0);
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &extension_count, nullptr);
+
+    auto extensions = std::vector<VkExtensionProperties>(extension_count);
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &extension_count, extensions.data());
+
+    for (const auto& required_extension : p_required_extensions)
+    {
+        const auto found = std::any_of(
+            extensions.begin(), extensions.end(),
+            [required_extension](const VkExtensionProperties& p_extension) {
+                return std::strcmp(p_extension.extensionName,
+                                   required_extension) == 0;
+            });
+
+        if (!found)
         {
-            usable_physical_devices.push_back(physical_device);
+            return false;
         }
     }
 
-    if (usable_physical_devices.empty())
+    return true;
+}
+
+auto supports_dynamic_rendering(VkPhysicalDevice p_physical_device) -> bool
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    // vkGetPhysicalDeviceFeatures2 is only available from Vulkan 1.1 onwards.
+    if (device_properties.apiVersion < VK_API_VERSION_1_1 ||
+        !supports_device_extensions(p_physical_device,
+                                    DYNAMIC_RENDERING_DEVICE_EXTENSIONS))
     {
-        fmt::print(
-            "[FATAL ERROR]: Failed to find any adequate physical devices!\n");
-        std::exit(EXIT_FAILURE);
+        return false;
     }
 
-    VkPhysicalDevice chosen_device = usable_physical_devices[0];
-    for (const auto& physical_device : usable_physical_devices)
-    {
-        VkPhysicalDeviceProperties device_properties;
-        vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    auto dynamic_rendering_features =
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR{
+            .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+            .pNext = nullptr,
+            .dynamicRendering = VK_FALSE};
 
-        // This is assuming that you either have a single dedicated GPU, a ded-
-        // icated GPU and an integrated GPU, or a single integrated GPU and no-
-        // thing else.
-        if (device_properties.deviceType ==
-            VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-        {
-            chosen_device = physical_device;
-            break;
-        }
+    auto features = VkPhysicalDeviceFeatures2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &dynamic_rendering_features,
+        .features = {}};
+    vkGetPhysicalDeviceFeatures2(p_physical_device, &features);
+
+    return dynamic_rendering_features.dynamicRendering == VK_TRUE;
+}
+
+auto supports_present_wait(VkPhysicalDevice p_physical_device) -> bool
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    if (device_properties.apiVersion < VK_API_VERSION_1_1 ||
+        !supports_device_extensions(p_physical_device,
+                                    PRESENT_WAIT_DEVICE_EXTENSIONS))
+    {
+        return false;
     }
 
-    VkPhysicalDeviceProperties device_properties;
-    vkGetPhysicalDeviceProperties(chosen_device, &device_properties);
+    auto present_wait_features = VkPhysicalDevicePresentWaitFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentWait = VK_FALSE};
 
-    fmt::print("[INFO]: We chose to use the {} graphics card.\n",
-               device_properties.deviceName);
+    auto present_id_features = VkPhysicalDevicePresentIdFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_features,
+        .presentId = VK_FALSE};
 
-    return chosen_device;
+    auto features = VkPhysicalDeviceFeatures2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &present_id_features,
+        .features = {}};
+    vkGetPhysicalDeviceFeatures2(p_physical_device, &features);
+
+    return present_id_features.presentId == VK_TRUE &&
+           present_wait_features.presentWait == VK_TRUE;
 }
 
 // Return values:
 // - Logical device handle
 // - Graphics queue handle
 // - Present queue handle
+// - Compute queue handle, which is the graphics queue if p_compute_family
+//   isn't set
+//
+// A headless device doesn't enable VK_KHR_swapchain.
 auto create_logical_device(VkPhysicalDevice p_physical_device,
                            std::uint32_t p_graphics_family,
-                           std::uint32_t p_present_family)
-    -> std::tuple<VkDevice, VkQueue, VkQueue>
+                           std::uint32_t p_present_family,
+                           std::optional<std::uint32_t> p_compute_family,
+                           bool p_enable_dynamic_rendering,
+                           bool p_enable_present_wait, bool p_headless)
+    -> std::tuple<unique_device_t, VkQueue, VkQueue, VkQueue>
 {
     auto queue_create_infos = std::vector<VkDeviceQueueCreateInfo>();
 
     const auto queue_priority = 1.0f;
 
-    if (p_graphics_family == p_present_family)
+    // One queue from each distinct family.
+    auto families = std::vector<std::uint32_t>{p_graphics_family};
+    if (p_present_family != p_graphics_family)
     {
-        const auto queue_create_info = VkDeviceQueueCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .flags = 0,
-            .queueFamilyIndex = p_graphics_family,
-            .queueCount = 1,
-            .pQueuePriorities = &queue_priority,
-        };
-
-        queue_create_infos.push_back(queue_create_info);
+        families.push_back(p_present_family);
     }
-    else
+    if (p_compute_family.has_value() &&
+        std::find(families.begin(), families.end(), *p_compute_family) ==
+            families.end())
+    {
+        families.push_back(*p_compute_family);
+    }
+
+    for (const auto family : families)
     {
-        auto queue_create_info = VkDeviceQueueCreateInfo{
+        queue_create_infos.push_back(VkDeviceQueueCreateInfo{
             .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
             .flags = 0,
-            .queueFamilyIndex = p_graphics_family,
+            .queueFamilyIndex = family,
             .queueCount = 1,
             .pQueuePriorities = &queue_priority,
-        };
+        });
+    }
+
+    auto enabled_extensions =
+        p_headless ? std::vector<const char*>()
+                   : std::vector<const char*>(DEVICE_EXTENSIONS.begin(),
+                                              DEVICE_EXTENSIONS.end());
+
+    auto dynamic_rendering_features =
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR{
+            .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+            .pNext = nullptr,
+            .dynamicRendering = VK_TRUE};
 
-        queue_create_infos.push_back(queue_create_info);
+    auto present_wait_features = VkPhysicalDevicePresentWaitFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentWait = VK_TRUE};
+
+    auto present_id_features = VkPhysicalDevicePresentIdFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_features,
+        .presentId = VK_TRUE};
+
+    // The head of the feature chain, if there is one.
+    auto features = static_cast<void*>(nullptr);
+
+    if (p_enable_dynamic_rendering)
+    {
+        enabled_extensions.insert(enabled_extensions.end(),
+                                  DYNAMIC_RENDERING_DEVICE_EXTENSIONS.begin(),
+                                  DYNAMIC_RENDERING_DEVICE_EXTENSIONS.end());
+        features = &dynamic_rendering_features;
+    }
 
-        queue_create_info.queueFamilyIndex = p_present_family;
-        queue_create_infos.push_back(queue_create_info);
+    if (p_enable_present_wait)
+    {
+        enabled_extensions.insert(enabled_extensions.end(),
+                                  PRESENT_WAIT_DEVICE_EXTENSIONS.begin(),
+                                  PRESENT_WAIT_DEVICE_EXTENSIONS.end());
+        present_wait_features.pNext = features;
+        features = &present_id_features;
     }
 
+    // Textures stay block compressed on the GPU, which needs this wherever
+    // it's available. Without it, texture_t refuses BC files. Likewise,
+    // pipeline_statistics_t only counts shader invocations if it can.
+    auto supported_features = VkPhysicalDeviceFeatures{};
+    vkGetPhysicalDeviceFeatures(p_physical_device, &supported_features);
+    const auto enabled_features = VkPhysicalDeviceFeatures{
+        .textureCompressionBC = supported_features.textureCompressionBC,
+        .pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery};
+
     const auto create_info =
         VkDeviceCreateInfo{.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                           .pNext = nullptr,
+                           .pNext = features,
                            .flags = 0,
                            .queueCreateInfoCount =
                                static_cast<uint32_t>(queue_create_infos.size()),
@@ -429,9 +893,9 @@ auto create_logical_device(VkPhysicalDevice p_physical_device,
                            .enabledLayerCount = 0,
                            .ppEnabledLayerNames = nullptr,
                            .enabledExtensionCount =
-                               static_cast<uint32_t>(DEVICE_EXTENSIONS.size()),
-                           .ppEnabledExtensionNames = DEVICE_EXTENSIONS.data(),
-                           .pEnabledFeatures = nullptr};
+                               static_cast<uint32_t>(enabled_extensions.size()),
+                           .ppEnabledExtensionNames = enabled_extensions.data(),
+                           .pEnabledFeatures = &enabled_features};
 
     auto device = static_cast<VkDevice>(nullptr);
     const auto result =
@@ -444,11 +908,15 @@ auto create_logical_device(VkPhysicalDevice p_physical_device,
 
     auto graphics_queue = static_cast<VkQueue>(nullptr);
     auto present_queue = static_cast<VkQueue>(nullptr);
+    auto compute_queue = static_cast<VkQueue>(nullptr);
 
     vkGetDeviceQueue(device, p_graphics_family, 0, &graphics_queue);
     vkGetDeviceQueue(device, p_present_family, 0, &present_queue);
+    vkGetDeviceQueue(device, p_compute_family.value_or(p_graphics_family), 0,
+                     &compute_queue);
 
-    return {device, graphics_queue, present_queue};
+    return {unique_device_t(device, {}), graphics_queue, present_queue,
+            compute_queue};
 }
 
 // The return types are like this
@@ -520,7 +988,8 @@ auto create_swap_chain(VkPhysicalDevice p_physical_device,
                        VkSurfaceKHR p_surface, GLFWwindow* p_window,
                        std::uint32_t p_graphics_family,
                        std::uint32_t p_present_family, VkDevice p_device)
-    -> std::tuple<VkSwapchainKHR, std::vector<VkImage>, VkFormat, VkExtent2D>
+    -> std::tuple<unique_swapchain_t, std::vector<VkImage>, VkFormat,
+                  VkExtent2D>
 {
     const auto [surface_capabilties, formats, present_modes] =
         query_swap_chain_support_details(p_physical_device, p_surface);
@@ -581,14 +1050,16 @@ auto create_swap_chain(VkPhysicalDevice p_physical_device,
     auto images = std::vector<VkImage>(image_count);
     vkGetSwapchainImagesKHR(p_device, swap_chain, &image_count, images.data());
 
-    return {swap_chain, images, format.format, extent};
+    return {unique_swapchain_t(swap_chain, {p_device}), images, format.format,
+            extent};
 }
 
 auto create_image_views(VkDevice p_device,
                         const std::vector<VkImage> p_swap_chain_images,
-                        VkFormat p_format) -> std::vector<VkImageView>
+                        VkFormat p_format) -> std::vector<unique_image_view_t>
 {
-    auto image_views = std::vector<VkImageView>(p_swap_chain_images.size());
+    auto image_views = std::vector<unique_image_view_t>();
+    image_views.reserve(p_swap_chain_images.size());
 
     for (auto i = static_cast<decltype(p_swap_chain_images.size())>(0);
          i < p_swap_chain_images.size(); i++)
@@ -625,7 +1096,7 @@ auto create_image_views(VkDevice p_device,
             std::exit(EXIT_FAILURE);
         }
 
-        image_views[i] = image_view;
+        image_views.emplace_back(image_view, image_view_deleter_t{p_device});
     }
 
     return image_views;
@@ -656,7 +1127,7 @@ auto load_binary_file(std::string_view p_path) -> std::vector<char>
 }
 
 auto create_shader_module(VkDevice p_device, const std::vector<char>& p_code)
-    -> VkShaderModule
+    -> unique_shader_module_t
 {
     const auto create_info = VkShaderModuleCreateInfo{
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
@@ -677,39 +1148,88 @@ auto create_shader_module(VkDevice p_device, const std::vector<char>& p_code)
         std::exit(EXIT_FAILURE);
     }
 
-    return shader_module;
+    return unique_shader_module_t(shader_module, {p_device});
 }
 
-auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
-                              VkRenderPass p_render_pass)
-    -> std::tuple<VkPipeline, VkPipelineLayout>
+// Set 0 is the frame's uniforms, and set 1 the texture.
+auto create_pipeline_layout(VkDevice p_device,
+                            VkDescriptorSetLayout p_frame_set_layout,
+                            VkDescriptorSetLayout p_texture_set_layout)
+    -> unique_pipeline_layout_t
 {
-    const auto vertex_shader_code = load_binary_file("shaders/shader.vert.spv");
-    const auto fragment_shader_code =
-        load_binary_file("shaders/shader.frag.spv");
+    const auto set_layouts = std::array<VkDescriptorSetLayout, 2>{
+        p_frame_set_layout, p_texture_set_layout};
 
-    const auto vertex_shader_module =
-        create_shader_module(p_device, vertex_shader_code);
-    const auto fragment_shader_module =
-        create_shader_module(p_device, fragment_shader_code);
+    const auto push_constant_range =
+        VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                            .offset = 0,
+                            .size = sizeof(push_constants_t)};
+
+    const auto pipeline_layout_info = VkPipelineLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount = static_cast<std::uint32_t>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range};
+
+    auto pipeline_layout = static_cast<VkPipelineLayout>(VK_NULL_HANDLE);
+    const auto result = vkCreatePipelineLayout(p_device, &pipeline_layout_info,
+                                               nullptr, &pipeline_layout);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the pipeline layout. "
+                   "Vulkan error {}",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return unique_pipeline_layout_t(pipeline_layout, {p_device});
+}
 
+// Unlike most of the other creation functions, this one doesn't bail out on
+// failure, as it runs on the pipeline build workers (and during shader hot
+// reloading), where a bad shader should not take the whole program down. It
+// returns VK_NULL_HANDLE instead.
+auto create_graphics_pipeline(VkDevice p_device,
+                              const pipeline_base_info_t& p_base_info,
+                              VkShaderModule p_vertex_shader_module,
+                              VkShaderModule p_fragment_shader_module,
+                              VkPipelineCache p_pipeline_cache,
+                              const pipeline_variant_key_t& p_variant)
+    -> VkPipeline
+{
     const auto vertex_shader_stage_info = VkPipelineShaderStageCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
         .stage = VK_SHADER_STAGE_VERTEX_BIT,
-        .module = vertex_shader_module,
+        .module = p_vertex_shader_module,
         .pName = "main",
         .pSpecializationInfo = nullptr};
 
+    const auto color_mode = static_cast<std::uint32_t>(p_variant.color_mode);
+
+    const auto fragment_specialization_entry =
+        VkSpecializationMapEntry{.constantID = 0,
+                                 .offset = 0,
+                                 .size = sizeof(color_mode)};
+
+    const auto fragment_specialization_info =
+        VkSpecializationInfo{.mapEntryCount = 1,
+                             .pMapEntries = &fragment_specialization_entry,
+                             .dataSize = sizeof(color_mode),
+                             .pData = &color_mode};
+
     const auto fragment_shader_stage_info = VkPipelineShaderStageCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
         .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-        .module = fragment_shader_module,
+        .module = p_fragment_shader_module,
         .pName = "main",
-        .pSpecializationInfo = nullptr};
+        .pSpecializationInfo = &fragment_specialization_info};
 
     const auto shader_stages = std::array<VkPipelineShaderStageCreateInfo, 2>{
         fragment_shader_stage_info, vertex_shader_stage_info};
@@ -751,8 +1271,8 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
     const auto viewport = VkViewport{
         .x = 0.0f,
         .y = 0.0f,
-        .width = static_cast<float>(p_swap_chain_extent.width),
-        .height = static_cast<float>(p_swap_chain_extent.height),
+        .width = static_cast<float>(p_base_info.extent.width),
+        .height = static_cast<float>(p_base_info.extent.height),
         .minDepth = 0.0f,
         .maxDepth = 1.0f,
     };
@@ -763,7 +1283,7 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
                 .x = 0,
                 .y = 0,
             },
-        .extent = p_swap_chain_extent,
+        .extent = p_base_info.extent,
     };
 
     const auto viewport_state = VkPipelineViewportStateCreateInfo{
@@ -782,7 +1302,7 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
         .depthClampEnable = VK_FALSE,
         .rasterizerDiscardEnable = VK_FALSE,
         .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
+        .cullMode = p_variant.cull_mode,
         .frontFace = VK_FRONT_FACE_CLOCKWISE,
         .depthBiasEnable = VK_FALSE,
         .depthBiasConstantFactor = 0.0f,
@@ -802,13 +1322,16 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
         .alphaToCoverageEnable = VK_FALSE,
         .alphaToOneEnable = VK_FALSE};
 
+    const auto additive = p_variant.blend_mode == blend_mode_t::additive;
     const auto color_blend_attachment = VkPipelineColorBlendAttachmentState{
-        .blendEnable = VK_FALSE,
+        .blendEnable = additive ? VK_TRUE : VK_FALSE,
         .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .dstColorBlendFactor =
+            additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ZERO,
         .colorBlendOp = VK_BLEND_OP_ADD,
         .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .dstAlphaBlendFactor =
+            additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ZERO,
         .alphaBlendOp = VK_BLEND_OP_ADD,
         .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT};
@@ -821,30 +1344,39 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
         .pAttachments = &color_blend_attachment,
         .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}};
 
-    const auto pipeline_layout_info = VkPipelineLayoutCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    // Nearer objects hide the ones behind them, however they're ordered.
+    // Additive objects show through each other, so they're tested against
+    // the opaque ones but don't hide anything themselves.
+    const auto depth_stencil_state = VkPipelineDepthStencilStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .setLayoutCount = 0,
-        .pSetLayouts = nullptr,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = nullptr};
-
-    auto pipeline_layout = static_cast<VkPipelineLayout>(
-        VK_NULL_HANDLE); // TODO: Clean this up afterwards.
-    const auto pipeline_layout_create_result = vkCreatePipelineLayout(
-        p_device, &pipeline_layout_info, nullptr, &pipeline_layout);
-    if (pipeline_layout_create_result != VK_SUCCESS)
-    {
-        fmt::print("[FATAL ERROR]: Failed to create the pipeline layout. "
-                   "Vulkan error {}",
-                   pipeline_layout_create_result);
-        std::exit(EXIT_FAILURE);
-    }
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = additive ? VK_FALSE : VK_TRUE,
+        .depthCompareOp = VK_COMPARE_OP_LESS,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+        .front = {},
+        .back = {},
+        .minDepthBounds = 0.0f,
+        .maxDepthBounds = 1.0f};
+    const auto has_depth = p_base_info.depth_format != VK_FORMAT_UNDEFINED;
+
+    // Only used with the dynamic rendering backend, where there is no render
+    // pass to describe the attachments.
+    const auto rendering_info = VkPipelineRenderingCreateInfoKHR{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .pNext = nullptr,
+        .viewMask = 0,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &p_base_info.color_format,
+        .depthAttachmentFormat = p_base_info.depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED};
 
     const auto create_info = VkGraphicsPipelineCreateInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext = nullptr,
+        .pNext = p_base_info.render_pass == VK_NULL_HANDLE ? &rendering_info
+                                                           : nullptr,
         .flags = 0,
         .stageCount = static_cast<uint32_t>(shader_stages.size()),
         .pStages = shader_stages.data(),
@@ -854,70 +1386,156 @@ auto create_graphics_pipeline(VkDevice p_device, VkExtent2D p_swap_chain_extent,
         .pViewportState = &viewport_state,
         .pRasterizationState = &rasterization,
         .pMultisampleState = &multisampling,
-        .pDepthStencilState = nullptr,
+        .pDepthStencilState = has_depth ? &depth_stencil_state : nullptr,
         .pColorBlendState = &color_blending,
         .pDynamicState = &dynamic_state,
-        .layout = pipeline_layout,
-        .renderPass = p_render_pass,
+        .layout = p_base_info.layout,
+        .renderPass = p_base_info.render_pass,
         .subpass = 0,
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex = 0};
 
     auto pipeline = static_cast<VkPipeline>(VK_NULL_HANDLE);
     const auto result = vkCreateGraphicsPipelines(
-        p_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pipeline);
+        p_device, p_pipeline_cache, 1, &create_info, nullptr, &pipeline);
     if (result != VK_SUCCESS)
     {
-        fmt::print("[FATAL ERROR]: Failed to create the graphics pipeline. "
-                   "Vulkan error {}.\n",
+        fmt::print(stderr,
+                   "[ERROR]: Failed to create the graphics pipeline. Vulkan "
+                   "error {}.\n",
                    result);
-        std::exit(EXIT_FAILURE);
+        return VK_NULL_HANDLE;
     }
 
-    vkDestroyShaderModule(p_device, vertex_shader_module, nullptr);
-    vkDestroyShaderModule(p_device, fragment_shader_module, nullptr);
-
-    return {pipeline, pipeline_layout};
+    return pipeline;
 }
 
-auto create_render_pass(VkFormat p_format, VkDevice p_device) -> VkRenderPass
+auto create_pipeline_cache(VkDevice p_device) -> unique_pipeline_cache_t
 {
-    const auto color_attachment = VkAttachmentDescription{
-        .format = p_format,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
-
-    const auto color_attachment_reference = VkAttachmentReference{
-        .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
-
-    const auto subpass = VkSubpassDescription{
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &color_attachment_reference};
-
-    const auto dependency = VkSubpassDependency{
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT};
+    const auto create_info = VkPipelineCacheCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .initialDataSize = 0,
+        .pInitialData = nullptr};
 
+    auto pipeline_cache = static_cast<VkPipelineCache>(VK_NULL_HANDLE);
+    const auto result =
+        vkCreatePipelineCache(p_device, &create_info, nullptr, &pipeline_cache);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the pipeline cache. Vulkan "
+                   "error {}\n",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    return unique_pipeline_cache_t(pipeline_cache, {p_device});
+}
+
+// Builds the common pipeline variants in parallel, and returns a library that
+// compiles any others on demand. The shader modules are loaded once, shared by
+// all of the workers, and kept alive for as long as the library can still
+// compile from them. Returns nullptr if the shaders can't be loaded.
+auto build_pipeline_variants(
+    VkDevice p_device, const pipeline_base_info_t& p_base_info,
+    VkPipelineCache p_pipeline_cache, thread_pool_t& p_thread_pool,
+    pipeline_variant_library_t::compiled_function_t p_on_compiled = nullptr)
+    -> std::unique_ptr<pipeline_variant_library_t>
+{
+    const auto vertex_shader_code = load_binary_file("shaders/shader.vert.spv");
+    const auto fragment_shader_code =
+        load_binary_file("shaders/shader.frag.spv");
+    if (vertex_shader_code.empty() || fragment_shader_code.empty())
+    {
+        return nullptr;
+    }
+
+    struct shader_modules_t
+    {
+        unique_shader_module_t vertex;
+        unique_shader_module_t fragment;
+    };
+
+    const auto shader_modules = std::make_shared<shader_modules_t>(
+        shader_modules_t{
+            .vertex = create_shader_module(p_device, vertex_shader_code),
+            .fragment = create_shader_module(p_device, fragment_shader_code)});
+
+    auto pipelines = std::make_unique<pipeline_variant_library_t>(
+        p_device, p_pipeline_cache, p_thread_pool, get_all_pipeline_variants(),
+        [p_device, p_base_info,
+         shader_modules](const pipeline_variant_key_t& p_variant,
+                         VkPipelineCache p_pipeline_cache) {
+            return create_graphics_pipeline(
+                p_device, p_base_info, shader_modules->vertex.get(),
+                shader_modules->fragment.get(), p_pipeline_cache, p_variant);
+        },
+        std::move(p_on_compiled));
+
+    return pipelines;
+}
+
+// p_load_op only changes what happens to the image's previous contents, so
+// render passes that differ in it are compatible with the same pipelines and
+// framebuffers. If p_depth_format isn't VK_FORMAT_UNDEFINED, the subpass also
+// gets a depth attachment, which is cleared and never stored.
+auto create_render_pass(VkFormat p_format, VkFormat p_depth_format,
+                        VkAttachmentLoadOp p_load_op, VkDevice p_device)
+    -> unique_render_pass_t
+{
+    const auto color_attachment = VkAttachmentDescription{
+        .format = p_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = p_load_op,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    const auto depth_attachment = VkAttachmentDescription{
+        .format = p_depth_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    const auto has_depth = p_depth_format != VK_FORMAT_UNDEFINED;
+    const auto attachments =
+        std::array<VkAttachmentDescription, 2>{color_attachment,
+                                               depth_attachment};
+
+    const auto color_attachment_reference = VkAttachmentReference{
+        .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    const auto depth_attachment_reference = VkAttachmentReference{
+        .attachment = 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    const auto subpass = VkSubpassDescription{
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment_reference,
+        .pDepthStencilAttachment =
+            has_depth ? &depth_attachment_reference : nullptr};
+
+    // The render graph transitions the swap chain image (and the depth
+    // buffer) in and out of the attachment layout and synchronizes it with
+    // the rest of the frame, so the render pass doesn't change layouts and
+    // needs no external dependencies.
     const auto create_info = VkRenderPassCreateInfo{
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .attachmentCount = 1,
-        .pAttachments = &color_attachment,
+        .attachmentCount = has_depth ? 2u : 1u,
+        .pAttachments = attachments.data(),
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency};
+        .dependencyCount = 0,
+        .pDependencies = nullptr};
 
     auto render_pass = static_cast<VkRenderPass>(VK_NULL_HANDLE);
     const auto result =
@@ -930,31 +1548,40 @@ auto create_render_pass(VkFormat p_format, VkDevice p_device) -> VkRenderPass
         std::exit(EXIT_FAILURE);
     }
 
-    return render_pass;
+    return unique_render_pass_t(render_pass, {p_device});
 }
 
+// Every framebuffer shares p_depth_image_view, which is VK_NULL_HANDLE if the
+// render pass has no depth attachment.
 auto create_framebuffers(VkDevice p_device, VkRenderPass p_render_pass,
-                         const std::vector<VkImageView>& p_image_views,
+                         const std::vector<unique_image_view_t>& p_image_views,
+                         VkImageView p_depth_image_view,
                          const VkExtent2D& p_extent)
-    -> std::vector<VkFramebuffer>
+    -> std::vector<unique_framebuffer_t>
 {
-    auto framebuffers = std::vector<VkFramebuffer>(p_image_views.size());
+    auto framebuffers = std::vector<unique_framebuffer_t>();
+    framebuffers.reserve(p_image_views.size());
 
-    for (size_t i = 0; i < framebuffers.size(); i++)
+    for (size_t i = 0; i < p_image_views.size(); i++)
     {
+        const auto attachments = std::array<VkImageView, 2>{
+            p_image_views[i].get(), p_depth_image_view};
+
         const auto create_info = VkFramebufferCreateInfo{
             .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
             .renderPass = p_render_pass,
-            .attachmentCount = 1,
-            .pAttachments = &p_image_views[i],
+            .attachmentCount =
+                p_depth_image_view != VK_NULL_HANDLE ? 2u : 1u,
+            .pAttachments = attachments.data(),
             .width = p_extent.width,
             .height = p_extent.height,
             .layers = 1};
 
+        auto framebuffer = static_cast<VkFramebuffer>(VK_NULL_HANDLE);
         const auto result = vkCreateFramebuffer(p_device, &create_info, nullptr,
-                                                &framebuffers[i]);
+                                                &framebuffer);
         if (result != VK_SUCCESS)
         {
             fmt::print("[FATAL ERROR]: Failed to create framebuffer {}. Vulkan "
@@ -962,13 +1589,247 @@ auto create_framebuffers(VkDevice p_device, VkRenderPass p_render_pass,
                        i, result);
             std::exit(EXIT_FAILURE);
         }
+
+        framebuffers.emplace_back(framebuffer,
+                                  framebuffer_deleter_t{p_device});
     }
 
     return framebuffers;
 }
 
+// D32 where it can be used as a depth attachment, which is nearly everywhere,
+// and D16, which always can, otherwise.
+auto find_depth_format(VkPhysicalDevice p_physical_device) -> VkFormat
+{
+    auto properties = VkFormatProperties{};
+    vkGetPhysicalDeviceFormatProperties(p_physical_device, VK_FORMAT_D32_SFLOAT,
+                                        &properties);
+
+    return (properties.optimalTilingFeatures &
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0
+               ? VK_FORMAT_D32_SFLOAT
+               : VK_FORMAT_D16_UNORM;
+}
+
+// The depth buffer is cleared at the start of every frame and never stored,
+// so it's a transient attachment. On tiled GPUs, it can then live in lazily
+// allocated memory, which stays in tile memory and never takes up any real
+// memory at all. Elsewhere it falls back to ordinary device local memory.
+auto create_depth_buffer(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                         VkFormat p_format, VkExtent2D p_extent)
+    -> depth_buffer_t
+{
+    const auto image_create_info = VkImageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = p_format,
+        .extent = VkExtent3D{.width = p_extent.width,
+                             .height = p_extent.height,
+                             .depth = 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+    auto image = static_cast<VkImage>(VK_NULL_HANDLE);
+    const auto image_result =
+        vkCreateImage(p_device, &image_create_info, nullptr, &image);
+    if (image_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create a depth buffer. Vulkan "
+                   "error {}.\n",
+                   image_result);
+        std::exit(EXIT_FAILURE);
+    }
+    auto image_owner = unique_image_t(image, {p_device});
+
+    auto memory_requirements = VkMemoryRequirements{};
+    vkGetImageMemoryRequirements(p_device, image, &memory_requirements);
+
+    auto memory_type = find_memory_type(
+        p_physical_device, memory_requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+            VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    const auto is_lazily_allocated = memory_type.has_value();
+    if (!is_lazily_allocated)
+    {
+        memory_type = find_memory_type(p_physical_device,
+                                       memory_requirements.memoryTypeBits,
+                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    if (!memory_type.has_value())
+    {
+        fmt::print("[FATAL ERROR]: Failed to find device local memory for a "
+                   "depth buffer.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto allocate_info =
+        VkMemoryAllocateInfo{.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                             .pNext = nullptr,
+                             .allocationSize = memory_requirements.size,
+                             .memoryTypeIndex = *memory_type};
+
+    auto memory = static_cast<VkDeviceMemory>(VK_NULL_HANDLE);
+    const auto allocate_result =
+        vkAllocateMemory(p_device, &allocate_info, nullptr, &memory);
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate memory for a depth "
+                   "buffer. Vulkan error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+    auto memory_owner = unique_device_memory_t(memory, {p_device});
+    vkBindImageMemory(p_device, image, memory, 0);
+
+    const auto view_create_info = VkImageViewCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .image = image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = p_format,
+        .components = VkComponentMapping{.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                         .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                         .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                         .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+        .subresourceRange =
+            VkImageSubresourceRange{.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                                    .baseMipLevel = 0,
+                                    .levelCount = 1,
+                                    .baseArrayLayer = 0,
+                                    .layerCount = 1}};
+
+    auto image_view = static_cast<VkImageView>(VK_NULL_HANDLE);
+    const auto view_result =
+        vkCreateImageView(p_device, &view_create_info, nullptr, &image_view);
+    if (view_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create a depth buffer's image "
+                   "view. Vulkan error {}.\n",
+                   view_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    fmt::print("[INFO]: Created a {}x{} depth buffer in {} memory.\n",
+               p_extent.width, p_extent.height,
+               is_lazily_allocated ? "lazily allocated" : "device local");
+
+    return depth_buffer_t{.image = std::move(image_owner),
+                          .memory = std::move(memory_owner),
+                          .image_view = unique_image_view_t(image_view,
+                                                            {p_device})};
+}
+
+// Everything the overdraw view needs on top of the scene's own pipelines and
+// render targets. The scene is drawn into the view's targets with
+// overdraw.frag in place of shader.frag, so the accumulation pipeline shares
+// the scene's layout and vertex shader.
+struct overdraw_mode_t
+{
+    std::unique_ptr<overdraw_view_t> view;
+
+    // VK_NULL_HANDLE with dynamic rendering.
+    unique_render_pass_t render_pass;
+
+    // One per window, empty with dynamic rendering.
+    std::vector<unique_framebuffer_t> framebuffers;
+
+    unique_pipeline_t pipeline;
+};
+
+// p_base_info describes the scene's pipelines, which the heat map is drawn
+// alongside of, and p_extents has the extent of every window. Returns nullptr
+// if the shaders can't be loaded.
+auto create_overdraw_mode(VkPhysicalDevice p_physical_device,
+                          VkDevice p_device, VkPipelineCache p_pipeline_cache,
+                          const pipeline_base_info_t& p_base_info,
+                          const std::vector<VkExtent2D>& p_extents)
+    -> std::unique_ptr<overdraw_mode_t>
+{
+    const auto vertex_shader_code = load_binary_file("shaders/shader.vert.spv");
+    const auto overdraw_shader_code =
+        load_binary_file("shaders/overdraw.frag.spv");
+    const auto heat_map_vertex_shader_code =
+        load_binary_file("shaders/heat_map.vert.spv");
+    const auto heat_map_fragment_shader_code =
+        load_binary_file("shaders/heat_map.frag.spv");
+    if (vertex_shader_code.empty() || overdraw_shader_code.empty() ||
+        heat_map_vertex_shader_code.empty() ||
+        heat_map_fragment_shader_code.empty())
+    {
+        return nullptr;
+    }
+
+    // The pipelines keep what they need, so the modules can go right after.
+    const auto vertex_shader_module =
+        create_shader_module(p_device, vertex_shader_code);
+    const auto overdraw_shader_module =
+        create_shader_module(p_device, overdraw_shader_code);
+    const auto heat_map_vertex_shader_module =
+        create_shader_module(p_device, heat_map_vertex_shader_code);
+    const auto heat_map_fragment_shader_module =
+        create_shader_module(p_device, heat_map_fragment_shader_code);
+
+    auto view = std::make_unique<overdraw_view_t>(
+        p_physical_device, p_device, p_pipeline_cache,
+        heat_map_vertex_shader_module.get(),
+        heat_map_fragment_shader_module.get(), p_base_info.render_pass,
+        p_base_info.color_format, p_base_info.depth_format, p_extents);
+
+    const auto use_dynamic_rendering =
+        p_base_info.render_pass == VK_NULL_HANDLE;
+    auto render_pass =
+        use_dynamic_rendering
+            ? unique_render_pass_t()
+            : create_render_pass(view->get_format(), VK_FORMAT_UNDEFINED,
+                                 VK_ATTACHMENT_LOAD_OP_CLEAR, p_device);
+    auto framebuffers =
+        use_dynamic_rendering
+            ? std::vector<unique_framebuffer_t>()
+            : create_framebuffers(p_device, render_pass.get(),
+                                  view->get_image_views(), VK_NULL_HANDLE,
+                                  view->get_extent());
+
+    // Every fragment is counted, whether or not it would pass the depth test,
+    // so there's no depth buffer. Back face culling stays on, like in the
+    // default variant.
+    const auto base_info =
+        pipeline_base_info_t{.extent = view->get_extent(),
+                             .render_pass = render_pass.get(),
+                             .color_format = view->get_format(),
+                             .depth_format = VK_FORMAT_UNDEFINED,
+                             .layout = p_base_info.layout};
+    const auto pipeline = create_graphics_pipeline(
+        p_device, base_info, vertex_shader_module.get(),
+        overdraw_shader_module.get(), p_pipeline_cache,
+        pipeline_variant_key_t{.color_mode = color_mode_t::vertex_color,
+                               .cull_mode = VK_CULL_MODE_BACK_BIT,
+                               .blend_mode = blend_mode_t::additive});
+    if (pipeline == VK_NULL_HANDLE)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<overdraw_mode_t>(overdraw_mode_t{
+        .view = std::move(view),
+        .render_pass = std::move(render_pass),
+        .framebuffers = std::move(framebuffers),
+        .pipeline = unique_pipeline_t(pipeline, {p_device})});
+}
+
 auto create_command_pool(VkDevice p_device,
-                         std::uint32_t p_graphics_queue_family) -> VkCommandPool
+                         std::uint32_t p_graphics_queue_family)
+    -> unique_command_pool_t
 {
     const auto create_info = VkCommandPoolCreateInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -988,22 +1849,23 @@ auto create_command_pool(VkDevice p_device,
         std::exit(EXIT_SUCCESS);
     }
 
-    return command_pool;
+    return unique_command_pool_t(command_pool, {p_device});
 }
 
-auto create_command_buffer(VkDevice p_device, VkCommandPool p_pool)
-    -> VkCommandBuffer
+auto create_command_buffers(VkDevice p_device, VkCommandPool p_pool,
+                            std::uint32_t p_count)
+    -> std::vector<VkCommandBuffer>
 {
     const auto allocate_info = VkCommandBufferAllocateInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .pNext = nullptr,
         .commandPool = p_pool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1};
+        .commandBufferCount = p_count};
 
-    auto command_buffer = (VkCommandBuffer)VK_NULL_HANDLE;
-    const auto result =
-        vkAllocateCommandBuffers(p_device, &allocate_info, &command_buffer);
+    auto command_buffers = std::vector<VkCommandBuffer>(p_count);
+    const auto result = vkAllocateCommandBuffers(p_device, &allocate_info,
+                                                 command_buffers.data());
     if (result != VK_SUCCESS)
     {
         fmt::print(stderr,
@@ -1013,91 +1875,214 @@ auto create_command_buffer(VkDevice p_device, VkCommandPool p_pool)
         std::exit(EXIT_SUCCESS);
     }
 
-    return command_buffer;
+    return command_buffers;
 }
 
 // The return values for this function is
 // - buffer
 // - the buffer's memory
-auto create_vertex_buffer(VkPhysicalDevice p_physical_device, VkDevice p_device,
-                          size_t p_size, const vertex_t* p_vertices)
-    -> std::tuple<VkBuffer, VkDeviceMemory>
+// Index buffers are created the same way, with a different p_usage.
+auto create_vertex_buffer(
+    VkPhysicalDevice p_physical_device, VkDevice p_device, size_t p_size,
+    const void* p_contents,
+    VkBufferUsageFlags p_usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+    -> std::tuple<unique_buffer_t, unique_device_memory_t>
 {
-    const auto create_info =
-        VkBufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                           .pNext = nullptr,
-                           .flags = 0,
-                           .size = p_size,
-                           .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                           .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+    auto [buffer, memory] = create_buffer(
+        p_physical_device, p_device, p_size, p_usage,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    auto buffer = (VkBuffer)VK_NULL_HANDLE;
-    const auto result =
-        vkCreateBuffer(p_device, &create_info, nullptr, &buffer);
-    if (result != VK_SUCCESS)
+    auto data = (void*)nullptr;
+    vkMapMemory(p_device, memory.get(), 0, p_size, 0, &data);
+    std::memcpy(data, p_contents, p_size);
+    vkUnmapMemory(p_device, memory.get());
+
+    return {std::move(buffer), std::move(memory)};
+}
+
+auto load_dynamic_rendering_functions(VkDevice p_device)
+    -> dynamic_rendering_functions_t
+{
+    const auto functions = dynamic_rendering_functions_t{
+        .begin_rendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(p_device, "vkCmdBeginRenderingKHR")),
+        .end_rendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(p_device, "vkCmdEndRenderingKHR"))};
+
+    if (functions.begin_rendering == nullptr ||
+        functions.end_rendering == nullptr)
     {
-        fmt::print(stderr, fmt::fg(fmt::color::red),
-                   "[FATAL ERROR]: Failed to create a buffer. Vulkan error {}.",
-                   result);
+        fmt::print("[FATAL ERROR]: Failed to load the VK_KHR_dynamic_rendering "
+                   "functions.\n");
         std::exit(EXIT_FAILURE);
     }
 
-    auto memory_requirements = VkMemoryRequirements{};
-    vkGetBufferMemoryRequirements(p_device, buffer, &memory_requirements);
-
-    auto memory_properties = VkPhysicalDeviceMemoryProperties{};
-    vkGetPhysicalDeviceMemoryProperties(p_physical_device, &memory_properties);
+    return functions;
+}
 
-    const auto properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+auto load_present_wait_function(VkDevice p_device) -> PFN_vkWaitForPresentKHR
+{
+    const auto wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+        vkGetDeviceProcAddr(p_device, "vkWaitForPresentKHR"));
 
-    auto memory_type = (uint32_t)0;
-    for (auto i = (uint32_t)0; i < memory_properties.memoryTypeCount; i++)
+    if (wait_for_present == nullptr)
     {
-        if ((memory_requirements.memoryTypeBits & (1 << i)) &&
-            (memory_properties.memoryTypes[i].propertyFlags & properties) ==
-                properties)
-        {
-            memory_type = i;
-            break;
-        }
+        fmt::print("[FATAL ERROR]: Failed to load vkWaitForPresentKHR.\n");
+        std::exit(EXIT_FAILURE);
     }
 
-    const auto allocate_info =
-        VkMemoryAllocateInfo{.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                             .pNext = nullptr,
-                             .allocationSize = memory_requirements.size,
-                             .memoryTypeIndex = memory_type};
+    return wait_for_present;
+}
 
-    auto memory = (VkDeviceMemory)VK_NULL_HANDLE;
-    const auto result2 =
-        vkAllocateMemory(p_device, &allocate_info, nullptr, &memory);
+// Begins the render pass, or the dynamic rendering instance, that draws into
+// p_render_target.
+auto begin_render_target(
+    VkCommandBuffer p_command_buffer, const render_target_t& p_render_target,
+    const dynamic_rendering_functions_t* p_dynamic_rendering) -> void
+{
+    const auto clear_values = std::array<VkClearValue, 2>{
+        VkClearValue{.color = {{0.0f, 0.0f, 0.0f, 1.0f}}},
+        VkClearValue{.depthStencil = {.depth = 1.0f, .stencil = 0}}};
+    const auto has_depth = p_render_target.depth_image_view != VK_NULL_HANDLE;
+    const auto render_area = VkRect2D{.offset = VkOffset2D{.x = 0, .y = 0},
+                                      .extent = p_render_target.extent};
+
+    if (p_dynamic_rendering == nullptr)
+    {
+        const auto render_pass_begin_info = VkRenderPassBeginInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .pNext = nullptr,
+            .renderPass = p_render_target.render_pass,
+            .framebuffer = p_render_target.framebuffer,
+            .renderArea = render_area,
+            .clearValueCount = has_depth ? 2u : 1u,
+            .pClearValues = clear_values.data()};
+
+        vkCmdBeginRenderPass(p_command_buffer, &render_pass_begin_info,
+                             VK_SUBPASS_CONTENTS_INLINE);
+    }
+    else
+    {
+        const auto color_attachment = VkRenderingAttachmentInfoKHR{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+            .pNext = nullptr,
+            .imageView = p_render_target.image_view,
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .resolveMode = 0,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = p_render_target.load_op,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = clear_values[0]};
+
+        const auto depth_attachment = VkRenderingAttachmentInfoKHR{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+            .pNext = nullptr,
+            .imageView = p_render_target.depth_image_view,
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .resolveMode = 0,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .clearValue = clear_values[1]};
+
+        const auto rendering_info =
+            VkRenderingInfoKHR{.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+                               .pNext = nullptr,
+                               .flags = 0,
+                               .renderArea = render_area,
+                               .layerCount = 1,
+                               .viewMask = 0,
+                               .colorAttachmentCount = 1,
+                               .pColorAttachments = &color_attachment,
+                               .pDepthAttachment =
+                                   has_depth ? &depth_attachment : nullptr,
+                               .pStencilAttachment = nullptr};
+
+        p_dynamic_rendering->begin_rendering(p_command_buffer, &rendering_info);
+    }
+}
 
-    if (result != VK_SUCCESS)
+auto end_render_target(
+    VkCommandBuffer p_command_buffer,
+    const dynamic_rendering_functions_t* p_dynamic_rendering) -> void
+{
+    if (p_dynamic_rendering == nullptr)
     {
-        fmt::print(stderr, fmt::fg(fmt::color::red),
-                   "[FATAL ERROR]: Failed to allocate some GPU memory. Vulkan "
-                   "error {}.\n",
-                   result2);
-        std::exit(EXIT_FAILURE);
+        vkCmdEndRenderPass(p_command_buffer);
+    }
+    else
+    {
+        p_dynamic_rendering->end_rendering(p_command_buffer);
     }
+}
 
-    vkBindBufferMemory(p_device, buffer, memory, 0);
+auto record_draw_pass(VkCommandBuffer p_command_buffer,
+                      const render_target_t& p_render_target,
+                      const dynamic_rendering_functions_t* p_dynamic_rendering,
+                      VkPipelineLayout p_pipeline_layout,
+                      VkDescriptorSet p_frame_set,
+                      std::uint32_t p_frame_uniform_offset,
+                      VkDescriptorSet p_texture_set,
+                      draw_list_t& p_draw_list, VkPipeline p_particle_pipeline,
+                      const geometry_generator_t* p_geometry_generator,
+                      std::uint32_t p_particle_slot)
+{
+    begin_render_target(p_command_buffer, p_render_target,
+                        p_dynamic_rendering);
+
+    // Every pipeline shares the layout and has a dynamic viewport and
+    // scissor, so all of this stays valid across the draw list's binds.
+    const auto descriptor_sets =
+        std::array<VkDescriptorSet, 2>{p_frame_set, p_texture_set};
+    vkCmdBindDescriptorSets(p_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            p_pipeline_layout, 0,
+                            static_cast<std::uint32_t>(descriptor_sets.size()),
+                            descriptor_sets.data(), 1, &p_frame_uniform_offset);
 
-    auto data = (void*)nullptr;
-    vkMapMemory(p_device, memory, 0, p_size, 0, &data);
-    std::memcpy(data, p_vertices, p_size);
-    vkUnmapMemory(p_device, memory);
+    const auto viewport =
+        VkViewport{.x = 0.0f,
+                   .y = 0.0f,
+                   .width = static_cast<float>(p_render_target.extent.width),
+                   .height = static_cast<float>(p_render_target.extent.height),
+                   .minDepth = 0.0f,
+                   .maxDepth = 1.0f};
+    vkCmdSetViewport(p_command_buffer, 0, 1, &viewport);
+
+    const auto scissor = VkRect2D{.offset = VkOffset2D{.x = 0, .y = 0},
+                                  .extent = p_render_target.extent};
+    vkCmdSetScissor(p_command_buffer, 0, 1, &scissor);
 
-    return {buffer, memory};
+    const auto bound_pipeline =
+        p_draw_list.record(p_command_buffer, p_pipeline_layout);
+
+    // The generated vertices are already in clip space.
+    if (p_geometry_generator != nullptr)
+    {
+        if (bound_pipeline != p_particle_pipeline)
+        {
+            vkCmdBindPipeline(p_command_buffer,
+                              VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              p_particle_pipeline);
+        }
+
+        // In front of everything.
+        const auto identity = push_constants_t{.transform = glm::mat2(1.0f),
+                                               .translation = glm::vec2(0.0f),
+                                               .depth = 0.0f,
+                                               .tint = glm::vec4(1.0f)};
+        vkCmdPushConstants(p_command_buffer, p_pipeline_layout,
+                           VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(identity),
+                           &identity);
+        p_geometry_generator->record_draw(p_command_buffer, p_particle_slot);
+    }
+
+    end_render_target(p_command_buffer, p_dynamic_rendering);
 }
 
-auto record_command_buffer(VkCommandBuffer p_command_buffer,
-                           VkRenderPass p_render_pass,
-                           VkFramebuffer p_framebuffer,
-                           const VkExtent2D& p_swap_chain_extent,
-                           VkPipeline p_graphics_pipeline,
-                           VkBuffer p_vertex_buffer)
+auto begin_command_buffer(VkCommandBuffer p_command_buffer) -> void
 {
     const auto begin_info = VkCommandBufferBeginInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -1113,47 +2098,12 @@ auto record_command_buffer(VkCommandBuffer p_command_buffer,
                     result);
         std::exit(EXIT_FAILURE);
     }
+}
 
-    const auto clear_color = VkClearValue{{{0.0f, 0.0f, 0.0f, 1.0f}}};
-
-    const auto render_pass_begin_info = VkRenderPassBeginInfo{
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .pNext = nullptr,
-        .renderPass = p_render_pass,
-        .framebuffer = p_framebuffer,
-        .renderArea = VkRect2D{.offset = VkOffset2D{.x = 0, .y = 0},
-                               .extent = p_swap_chain_extent},
-        .clearValueCount = 1,
-        .pClearValues = &clear_color};
-
-    vkCmdBeginRenderPass(p_command_buffer, &render_pass_begin_info,
-                         VK_SUBPASS_CONTENTS_INLINE);
-
-    vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      p_graphics_pipeline);
-
-    const auto offset = (VkDeviceSize)0;
-    vkCmdBindVertexBuffers(p_command_buffer, 0, 1, &p_vertex_buffer, &offset);
-
-    const auto viewport =
-        VkViewport{.x = 0.0f,
-                   .y = 0.0f,
-                   .width = static_cast<float>(p_swap_chain_extent.width),
-                   .height = static_cast<float>(p_swap_chain_extent.height),
-                   .minDepth = 0.0f,
-                   .maxDepth = 1.0f};
-    vkCmdSetViewport(p_command_buffer, 0, 1, &viewport);
-
-    const auto scissor = VkRect2D{.offset = VkOffset2D{.x = 0, .y = 0},
-                                  .extent = p_swap_chain_extent};
-    vkCmdSetScissor(p_command_buffer, 0, 1, &scissor);
-
-    vkCmdDraw(p_command_buffer, 3, 1, 0, 0);
-
-    vkCmdEndRenderPass(p_command_buffer);
-
-    const auto end_result = vkEndCommandBuffer(p_command_buffer);
-    if (end_result != VK_SUCCESS)
+auto end_command_buffer(VkCommandBuffer p_command_buffer) -> void
+{
+    const auto result = vkEndCommandBuffer(p_command_buffer);
+    if (result != VK_SUCCESS)
     {
         print_error("[FATAL ERROR]: Failed to stop recording the command "
                     "buffer. Vulkan error {}.\n",
@@ -1162,214 +2112,2352 @@ auto record_command_buffer(VkCommandBuffer p_command_buffer,
     }
 }
 
-// Return values
-// 2 semaphores
-// 1 fence
-auto create_sync_objects(VkDevice p_device)
-    -> std::tuple<VkSemaphore, VkSemaphore, VkFence>
+// Passing nullptr for p_dynamic_rendering records the render pass path. The
+// objects are drawn from p_draw_list, which is sorted by state first.
+// p_frame_uniform_offset is the dynamic offset of this frame's slot in the
+// uniform ring that p_frame_set points at, and p_texture_set is the texture's
+// current set. If p_geometry_generator isn't
+// nullptr, the particles in p_particle_slot are drawn after the objects, with
+// p_particle_pipeline. The submit has to wait for the compute work that
+// generated them.
+//
+// If p_overdraw_mode isn't nullptr, the objects and particles are counted into
+// the overdraw view's target for p_output_index instead, which is read back
+// and drawn onto p_render_target as a heat map. p_draw_list and
+// p_particle_pipeline then have to use the overdraw mode's pipeline.
+//
+// The frame is declared as passes on p_render_graph, which works out the
+// barriers and layout transitions between them. p_command_buffer has to be
+// recording already.
+auto record_command_buffer(
+    VkCommandBuffer p_command_buffer, const render_target_t& p_render_target,
+    const dynamic_rendering_functions_t* p_dynamic_rendering,
+    VkPipelineLayout p_pipeline_layout, VkDescriptorSet p_frame_set,
+    std::uint32_t p_frame_uniform_offset, VkDescriptorSet p_texture_set,
+    draw_list_t& p_draw_list, VkPipeline p_particle_pipeline,
+    const geometry_generator_t* p_geometry_generator,
+    std::uint32_t p_particle_slot, const overdraw_mode_t* p_overdraw_mode,
+    std::uint32_t p_output_index, render_graph_t& p_render_graph,
+    std::uint64_t p_frame_number)
 {
-    const auto semaphore_create_info =
-        VkSemaphoreCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-
-    const auto fence_create_info =
-        VkFenceCreateInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                          .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+    // The image's old contents are discarded. The initial stage matches the
+    // stage that the image available semaphore is waited on at, and
+    // presentation waits on a semaphore, so it needs no destination stage.
+    const auto backbuffer = p_render_graph.import_image(
+        "backbuffer", p_render_target.image, p_render_target.image_view,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        render_graph_state_t{
+            .stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .access = 0,
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED},
+        render_graph_state_t{.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             .access = 0,
+                             .layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
+
+    auto draw_uses = std::vector<render_graph_use_t>{render_graph_use_t{
+        .resource = backbuffer,
+        .access = render_graph_access_t::color_attachment_write}};
+
+    // Cleared by the pass, so whatever it held before is discarded, and
+    // nothing after the pass needs it.
+    if (p_render_target.depth_image != VK_NULL_HANDLE)
+    {
+        draw_uses.push_back(render_graph_use_t{
+            .resource = p_render_graph.import_image(
+                "depth buffer", p_render_target.depth_image,
+                p_render_target.depth_image_view, VK_IMAGE_ASPECT_DEPTH_BIT,
+                render_graph_state_t{
+                    .stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                    .access = 0,
+                    .layout = VK_IMAGE_LAYOUT_UNDEFINED},
+                std::nullopt),
+            .access = render_graph_access_t::depth_attachment_write});
+    }
 
-    auto semaphore1 = (VkSemaphore)VK_NULL_HANDLE,
-         semaphore2 = (VkSemaphore)VK_NULL_HANDLE;
-    auto fence = (VkFence)VK_NULL_HANDLE;
+    // Whichever pass draws the scene reads the particles.
+    auto scene_uses = std::vector<render_graph_use_t>();
 
-    const auto results = std::array<VkResult, 3>{
-        vkCreateSemaphore(p_device, &semaphore_create_info, nullptr,
-                          &semaphore1),
-        vkCreateSemaphore(p_device, &semaphore_create_info, nullptr,
-                          &semaphore2),
-        vkCreateFence(p_device, &fence_create_info, nullptr, &fence)};
+    // The compute queue's writes are made visible by the semaphore wait, so
+    // these only need declaring for the graph's benefit.
+    if (p_geometry_generator != nullptr)
+    {
+        scene_uses.push_back(render_graph_use_t{
+            .resource = p_render_graph.import_buffer(
+                "particle vertices",
+                p_geometry_generator->get_vertex_buffer(p_particle_slot)),
+            .access = render_graph_access_t::vertex_buffer_read});
+        scene_uses.push_back(render_graph_use_t{
+            .resource = p_render_graph.import_buffer(
+                "particle draw command",
+                p_geometry_generator->get_draw_command_buffer(
+                    p_particle_slot)),
+            .access = render_graph_access_t::indirect_buffer_read});
+    }
 
-    for (const auto& result : results)
+    if (p_overdraw_mode == nullptr)
     {
-        if (result != VK_SUCCESS)
-        {
-            print_error("[FATAL ERROR]: Failed to create synchronization "
-                        "objects for Vulkan. Vulkan error {}",
-                        result);
-            std::exit(EXIT_FAILURE);
-        }
+        draw_uses.insert(draw_uses.end(), scene_uses.begin(),
+                         scene_uses.end());
+        p_render_graph.add_pass(
+            "draw", std::move(draw_uses),
+            [&](VkCommandBuffer p_pass_command_buffer) {
+                record_draw_pass(p_pass_command_buffer, p_render_target,
+                                 p_dynamic_rendering, p_pipeline_layout,
+                                 p_frame_set, p_frame_uniform_offset,
+                                 p_texture_set, p_draw_list,
+                                 p_particle_pipeline, p_geometry_generator,
+                                 p_particle_slot);
+            });
+
+        p_render_graph.execute(p_command_buffer, p_frame_number);
+        return;
     }
 
-    return {semaphore1, semaphore2, fence};
+    auto& view = *p_overdraw_mode->view;
+    const auto overdraw_render_target = render_target_t{
+        .render_pass = p_overdraw_mode->render_pass.get(),
+        .framebuffer =
+            p_overdraw_mode->framebuffers.empty()
+                ? static_cast<VkFramebuffer>(VK_NULL_HANDLE)
+                : p_overdraw_mode->framebuffers[p_output_index].get(),
+        .image = view.get_image(p_output_index),
+        .image_view = view.get_image_views()[p_output_index].get(),
+        .extent = p_render_target.extent,
+        .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .depth_image = VK_NULL_HANDLE,
+        .depth_image_view = VK_NULL_HANDLE};
+
+    // Cleared to zero by the pass, and only read within the frame.
+    const auto overdraw_image = p_render_graph.import_image(
+        "overdraw", overdraw_render_target.image,
+        overdraw_render_target.image_view, VK_IMAGE_ASPECT_COLOR_BIT,
+        render_graph_state_t{
+            .stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .access = 0,
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED},
+        std::nullopt);
+
+    scene_uses.push_back(render_graph_use_t{
+        .resource = overdraw_image,
+        .access = render_graph_access_t::color_attachment_write});
+    p_render_graph.add_pass(
+        "overdraw", std::move(scene_uses),
+        [&](VkCommandBuffer p_pass_command_buffer) {
+            record_draw_pass(p_pass_command_buffer, overdraw_render_target,
+                             p_dynamic_rendering, p_pipeline_layout,
+                             p_frame_set, p_frame_uniform_offset,
+                             p_texture_set, p_draw_list, p_particle_pipeline,
+                             p_geometry_generator, p_particle_slot);
+        });
+
+    // Nothing on the GPU reads the buffer, so this pass would be culled if it
+    // didn't have side effects.
+    p_render_graph.add_pass(
+        "overdraw readback",
+        {render_graph_use_t{.resource = overdraw_image,
+                            .access = render_graph_access_t::transfer_read},
+         render_graph_use_t{
+             .resource = p_render_graph.import_buffer(
+                 "overdraw readback",
+                 view.get_readback_buffer(p_output_index)),
+             .access = render_graph_access_t::transfer_write}},
+        [&](VkCommandBuffer p_pass_command_buffer) {
+            view.record_readback(p_pass_command_buffer, p_output_index);
+        },
+        true);
+
+    draw_uses.push_back(render_graph_use_t{
+        .resource = overdraw_image,
+        .access = render_graph_access_t::fragment_sampled_read});
+    p_render_graph.add_pass(
+        "heat map", std::move(draw_uses),
+        [&](VkCommandBuffer p_pass_command_buffer) {
+            begin_render_target(p_pass_command_buffer, p_render_target,
+                                p_dynamic_rendering);
+            view.record_heat_map(p_pass_command_buffer, p_output_index);
+            end_render_target(p_pass_command_buffer, p_dynamic_rendering);
+        });
+
+    p_render_graph.execute(p_command_buffer, p_frame_number);
 }
 
-// The actual main function
-int real_main()
+// Records the compute work that generates p_slot's particles for p_time. The
+// command buffer may belong to either the compute or the graphics queue, and
+// p_frame_number is the frame that draws the result.
+auto record_particle_generation(VkCommandBuffer p_command_buffer,
+                                const geometry_generator_t& p_generator,
+                                std::uint32_t p_slot, float p_time,
+                                render_graph_t& p_render_graph,
+                                std::uint64_t p_frame_number)
 {
-    if (!glfwInit())
+    const auto particle_vertices = p_render_graph.import_buffer(
+        "particle vertices", p_generator.get_vertex_buffer(p_slot));
+    const auto particle_draw_command = p_render_graph.import_buffer(
+        "particle draw command", p_generator.get_draw_command_buffer(p_slot));
+
+    p_render_graph.add_pass(
+        "reset particle count",
+        {render_graph_use_t{.resource = particle_draw_command,
+                            .access = render_graph_access_t::transfer_write}},
+        [&p_generator, p_slot](VkCommandBuffer p_pass_command_buffer) {
+            p_generator.record_reset(p_pass_command_buffer, p_slot);
+        });
+
+    // Nothing in this graph reads the particles, so the pass is kept alive
+    // by declaring its side effects.
+    const auto read_write = render_graph_access_t::compute_storage_read_write;
+    p_render_graph.add_pass(
+        "generate particles",
+        {render_graph_use_t{.resource = particle_draw_command,
+                            .access = read_write},
+         render_graph_use_t{
+             .resource = particle_vertices,
+             .access = render_graph_access_t::compute_storage_write}},
+        [&p_generator, p_slot, p_time](VkCommandBuffer p_pass_command_buffer) {
+            p_generator.record_dispatch(p_pass_command_buffer, p_slot, p_time);
+        },
+        true);
+
+    p_render_graph.execute(p_command_buffer, p_frame_number);
+}
+
+// Lays the objects out in a grid, each one spinning at its own rate. A single
+// object is left untransformed, which gives the original triangle. With
+// p_overdraw above 1, the objects grow by its square root, so that each one
+// covers about that many cells. Later objects are nearer, so that with a
+// depth buffer they end up on top, just like when they're drawn in order.
+auto animate_objects(std::uint32_t p_object_count, std::uint32_t p_overdraw,
+                     float p_time, std::vector<push_constants_t>& p_draws)
+{
+    p_draws.resize(p_object_count);
+
+    if (p_object_count == 1)
     {
-        fmt::print("[FATAL ERROR]: Failed to initialize GLFW.\n");
-        return EXIT_FAILURE;
+        p_draws[0] = push_constants_t{.transform = glm::mat2(1.0f),
+                                      .translation = glm::vec2(0.0f),
+                                      .depth = 0.5f,
+                                      .tint = glm::vec4(1.0f)};
+        return;
     }
 
-    const VkInstance instance = create_instance();
+    const auto columns = static_cast<std::uint32_t>(
+        std::ceil(std::sqrt(static_cast<float>(p_object_count))));
+    const auto cell_size = 2.0f / static_cast<float>(columns);
 
-    VkDebugUtilsMessengerEXT debug_messenger;
-    if (ENABLE_VALIDATION)
+    for (auto i = static_cast<std::uint32_t>(0); i < p_object_count; i++)
     {
-        debug_messenger = create_debug_messenger(instance);
+        const auto column = static_cast<float>(i % columns);
+        const auto row = static_cast<float>(i / columns);
+
+        const auto angle = p_time * (0.5f + 0.1f * static_cast<float>(i % 7));
+        const auto scale =
+            cell_size * 0.9f * std::sqrt(static_cast<float>(p_overdraw));
+
+        const auto cos_angle = std::cos(angle) * scale;
+        const auto sin_angle = std::sin(angle) * scale;
+
+        p_draws[i] = push_constants_t{
+            .transform = glm::mat2(cos_angle, sin_angle, -sin_angle, cos_angle),
+            .translation = glm::vec2(-1.0f + (column + 0.5f) * cell_size,
+                                     -1.0f + (row + 0.5f) * cell_size),
+            .depth = 1.0f - static_cast<float>(i + 1) /
+                                static_cast<float>(p_object_count + 1),
+            .tint = glm::vec4(0.5f + 0.5f * std::sin(p_time + column),
+                              0.5f + 0.5f * std::sin(p_time + row), 1.0f,
+                              1.0f)};
     }
+}
 
-    glfwSetErrorCallback(glfw_error_callback);
-
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+auto create_semaphore(VkDevice p_device) -> unique_semaphore_t
+{
+    const auto create_info =
+        VkSemaphoreCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
 
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
-                                          "Vulkan Triangle", nullptr, nullptr);
-    if (window == nullptr)
+    auto semaphore = (VkSemaphore)VK_NULL_HANDLE;
+    const auto result =
+        vkCreateSemaphore(p_device, &create_info, nullptr, &semaphore);
+    if (result != VK_SUCCESS)
     {
-        fmt::print("[FATAL ERROR]: Failed to create the GLFW window.\n");
-        glfwTerminate();
-        return EXIT_FAILURE;
+        print_error("[FATAL ERROR]: Failed to create a semaphore. Vulkan "
+                    "error {}",
+                    result);
+        std::exit(EXIT_FAILURE);
     }
 
-    const VkSurfaceKHR surface = create_surface(instance, window);
-    const VkPhysicalDevice physical_device =
-        pick_physical_device(instance, surface);
+    return unique_semaphore_t(semaphore, {p_device});
+}
 
-    const auto [graphics_queue_family_opt, present_queue_family_opt] =
-        find_queue_families(physical_device, surface);
-    const auto graphics_queue_family = graphics_queue_family_opt.value();
-    const auto present_queue_family = present_queue_family_opt.value();
+// Created signaled, so that the first wait on it returns straight away.
+auto create_fence(VkDevice p_device) -> unique_fence_t
+{
+    const auto fence_create_info =
+        VkFenceCreateInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                          .flags = VK_FENCE_CREATE_SIGNALED_BIT};
 
-    const auto [device, graphics_queue, present_queue] = create_logical_device(
-        physical_device, graphics_queue_family, present_queue_family);
+    auto fence = (VkFence)VK_NULL_HANDLE;
+    const auto result =
+        vkCreateFence(p_device, &fence_create_info, nullptr, &fence);
+    if (result != VK_SUCCESS)
+    {
+        print_error("[FATAL ERROR]: Failed to create synchronization "
+                    "objects for Vulkan. Vulkan error {}",
+                    result);
+        std::exit(EXIT_FAILURE);
+    }
 
-    const auto [swap_chain, swap_chain_images, swap_chain_format,
-                swap_chain_extent] =
-        create_swap_chain(physical_device, surface, window,
-                          graphics_queue_family, present_queue_family, device);
+    return unique_fence_t(fence, {p_device});
+}
 
-    const auto swap_chain_image_views =
-        create_image_views(device, swap_chain_images, swap_chain_format);
+// Return values
+// 1 semaphore
+// 1 fence
+auto create_sync_objects(VkDevice p_device)
+    -> std::tuple<unique_semaphore_t, unique_fence_t>
+{
+    return {create_semaphore(p_device), create_fence(p_device)};
+}
 
-    const auto render_pass = create_render_pass(swap_chain_format, device);
+// Service jobs are rendered into a plain image rather than a swap chain. The
+// sRGB format matches what the windows present, so the files look the same.
+constexpr auto SERVICE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+constexpr auto SERVICE_BYTES_PER_PIXEL = VkDeviceSize{4};
 
-    const auto [graphics_pipeline, pipeline_layout] =
-        create_graphics_pipeline(device, swap_chain_extent, render_pass);
+// The animation time step between the frames of a single job.
+constexpr auto SERVICE_FRAME_RATE = 60.0f;
 
-    const auto swap_chain_framebuffers = create_framebuffers(
-        device, render_pass, swap_chain_image_views, swap_chain_extent);
+// Small jobs are batched into one submit, up to this many.
+constexpr auto SERVICE_MAX_JOBS_PER_BATCH = std::size_t{8};
 
-    const auto command_pool =
-        create_command_pool(device, graphics_queue_family);
+// The software rasterizer has no device limit, so it uses the one that most
+// GPUs have.
+constexpr auto SOFTWARE_MAX_EXTENT = std::uint32_t{16384};
 
-    const auto command_buffer = create_command_buffer(device, command_pool);
+// The triangle split into 4^p_level smaller ones, with the positions and
+// colors interpolated. With the same winding, it covers the same pixels with
+// the same colors, just with a lot more work for the vertex stage and the
+// rasterizer.
+auto subdivide_triangle(const std::array<vertex_t, 3>& p_triangle,
+                        std::uint32_t p_level) -> std::vector<vertex_t>
+{
+    const auto divisions = std::uint32_t{1} << p_level;
+
+    // The vertex at i steps along the first edge and j along the second.
+    const auto get_vertex = [&](std::uint32_t p_i, std::uint32_t p_j) {
+        const auto u = static_cast<float>(p_i) / static_cast<float>(divisions);
+        const auto v = static_cast<float>(p_j) / static_cast<float>(divisions);
+        const auto w = 1.0f - u - v;
+        return vertex_t{w * p_triangle[0].position +
+                            u * p_triangle[1].position +
+                            v * p_triangle[2].position,
+                        w * p_triangle[0].color + u * p_triangle[1].color +
+                            v * p_triangle[2].color};
+    };
 
-    const auto vertices = std::array<vertex_t, 3>{
-        vertex_t{glm::vec2{0.0f, -0.5f}, glm::vec3{1.0f, 0.0f, 0.0f}},
-        vertex_t{glm::vec2{0.5f, 0.5f}, glm::vec3{0.0f, 1.0f, 0.0f}},
-        vertex_t{glm::vec2{-0.5f, 0.5f}, glm::vec3{0.0f, 0.0f, 1.0f}}};
+    auto vertices = std::vector<vertex_t>();
+    vertices.reserve(static_cast<std::size_t>(divisions) * divisions * 3);
 
-    const auto [vertex_buffer, vertex_buffer_memory] = create_vertex_buffer(
-        physical_device, device, vertices.size() * sizeof(vertex_t),
-        vertices.data());
+    for (auto j = std::uint32_t{0}; j < divisions; j++)
+    {
+        for (auto i = std::uint32_t{0}; i + j < divisions; i++)
+        {
+            vertices.push_back(get_vertex(i, j));
+            vertices.push_back(get_vertex(i + 1, j));
+            vertices.push_back(get_vertex(i, j + 1));
+
+            if (i + j + 1 < divisions)
+            {
+                vertices.push_back(get_vertex(i + 1, j));
+                vertices.push_back(get_vertex(i + 1, j + 1));
+                vertices.push_back(get_vertex(i, j + 1));
+            }
+        }
+    }
+
+    return vertices;
+}
 
-    const auto [image_available_semaphore, render_finished_semaphore,
-                in_flight_fence] = create_sync_objects(device);
+// The triangle subdivided to some level, in vertex and index buffers of its
+// own.
+struct mesh_t
+{
+    unique_buffer_t vertex_buffer;
+    unique_device_memory_t vertex_buffer_memory;
+    unique_buffer_t index_buffer;
+    unique_device_memory_t index_buffer_memory;
+    std::uint32_t index_count;
+};
 
-    glfwShowWindow(window);
+// The subdivided triangles share their corners, so they're welded into an
+// indexed mesh. If p_optimize is set, the triangles are then reordered for
+// the post-transform vertex cache, and the vertices for fetch locality. The
+// row by row order that they're generated in is already fairly cache
+// friendly, but loses everything at the end of each row once the rows get
+// longer than the cache.
+auto create_mesh(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                 std::uint32_t p_subdivisions, bool p_optimize) -> mesh_t
+{
+    auto mesh = weld_vertices(
+        subdivide_triangle(get_triangle_vertices(), p_subdivisions));
 
-    while (!glfwWindowShouldClose(window))
+    const auto before = analyze_vertex_cache(
+        mesh.indices, static_cast<std::uint32_t>(mesh.vertices.size()));
+    if (p_optimize)
     {
-        vkWaitForFences(device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
-        vkResetFences(device, 1, &in_flight_fence);
+        const auto start_time = std::chrono::steady_clock::now();
+        optimize_vertex_cache(mesh.indices,
+                              static_cast<std::uint32_t>(mesh.vertices.size()));
+        optimize_vertex_fetch(mesh);
+        const auto duration = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time);
+
+        const auto after = analyze_vertex_cache(
+            mesh.indices, static_cast<std::uint32_t>(mesh.vertices.size()));
+        fmt::print("[INFO]: Optimized the level {} mesh ({} vertices, {} "
+                   "triangles) in {:.2f} ms. ACMR went from {:.3f} to {:.3f} "
+                   "and ATVR from {:.3f} to {:.3f}.\n",
+                   p_subdivisions, mesh.vertices.size(),
+                   mesh.indices.size() / 3, duration.count(), before.acmr,
+                   after.acmr, before.atvr, after.atvr);
+    }
+    else
+    {
+        fmt::print("[INFO]: The level {} mesh ({} vertices, {} triangles) has "
+                   "an ACMR of {:.3f} and an ATVR of {:.3f}.\n",
+                   p_subdivisions, mesh.vertices.size(),
+                   mesh.indices.size() / 3, before.acmr, before.atvr);
+    }
 
-        auto image_index = (uint32_t)0;
-        vkAcquireNextImageKHR(device, swap_chain, UINT64_MAX,
-                              image_available_semaphore, VK_NULL_HANDLE,
-                              &image_index);
+    auto [vertex_buffer, vertex_buffer_memory] = create_vertex_buffer(
+        p_physical_device, p_device, mesh.vertices.size() * sizeof(vertex_t),
+        mesh.vertices.data());
+    auto [index_buffer, index_buffer_memory] = create_vertex_buffer(
+        p_physical_device, p_device,
+        mesh.indices.size() * sizeof(std::uint32_t), mesh.indices.data(),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    return mesh_t{
+        .vertex_buffer = std::move(vertex_buffer),
+        .vertex_buffer_memory = std::move(vertex_buffer_memory),
+        .index_buffer = std::move(index_buffer),
+        .index_buffer_memory = std::move(index_buffer_memory),
+        .index_count = static_cast<std::uint32_t>(mesh.indices.size())};
+}
+
+// What a service job renders into: an offscreen image, and a host visible
+// buffer with room for every frame of the job, which stays mapped.
+struct service_target_t
+{
+    VkExtent2D extent;
+    std::uint32_t frame_capacity;
+
+    unique_image_t image;
+    unique_device_memory_t image_memory;
+    std::vector<unique_image_view_t> image_views;
+    std::vector<unique_framebuffer_t> framebuffers;
 
-        vkResetCommandBuffer(command_buffer, 0);
-        record_command_buffer(
-            command_buffer, render_pass, swap_chain_framebuffers[image_index],
-            swap_chain_extent, graphics_pipeline, vertex_buffer);
+    unique_buffer_t readback_buffer;
+    unique_device_memory_t readback_memory;
+    const std::byte* readback_data;
 
-        const auto wait_stages = raw_array<VkPipelineStageFlags, 1>{
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    std::unique_ptr<render_graph_t> render_graph;
+};
 
-        const auto submit_info =
-            VkSubmitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                         .waitSemaphoreCount = 1,
-                         .pWaitSemaphores = &image_available_semaphore,
-                         .pWaitDstStageMask = wait_stages,
-                         .commandBufferCount = 1,
-                         .pCommandBuffers = &command_buffer,
-                         .signalSemaphoreCount = 1,
-                         .pSignalSemaphores = &render_finished_semaphore};
+// One submit's worth of jobs. There are two of these, so that one batch can
+// be rendered while the previous one is read back and written out. The
+// targets are kept from batch to batch, and only replaced when a job needs a
+// different size.
+struct service_batch_t
+{
+    VkCommandBuffer command_buffer;
+    unique_fence_t fence;
+    std::vector<render_job_t> jobs;
+    std::vector<service_target_t> targets;
+    std::uint64_t number;
+    bool in_flight;
+};
 
-        const auto submit_result =
-            vkQueueSubmit(graphics_queue, 1, &submit_info, in_flight_fence);
+auto create_service_target(VkPhysicalDevice p_physical_device,
+                           VkDevice p_device, VkRenderPass p_render_pass,
+                           VkExtent2D p_extent, std::uint32_t p_frame_count,
+                           deletion_queue_t& p_deletion_queue)
+    -> service_target_t
+{
+    const auto image_create_info = VkImageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = SERVICE_FORMAT,
+        .extent = VkExtent3D{.width = p_extent.width,
+                             .height = p_extent.height,
+                             .depth = 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
 
-        const auto present_info =
-            VkPresentInfoKHR{.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+    auto image = static_cast<VkImage>(VK_NULL_HANDLE);
+    const auto image_result =
+        vkCreateImage(p_device, &image_create_info, nullptr, &image);
+    if (image_result != VK_SUCCESS)
+    {
+        print_error("[FATAL ERROR]: Failed to create a render service image. "
+                    "Vulkan error {}.\n",
+                    image_result);
+        std::exit(EXIT_FAILURE);
+    }
+    auto image_owner = unique_image_t(image, {p_device});
+
+    auto memory_requirements = VkMemoryRequirements{};
+    vkGetImageMemoryRequirements(p_device, image, &memory_requirements);
+
+    const auto memory_type =
+        find_memory_type(p_physical_device, memory_requirements.memoryTypeBits,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!memory_type.has_value())
+    {
+        fmt::print("[FATAL ERROR]: Failed to find device local memory for a "
+                   "render service image.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto allocate_info =
+        VkMemoryAllocateInfo{.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
                              .pNext = nullptr,
-                             .waitSemaphoreCount = 1,
-                             .pWaitSemaphores = &render_finished_semaphore,
-                             .swapchainCount = 1,
-                             .pSwapchains = &swap_chain,
-                             .pImageIndices = &image_index,
-                             .pResults = nullptr};
+                             .allocationSize = memory_requirements.size,
+                             .memoryTypeIndex = *memory_type};
 
-        vkQueuePresentKHR(present_queue, &present_info);
+    auto image_memory = static_cast<VkDeviceMemory>(VK_NULL_HANDLE);
+    const auto allocate_result =
+        vkAllocateMemory(p_device, &allocate_info, nullptr, &image_memory);
+    if (allocate_result != VK_SUCCESS)
+    {
+        print_error("[FATAL ERROR]: Failed to allocate memory for a render "
+                    "service image. Vulkan error {}.\n",
+                    allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+    auto image_memory_owner = unique_device_memory_t(image_memory, {p_device});
+    vkBindImageMemory(p_device, image, image_memory, 0);
+
+    auto image_views = create_image_views(
+        p_device, std::vector<VkImage>{image}, SERVICE_FORMAT);
+    auto framebuffers =
+        p_render_pass != VK_NULL_HANDLE
+            ? create_framebuffers(p_device, p_render_pass, image_views,
+                                  VK_NULL_HANDLE, p_extent)
+            : std::vector<unique_framebuffer_t>();
+
+    const auto readback_size = static_cast<VkDeviceSize>(p_extent.width) *
+                               p_extent.height * SERVICE_BYTES_PER_PIXEL *
+                               p_frame_count;
+    auto [readback_buffer, readback_memory] = create_buffer(
+        p_physical_device, p_device, readback_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Unmapped when the memory is freed.
+    auto readback_data = static_cast<void*>(nullptr);
+    vkMapMemory(p_device, readback_memory.get(), 0, readback_size, 0,
+                &readback_data);
+
+    return service_target_t{
+        .extent = p_extent,
+        .frame_capacity = p_frame_count,
+        .image = std::move(image_owner),
+        .image_memory = std::move(image_memory_owner),
+        .image_views = std::move(image_views),
+        .framebuffers = std::move(framebuffers),
+        .readback_buffer = std::move(readback_buffer),
+        .readback_memory = std::move(readback_memory),
+        .readback_data = static_cast<const std::byte*>(readback_data),
+        .render_graph = std::make_unique<render_graph_t>(
+            p_physical_device, p_device, p_deletion_queue)};
+}
 
-        if (submit_result != VK_SUCCESS)
+// Writes tightly packed RGBA8 pixels as a binary PPM, dropping the alpha.
+auto write_ppm(const std::filesystem::path& p_path, const std::byte* p_pixels,
+               VkExtent2D p_extent) -> bool
+{
+    auto file = std::ofstream(p_path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << fmt::format("P6\n{} {}\n255\n", p_extent.width, p_extent.height);
+
+    auto row = std::vector<char>(static_cast<std::size_t>(p_extent.width) * 3);
+    for (auto y = std::uint32_t{0}; y < p_extent.height; y++)
+    {
+        const auto source =
+            p_pixels + static_cast<std::size_t>(y) * p_extent.width *
+                           SERVICE_BYTES_PER_PIXEL;
+        for (auto x = std::uint32_t{0}; x < p_extent.width; x++)
         {
-            print_error("[FATAL ERROR]: Failed to submit the command buffer. "
-                        "Vulkan error {}\n",
-                        submit_result);
-            std::exit(EXIT_FAILURE);
+            for (auto channel = std::size_t{0}; channel < 3; channel++)
+            {
+                row[x * 3 + channel] = static_cast<char>(
+                    source[x * SERVICE_BYTES_PER_PIXEL + channel]);
+            }
         }
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
 
-        glfwPollEvents();
+    return static_cast<bool>(file);
+}
+
+// Where frame p_frame of a job is written to.
+auto get_service_frame_path(const render_job_t& p_job, std::uint32_t p_frame)
+    -> std::filesystem::path
+{
+    if (p_job.frame_count == 1)
+    {
+        return p_job.output_path;
+    }
+
+    auto path = p_job.output_path;
+    path.replace_filename(fmt::format("{}_{}{}", path.stem().string(), p_frame,
+                                      path.extension().string()));
+    return path;
+}
+
+// Waits for p_batch, writes out every frame it rendered and replies to each
+// job's client.
+auto finish_service_batch(VkDevice p_device, service_batch_t& p_batch,
+                          deletion_queue_t& p_deletion_queue,
+                          render_service_t& p_service)
+{
+    vkWaitForFences(p_device, 1, p_batch.fence.get_address(), VK_TRUE,
+                    UINT64_MAX);
+    p_deletion_queue.collect(p_batch.number);
+    p_batch.in_flight = false;
+
+    for (auto i = std::size_t{0}; i < p_batch.jobs.size(); i++)
+    {
+        const auto& job = p_batch.jobs[i];
+        const auto& target = p_batch.targets[i];
+        const auto frame_size = static_cast<std::size_t>(job.width) *
+                                job.height * SERVICE_BYTES_PER_PIXEL;
+
+        auto paths = std::vector<std::filesystem::path>();
+        for (auto frame = std::uint32_t{0}; frame < job.frame_count; frame++)
+        {
+            paths.push_back(get_service_frame_path(job, frame));
+            if (!write_ppm(paths.back(),
+                           target.readback_data + frame * frame_size,
+                           target.extent))
+            {
+                p_service.fail(job, fmt::format("failed to write {}",
+                                                paths.back().string()));
+                paths.clear();
+                break;
+            }
+        }
+
+        if (!paths.empty())
+        {
+            p_service.complete(job, paths);
+        }
     }
 
+    p_batch.jobs.clear();
+}
+
+// Records every frame of every job in p_batch into its command buffer, and
+// submits it.
+auto submit_service_batch(
+    VkPhysicalDevice p_physical_device, VkDevice p_device, VkQueue p_queue,
+    service_batch_t& p_batch, VkRenderPass p_render_pass,
+    const dynamic_rendering_functions_t* p_dynamic_rendering,
+    const pipeline_variant_library_t& p_pipelines,
+    VkPipelineLayout p_pipeline_layout, uniform_ring_t& p_frame_uniform_ring,
+    VkDescriptorSet p_texture_set, const std::vector<mesh_t>& p_meshes,
+    deletion_queue_t& p_deletion_queue, std::vector<push_constants_t>& p_draws,
+    draw_list_t& p_draw_list)
+{
+    vkResetFences(p_device, 1, p_batch.fence.get_address());
+    vkResetCommandBuffer(p_batch.command_buffer, 0);
+    begin_command_buffer(p_batch.command_buffer);
+
+    const auto frame_uniform_offset = p_frame_uniform_ring.push(
+        frame_uniforms_t{.view_projection = glm::mat4(1.0f),
+                         .color_scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)});
+
+    for (auto i = std::size_t{0}; i < p_batch.jobs.size(); i++)
+    {
+        const auto& job = p_batch.jobs[i];
+        const auto extent = VkExtent2D{.width = job.width,
+                                       .height = job.height};
+
+        if (i == p_batch.targets.size())
+        {
+            p_batch.targets.push_back(create_service_target(
+                p_physical_device, p_device, p_render_pass, extent,
+                job.frame_count, p_deletion_queue));
+        }
+        else if (p_batch.targets[i].extent.width != extent.width ||
+                 p_batch.targets[i].extent.height != extent.height ||
+                 p_batch.targets[i].frame_capacity < job.frame_count)
+        {
+            // The batch's previous submit has completed, so the old target
+            // can go straight away.
+            p_batch.targets[i] = create_service_target(
+                p_physical_device, p_device, p_render_pass, extent,
+                job.frame_count, p_deletion_queue);
+        }
+
+        auto& target = p_batch.targets[i];
+        const auto& mesh = p_meshes[job.subdivisions];
+        const auto graphics_pipeline = p_pipelines.get(pipeline_variant_key_t{
+            .color_mode = static_cast<color_mode_t>(job.color_mode),
+            .cull_mode = VK_CULL_MODE_BACK_BIT});
+
+        const auto render_target = render_target_t{
+            .render_pass = p_render_pass,
+            .framebuffer = p_render_pass != VK_NULL_HANDLE
+                               ? target.framebuffers[0].get()
+                               : static_cast<VkFramebuffer>(VK_NULL_HANDLE),
+            .image = target.image.get(),
+            .image_view = target.image_views[0].get(),
+            .extent = extent,
+            .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .depth_image = VK_NULL_HANDLE,
+            .depth_image_view = VK_NULL_HANDLE};
+
+        const auto frame_size = static_cast<VkDeviceSize>(job.width) *
+                                job.height * SERVICE_BYTES_PER_PIXEL;
+
+        for (auto frame = std::uint32_t{0}; frame < job.frame_count; frame++)
+        {
+            animate_objects(job.object_count, 1,
+                            job.time +
+                                static_cast<float>(frame) / SERVICE_FRAME_RATE,
+                            p_draws);
+
+            p_draw_list.clear();
+            for (auto j = std::size_t{0}; j < p_draws.size(); j++)
+            {
+                p_draw_list.add_indexed(
+                    graphics_pipeline, mesh.vertex_buffer.get(),
+                    mesh.index_buffer.get(), mesh.index_count, p_draws[j],
+                    static_cast<std::uint32_t>(j));
+            }
+
+            // The previous frame's copy has to finish reading the image
+            // before it's cleared again.
+            auto& render_graph = *target.render_graph;
+            const auto image = render_graph.import_image(
+                "target", render_target.image, render_target.image_view,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                render_graph_state_t{.stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     .access = 0,
+                                     .layout = VK_IMAGE_LAYOUT_UNDEFINED},
+                std::nullopt);
+            const auto readback = render_graph.import_buffer(
+                "readback", target.readback_buffer.get());
+
+            render_graph.add_pass(
+                "draw",
+                {render_graph_use_t{
+                    .resource = image,
+                    .access = render_graph_access_t::color_attachment_write}},
+                [&](VkCommandBuffer p_pass_command_buffer) {
+                    record_draw_pass(p_pass_command_buffer, render_target,
+                                     p_dynamic_rendering, p_pipeline_layout,
+                                     p_frame_uniform_ring.get_descriptor_set(),
+                                     frame_uniform_offset, p_texture_set,
+                                     p_draw_list, graphics_pipeline, nullptr,
+                                     0);
+                });
+
+            render_graph.add_pass(
+                "readback",
+                {render_graph_use_t{
+                     .resource = image,
+                     .access = render_graph_access_t::transfer_read},
+                 render_graph_use_t{
+                     .resource = readback,
+                     .access = render_graph_access_t::transfer_write}},
+                [&](VkCommandBuffer p_pass_command_buffer) {
+                    const auto region = VkBufferImageCopy{
+                        .bufferOffset = frame * frame_size,
+                        .bufferRowLength = 0,
+                        .bufferImageHeight = 0,
+                        .imageSubresource =
+                            VkImageSubresourceLayers{
+                                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                .mipLevel = 0,
+                                .baseArrayLayer = 0,
+                                .layerCount = 1},
+                        .imageOffset = VkOffset3D{.x = 0, .y = 0, .z = 0},
+                        .imageExtent = VkExtent3D{.width = extent.width,
+                                                  .height = extent.height,
+                                                  .depth = 1}};
+                    vkCmdCopyImageToBuffer(
+                        p_pass_command_buffer, render_target.image,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        target.readback_buffer.get(), 1, &region);
+                },
+                true);
+
+            render_graph.execute(p_batch.command_buffer, p_batch.number);
+        }
+    }
+
+    // The render graph doesn't know about the host, so the copies are made
+    // visible to it by hand.
+    const auto host_barrier =
+        VkMemoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                        .pNext = nullptr,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = VK_ACCESS_HOST_READ_BIT};
+    vkCmdPipelineBarrier(p_batch.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &host_barrier, 0,
+                         nullptr, 0, nullptr);
+
+    end_command_buffer(p_batch.command_buffer);
+
+    const auto submit_info = VkSubmitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &p_batch.command_buffer,
+        .signalSemaphoreCount = 0,
+        .pSignalSemaphores = nullptr};
+
+    const auto result =
+        vkQueueSubmit(p_queue, 1, &submit_info, p_batch.fence.get());
+    if (result != VK_SUCCESS)
+    {
+        print_error("[FATAL ERROR]: Failed to submit a render service batch. "
+                    "Vulkan error {}\n",
+                    result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    p_batch.in_flight = true;
+}
+
+// The software rasterizer doesn't sample textures.
+auto warn_if_texture_ignored(const options_t& p_options) -> void
+{
+    if (!p_options.texture_path.empty())
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The software rasterizer doesn't sample "
+                   "textures, so \"{}\" isn't drawn.\n",
+                   p_options.texture_path);
+    }
+}
+
+// Without a usable Vulkan device, the render service still takes jobs, and
+// renders them with the software rasterizer instead. The replies and files
+// are the same, just slower to produce.
+int run_software_render_service(const options_t& p_options)
+{
+    fmt::print(fmt::fg(fmt::color::yellow),
+               "[WARNING]: Falling back to the software rasterizer.\n");
+    warn_if_texture_ignored(p_options);
+
+    auto thread_pool = thread_pool_t();
+    auto rasterizer = software_rasterizer_t(thread_pool);
+
+    const auto vertices = get_triangle_vertices();
+    auto meshes = std::vector<std::vector<vertex_t>>(
+        render_service_t::MAX_SUBDIVISIONS + 1);
+
+    const auto frame_uniforms =
+        frame_uniforms_t{.view_projection = glm::mat4(1.0f),
+                         .color_scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)};
+
+    auto service =
+        render_service_t(p_options.service_endpoint, SOFTWARE_MAX_EXTENT);
+    auto draws = std::vector<push_constants_t>();
+
+    while (true)
+    {
+        const auto jobs = service.take_jobs(SERVICE_MAX_JOBS_PER_BATCH, true);
+        if (jobs.empty())
+        {
+            break;
+        }
+
+        for (const auto& job : jobs)
+        {
+            auto& mesh = meshes[job.subdivisions];
+            if (mesh.empty())
+            {
+                mesh = subdivide_triangle(vertices, job.subdivisions);
+            }
+
+            const auto extent = VkExtent2D{.width = job.width,
+                                           .height = job.height};
+            const auto variant = pipeline_variant_key_t{
+                .color_mode = static_cast<color_mode_t>(job.color_mode),
+                .cull_mode = VK_CULL_MODE_BACK_BIT};
+
+            auto paths = std::vector<std::filesystem::path>();
+            for (auto frame = std::uint32_t{0}; frame < job.frame_count;
+                 frame++)
+            {
+                animate_objects(job.object_count, 1,
+                                job.time + static_cast<float>(frame) /
+                                               SERVICE_FRAME_RATE,
+                                draws);
+                rasterizer.render(extent, mesh.data(),
+                                  static_cast<std::uint32_t>(mesh.size()),
+                                  draws, frame_uniforms, variant);
+
+                paths.push_back(get_service_frame_path(job, frame));
+                if (!write_ppm(paths.back(), rasterizer.get_pixels(), extent))
+                {
+                    service.fail(job, fmt::format("failed to write {}",
+                                                  paths.back().string()));
+                    paths.clear();
+                    break;
+                }
+            }
+
+            if (!paths.empty())
+            {
+                service.complete(job, paths);
+            }
+        }
+    }
+
+    service.print_statistics();
+    rasterizer.print_statistics();
+
+    return EXIT_SUCCESS;
+}
+
+// Everything that the headless modes share: a device without any surfaces, and
+// the pipeline variants for drawing into SERVICE_FORMAT images. The members
+// are destroyed in reverse order, so the device outlives everything made from
+// it.
+struct headless_context_t
+{
+    // Outlives the instance, so that messages from vkDestroyInstance still
+    // get printed.
+    std::unique_ptr<debug_log_t> debug_log;
+    unique_instance_t instance;
+    unique_debug_messenger_t debug_messenger;
+
+    VkPhysicalDevice physical_device;
+    std::uint32_t graphics_queue_family;
+    unique_device_t device;
+    VkQueue graphics_queue;
+
+    // Empty with the dynamic rendering backend.
+    unique_render_pass_t render_pass;
+    std::optional<dynamic_rendering_functions_t> dynamic_rendering;
+
+    std::unique_ptr<uniform_ring_t> frame_uniform_ring;
+    std::unique_ptr<texture_t> texture;
+    unique_pipeline_layout_t pipeline_layout;
+    unique_pipeline_cache_t pipeline_cache;
+    thread_pool_t thread_pool;
+    std::unique_ptr<pipeline_variant_library_t> pipelines;
+
+    auto get_dynamic_rendering() const -> const dynamic_rendering_functions_t*
+    {
+        return dynamic_rendering.has_value() ? &*dynamic_rendering : nullptr;
+    }
+};
+
+// Returns nullptr if there's no Vulkan instance or no usable device, so that
+// the caller can fall back to the software rasterizer.
+auto create_headless_context(const options_t& p_options)
+    -> std::unique_ptr<headless_context_t>
+{
+    auto context = std::make_unique<headless_context_t>();
+
+    if (p_options.validation)
+    {
+        context->debug_log = std::make_unique<debug_log_t>();
+    }
+
+    context->instance = create_instance(context->debug_log.get(), true);
+    if (!context->instance)
+    {
+        return nullptr;
+    }
+
+    if (context->debug_log != nullptr)
+    {
+        context->debug_messenger = create_debug_messenger(
+            context->instance.get(), context->debug_log.get());
+    }
+
+    const auto physical_device = pick_physical_device(
+        context->instance.get(), VK_NULL_HANDLE, p_options.device);
+    if (physical_device == VK_NULL_HANDLE)
+    {
+        return nullptr;
+    }
+    context->physical_device = physical_device;
+
+    const auto [graphics_queue_family_opt, present_queue_family_opt] =
+        find_queue_families(physical_device, VK_NULL_HANDLE);
+    const auto graphics_queue_family = graphics_queue_family_opt.value();
+    context->graphics_queue_family = graphics_queue_family;
+
+    const auto use_dynamic_rendering =
+        p_options.dynamic_rendering &&
+        supports_dynamic_rendering(physical_device);
+
+    auto [device_owner, graphics_queue, present_queue, compute_queue] =
+        create_logical_device(physical_device, graphics_queue_family,
+                              graphics_queue_family, std::nullopt,
+                              use_dynamic_rendering, false, true);
+    const auto device = device_owner.get();
+    context->device = std::move(device_owner);
+    context->graphics_queue = graphics_queue;
+
+    if (use_dynamic_rendering)
+    {
+        context->dynamic_rendering = load_dynamic_rendering_functions(device);
+    }
+    else
+    {
+        context->render_pass =
+            create_render_pass(SERVICE_FORMAT, VK_FORMAT_UNDEFINED,
+                               VK_ATTACHMENT_LOAD_OP_CLEAR, device);
+    }
+
+    context->frame_uniform_ring = std::make_unique<uniform_ring_t>(
+        physical_device, device, sizeof(frame_uniforms_t),
+        UNIFORM_RING_SLOT_COUNT,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    context->texture =
+        std::make_unique<texture_t>(physical_device, device, graphics_queue,
+                                    graphics_queue_family,
+                                    p_options.texture_path);
+
+    context->pipeline_layout = create_pipeline_layout(
+        device, context->frame_uniform_ring->get_descriptor_set_layout(),
+        context->texture->get_descriptor_set_layout());
+    context->pipeline_cache = create_pipeline_cache(device);
+
+    // The viewport and scissor are dynamic, so the extent here doesn't limit
+    // the resolution that's rendered at.
+    const auto pipeline_base_info = pipeline_base_info_t{
+        .extent = VkExtent2D{.width = WINDOW_WIDTH, .height = WINDOW_HEIGHT},
+        .render_pass = context->render_pass.get(),
+        .color_format = SERVICE_FORMAT,
+        .depth_format = VK_FORMAT_UNDEFINED,
+        .layout = context->pipeline_layout.get()};
+
+    context->pipelines =
+        build_pipeline_variants(device, pipeline_base_info,
+                                context->pipeline_cache.get(),
+                                context->thread_pool);
+    if (context->pipelines == nullptr || !context->pipelines->is_complete())
+    {
+        fmt::print("[FATAL ERROR]: Failed to build the pipeline variants.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    return context;
+}
+
+// Renders jobs from the render service without a window, until it's told to
+// quit. The device, pipelines, pools and render targets are all created once
+// and kept across jobs.
+int run_render_service(const options_t& p_options)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const auto context = create_headless_context(p_options);
+    if (context == nullptr)
+    {
+        return run_software_render_service(p_options);
+    }
+
+    const auto physical_device = context->physical_device;
+    const auto device = context->device.get();
+
+    auto deletion_queue = deletion_queue_t();
+
+    const auto command_pool =
+        create_command_pool(device, context->graphics_queue_family);
+    const auto command_buffers =
+        create_command_buffers(device, command_pool.get(), 2);
+
+    auto batches = std::array<service_batch_t, 2>();
+    for (auto i = std::size_t{0}; i < batches.size(); i++)
+    {
+        batches[i] = service_batch_t{.command_buffer = command_buffers[i],
+                                     .fence = create_fence(device),
+                                     .jobs = {},
+                                     .targets = {},
+                                     .number = 0,
+                                     .in_flight = false};
+    }
+
+    // Created the first time a job asks for their level, and kept.
+    auto meshes = std::vector<mesh_t>(render_service_t::MAX_SUBDIVISIONS + 1);
+
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+    fmt::print("[INFO]: The render service started in {:.1f} ms.\n",
+               std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start_time)
+                   .count());
+
+    auto service = render_service_t(
+        p_options.service_endpoint,
+        device_properties.limits.maxImageDimension2D);
+
+    auto draws = std::vector<push_constants_t>();
+    auto draw_list = draw_list_t();
+    auto batch_number = std::uint64_t{0};
+
+    // While one batch renders, the other one is read back and written out.
+    // The loop only blocks for new jobs once nothing is in flight.
+    while (true)
+    {
+        const auto any_in_flight =
+            std::any_of(batches.begin(), batches.end(),
+                        [](const service_batch_t& p_batch) {
+                            return p_batch.in_flight;
+                        });
+
+        auto jobs = service.take_jobs(SERVICE_MAX_JOBS_PER_BATCH,
+                                      !any_in_flight);
+        if (jobs.empty() && !any_in_flight)
+        {
+            break;
+        }
+
+        auto submitted = static_cast<service_batch_t*>(nullptr);
+        if (!jobs.empty())
+        {
+            batch_number++;
+            auto& batch = batches[batch_number % batches.size()];
+            if (batch.in_flight)
+            {
+                finish_service_batch(device, batch, deletion_queue, service);
+            }
+
+            for (const auto& job : jobs)
+            {
+                auto& mesh = meshes[job.subdivisions];
+                if (mesh.index_count == 0)
+                {
+                    mesh = create_mesh(physical_device, device,
+                                       job.subdivisions,
+                                       p_options.optimize_meshes);
+                }
+            }
+
+            batch.jobs = std::move(jobs);
+            batch.number = batch_number;
+            context->texture->stream();
+            submit_service_batch(
+                physical_device, device, context->graphics_queue, batch,
+                context->render_pass.get(), context->get_dynamic_rendering(),
+                *context->pipelines, context->pipeline_layout.get(),
+                *context->frame_uniform_ring,
+                context->texture->get_descriptor_set(), meshes,
+                deletion_queue, draws, draw_list);
+            submitted = &batch;
+        }
+
+        for (auto& batch : batches)
+        {
+            if (batch.in_flight && &batch != submitted)
+            {
+                finish_service_batch(device, batch, deletion_queue, service);
+            }
+        }
+    }
+
+    service.print_statistics();
+    draw_list.print_statistics();
+    context->pipelines->print_statistics();
+    context->texture->print_statistics();
+
     vkDeviceWaitIdle(device);
 
-    vkDestroySemaphore(device, image_available_semaphore, nullptr);
-    vkDestroySemaphore(device, render_finished_semaphore, nullptr);
-    vkDestroyFence(device, in_flight_fence, nullptr);
-    vkFreeMemory(device, vertex_buffer_memory, nullptr);
-    vkDestroyBuffer(device, vertex_buffer, nullptr);
-    vkDestroyCommandPool(device, command_pool, nullptr);
+    return EXIT_SUCCESS;
+}
+
+// Draws the file at VULKAN_TRIANGLE_STREAM into an offscreen image without a
+// window, as one triangle list in clip space. Every frame streams the whole
+// file through geometry_stream_t, so its size is only limited by the disk.
+// The first chunk of a frame clears the image, and the rest draw on top.
+int run_geometry_stream(const options_t& p_options)
+{
+    const auto context = create_headless_context(p_options);
+    if (context == nullptr)
+    {
+        fmt::print("[FATAL ERROR]: Streaming geometry needs a Vulkan "
+                   "device.\n");
+        return EXIT_FAILURE;
+    }
+
+    const auto physical_device = context->physical_device;
+    const auto device = context->device.get();
+
+    auto deletion_queue = deletion_queue_t();
+
+    const auto load_render_pass =
+        context->render_pass
+            ? create_render_pass(SERVICE_FORMAT, VK_FORMAT_UNDEFINED,
+                                 VK_ATTACHMENT_LOAD_OP_LOAD, device)
+            : unique_render_pass_t();
+
+    // The readback buffer that comes with it goes unused.
+    const auto extent = VkExtent2D{.width = WINDOW_WIDTH,
+                                   .height = WINDOW_HEIGHT};
+    const auto target =
+        create_service_target(physical_device, device,
+                              context->render_pass.get(), extent, 1,
+                              deletion_queue);
+
+    // One graph for the first chunk of a frame and one for the rest, so that
+    // neither has to be recompiled as they alternate.
+    auto& clear_render_graph = *target.render_graph;
+    auto load_render_graph =
+        render_graph_t(physical_device, device, deletion_queue);
+
+    // The winding of the file's triangles isn't known.
+    const auto graphics_pipeline =
+        context->pipelines->get(pipeline_variant_key_t{
+            .color_mode = color_mode_t::vertex_color,
+            .cull_mode = VK_CULL_MODE_NONE});
+
+    const auto identity = push_constants_t{.transform = glm::mat2(1.0f),
+                                           .translation = glm::vec2(0.0f),
+                                           .tint = glm::vec4(1.0f)};
+    auto draw_list = draw_list_t();
+
+    // Pushed once, and never overwritten.
+    const auto frame_uniform_offset = context->frame_uniform_ring->push(
+        frame_uniforms_t{.view_projection = glm::mat4(1.0f),
+                         .color_scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)});
+
+    auto stream = geometry_stream_t(
+        physical_device, device, context->graphics_queue,
+        context->graphics_queue_family, p_options.stream_path,
+        p_options.stream_chunk_triangle_count, p_options.stream_buffer_count);
+
+    // In milliseconds. A frame is timed from its first chunk being read to
+    // its last one being submitted, which once the ring is full is paced by
+    // the GPU.
+    auto frame_times = running_statistics_t();
+    const auto start_time = std::chrono::steady_clock::now();
+
+    for (auto frame = std::uint32_t{0}; frame < p_options.stream_frame_count;
+         frame++)
+    {
+        const auto frame_start_time = std::chrono::steady_clock::now();
+
+        // Every chunk of a frame samples the same texture levels.
+        context->texture->stream();
+        const auto texture_set = context->texture->get_descriptor_set();
+
+        for (auto index = std::uint64_t{0}; index < stream.get_chunk_count();
+             index++)
+        {
+            const auto chunk = stream.begin_chunk(index);
+            deletion_queue.collect(stream.get_completed_number());
+
+            const auto is_first = index == 0;
+            auto& render_graph =
+                is_first ? clear_render_graph : load_render_graph;
+
+            // The previous chunk drew into the image in an earlier submit.
+            // The first chunk of a frame discards that.
+            const auto initial_layout =
+                is_first ? VK_IMAGE_LAYOUT_UNDEFINED
+                         : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            const auto render_target = render_target_t{
+                .render_pass = is_first ? context->render_pass.get()
+                                        : load_render_pass.get(),
+                .framebuffer = context->render_pass
+                                   ? target.framebuffers[0].get()
+                                   : static_cast<VkFramebuffer>(VK_NULL_HANDLE),
+                .image = target.image.get(),
+                .image_view = target.image_views[0].get(),
+                .extent = extent,
+                .load_op = is_first ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                                    : VK_ATTACHMENT_LOAD_OP_LOAD,
+                .depth_image = VK_NULL_HANDLE,
+                .depth_image_view = VK_NULL_HANDLE};
+
+            draw_list.clear();
+            draw_list.add(graphics_pipeline, chunk.vertex_buffer,
+                          chunk.vertex_count, identity, 0);
+
+            stream.submit(chunk, [&](VkCommandBuffer p_command_buffer) {
+                const auto image = render_graph.import_image(
+                    "target", render_target.image, render_target.image_view,
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    render_graph_state_t{
+                        .stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        .access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                        .layout = initial_layout},
+                    std::nullopt);
+                const auto vertices = render_graph.import_buffer(
+                    "chunk vertices", chunk.vertex_buffer);
+
+                // Nothing comes before the upload in this submit, so it can
+                // start while the previous chunk is still being drawn. Only
+                // the barrier in front of this chunk's draw waits for it.
+                render_graph.add_pass(
+                    "upload chunk",
+                    {render_graph_use_t{
+                        .resource = vertices,
+                        .access = render_graph_access_t::transfer_write}},
+                    [&](VkCommandBuffer p_pass_command_buffer) {
+                        stream.record_upload(p_pass_command_buffer, chunk);
+                    });
+
+                // Nothing reads the image afterwards, so the draw is kept
+                // alive by declaring its side effects.
+                render_graph.add_pass(
+                    "draw chunk",
+                    {render_graph_use_t{
+                         .resource = image,
+                         .access =
+                             render_graph_access_t::color_attachment_write},
+                     render_graph_use_t{
+                         .resource = vertices,
+                         .access = render_graph_access_t::vertex_buffer_read}},
+                    [&](VkCommandBuffer p_pass_command_buffer) {
+                        record_draw_pass(
+                            p_pass_command_buffer, render_target,
+                            context->get_dynamic_rendering(),
+                            context->pipeline_layout.get(),
+                            context->frame_uniform_ring->get_descriptor_set(),
+                            frame_uniform_offset, texture_set, draw_list,
+                            graphics_pipeline, nullptr, 0);
+                    },
+                    true);
+
+                render_graph.execute(p_command_buffer, chunk.number);
+            });
+        }
+
+        frame_times.add(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - frame_start_time)
+                            .count());
+    }
+
+    stream.wait_idle();
+    const auto total_time = std::chrono::steady_clock::now() - start_time;
+    const auto total_seconds =
+        std::chrono::duration<double>(total_time).count();
+
+    const auto triangle_count = stream.get_triangle_count() *
+                                p_options.stream_frame_count;
+    fmt::print("[INFO]: Drew {} frame(s) of {} triangles in {:.3f} ms per "
+               "frame on average (standard deviation {:.3f} ms), {:.1f} "
+               "million triangles per second.\n",
+               frame_times.count, stream.get_triangle_count(),
+               frame_times.mean, frame_times.get_standard_deviation(),
+               total_seconds > 0.0
+                   ? static_cast<double>(triangle_count) / total_seconds / 1e6
+                   : 0.0);
+    stream.print_statistics();
+    context->texture->print_statistics();
+
+    vkDeviceWaitIdle(device);
+
+    return EXIT_SUCCESS;
+}
+
+// OpenGL 1.1 is exported directly, with the platform's calling convention.
+#ifdef _WIN32
+#define GL_1_1_CALL __stdcall
+#else
+#define GL_1_1_CALL
+#endif
+
+// The few OpenGL 1.1 functions that the software fallback needs to show its
+// frames. They're loaded at runtime, so that the program doesn't link against
+// OpenGL, which a machine without a Vulkan driver may well be missing too.
+struct gl_functions_t
+{
+    void(GL_1_1_CALL* viewport)(GLint, GLint, GLsizei, GLsizei);
+    void(GL_1_1_CALL* raster_pos_2f)(GLfloat, GLfloat);
+    void(GL_1_1_CALL* pixel_zoom)(GLfloat, GLfloat);
+    void(GL_1_1_CALL* draw_pixels)(GLsizei, GLsizei, GLenum, GLenum,
+                                   const void*);
+};
+
+// Needs a current context. Returns nothing if any function is missing.
+auto load_gl_functions() -> std::optional<gl_functions_t>
+{
+    const auto functions = gl_functions_t{
+        .viewport = reinterpret_cast<decltype(gl_functions_t::viewport)>(
+            glfwGetProcAddress("glViewport")),
+        .raster_pos_2f =
+            reinterpret_cast<decltype(gl_functions_t::raster_pos_2f)>(
+                glfwGetProcAddress("glRasterPos2f")),
+        .pixel_zoom = reinterpret_cast<decltype(gl_functions_t::pixel_zoom)>(
+            glfwGetProcAddress("glPixelZoom")),
+        .draw_pixels =
+            reinterpret_cast<decltype(gl_functions_t::draw_pixels)>(
+                glfwGetProcAddress("glDrawPixels"))};
+
+    if (functions.viewport == nullptr || functions.raster_pos_2f == nullptr ||
+        functions.pixel_zoom == nullptr || functions.draw_pixels == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    return functions;
+}
+
+// Shows the scene without Vulkan, rendered by the software rasterizer and
+// copied into OpenGL windows with glDrawPixels. The same keys switch the
+// color mode and culling, and on-demand redraws work the same way.
+int run_software_windows(const options_t& p_options)
+{
+    fmt::print(fmt::fg(fmt::color::yellow),
+               "[WARNING]: Falling back to the software rasterizer.\n");
+
+    if (p_options.particle_count > 0)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Particles need a compute shader, so they're "
+                   "not drawn by the software rasterizer.\n");
+    }
+    warn_if_texture_ignored(p_options);
+
+    glfwSetErrorCallback(glfw_error_callback);
+
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
-    for (const auto framebuffer : swap_chain_framebuffers)
+    auto windows = std::vector<GLFWwindow*>();
+    for (auto i = std::uint32_t{0}; i < p_options.window_count; i++)
     {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
+        const auto title =
+            i == 0 ? std::string("Vulkan Triangle (software)")
+                   : fmt::format("Vulkan Triangle (software, {})", i + 1);
+        GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
+                                              title.c_str(), nullptr, nullptr);
+        if (window == nullptr)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create an OpenGL window for "
+                       "the software rasterizer.\n");
+            return EXIT_FAILURE;
+        }
+
+        windows.push_back(window);
     }
 
-    vkDestroyPipeline(device, graphics_pipeline, nullptr);
-    vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
-    vkDestroyRenderPass(device, render_pass, nullptr);
+    glfwMakeContextCurrent(windows[0]);
+    const auto gl = load_gl_functions();
+    if (!gl.has_value())
+    {
+        fmt::print("[FATAL ERROR]: Failed to load the OpenGL 1.1 functions.\n");
+        return EXIT_FAILURE;
+    }
 
-    for (const auto& image_view : swap_chain_image_views)
+    auto thread_pool = thread_pool_t();
+    auto rasterizer = software_rasterizer_t(thread_pool);
+
+    auto redraw_scheduler = redraw_scheduler_t(
+        p_options.on_demand_redraw,
+        p_options.animation_fps > 0
+            ? std::optional(
+                  std::chrono::duration_cast<redraw_scheduler_t::duration_t>(
+                      std::chrono::duration<double>(1.0 /
+                                                    p_options.animation_fps)))
+            : std::nullopt);
+
+    auto window_state = window_state_t{
+        .pipeline_variant =
+            pipeline_variant_key_t{.color_mode = color_mode_t::vertex_color,
+                                   .cull_mode = VK_CULL_MODE_BACK_BIT,
+                                   .blend_mode = blend_mode_t::opaque},
+        .redraw_scheduler = &redraw_scheduler,
+        .show_overdraw = false};
+    for (const auto window : windows)
     {
-        vkDestroyImageView(device, image_view, nullptr);
+        glfwSetWindowUserPointer(window, &window_state);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(1);
+        glfwShowWindow(window);
     }
 
-    vkDestroySwapchainKHR(device, swap_chain, nullptr);
-    vkDestroyDevice(device, nullptr);
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    const auto vertices = get_triangle_vertices();
+    const auto frame_uniforms =
+        frame_uniforms_t{.view_projection = glm::mat4(1.0f),
+                         .color_scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)};
+    auto draws = std::vector<push_constants_t>();
+
+    const auto start_time = std::chrono::steady_clock::now();
 
-    if (ENABLE_VALIDATION)
+    while (redraw_scheduler.wait_for_redraw(windows))
     {
-        LOAD_VK_FUNCTION(vkDestroyDebugUtilsMessengerEXT, instance);
-        hello56721_vkDestroyDebugUtilsMessengerEXT(instance, debug_messenger,
-                                                   nullptr);
+        glfwPollEvents();
+
+        const auto time = std::chrono::duration<float>(
+                              std::chrono::steady_clock::now() - start_time)
+                              .count();
+        animate_objects(p_options.object_count, p_options.overdraw, time,
+                        draws);
+
+        // The windows usually share a size, in which case the frame is only
+        // rendered once.
+        auto rendered_extent = VkExtent2D{.width = 0, .height = 0};
+        for (const auto window : windows)
+        {
+            auto width = 0;
+            auto height = 0;
+            glfwGetFramebufferSize(window, &width, &height);
+            if (width <= 0 || height <= 0)
+            {
+                continue;
+            }
+
+            const auto extent =
+                VkExtent2D{.width = static_cast<std::uint32_t>(width),
+                           .height = static_cast<std::uint32_t>(height)};
+            if (extent.width != rendered_extent.width ||
+                extent.height != rendered_extent.height)
+            {
+                rasterizer.render(extent, vertices.data(),
+                                  static_cast<std::uint32_t>(vertices.size()),
+                                  draws, frame_uniforms,
+                                  window_state.pipeline_variant);
+                rendered_extent = extent;
+            }
+
+            // The rows are stored top first, and OpenGL's go bottom up, so
+            // they're drawn downwards from the top left corner.
+            glfwMakeContextCurrent(window);
+            gl->viewport(0, 0, width, height);
+            gl->raster_pos_2f(-1.0f, 1.0f);
+            gl->pixel_zoom(1.0f, -1.0f);
+            gl->draw_pixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                            rasterizer.get_pixels());
+            glfwSwapBuffers(window);
+        }
+    }
+
+    rasterizer.print_statistics();
+    redraw_scheduler.print_statistics();
+
+    return EXIT_SUCCESS;
+}
+
+// Terminates GLFW once everything declared after it in real_main() is gone.
+struct glfw_session_t
+{
+    ~glfw_session_t() { glfwTerminate(); }
+};
+
+// The actual main function. Every object owns its handles, so everything is
+// destroyed in the reverse order of creation when this returns.
+int real_main()
+{
+    const auto options = load_options();
+
+    if (!options.stream_path.empty())
+    {
+        return run_geometry_stream(options);
+    }
+
+    if (!options.service_endpoint.empty())
+    {
+        return run_render_service(options);
+    }
+
+    if (!glfwInit())
+    {
+        fmt::print("[FATAL ERROR]: Failed to initialize GLFW.\n");
+        return EXIT_FAILURE;
+    }
+    const auto glfw_session = glfw_session_t();
+
+    if (!glfwVulkanSupported())
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: GLFW didn't find a Vulkan loader.\n");
+        return run_software_windows(options);
+    }
+
+    // Without validation there is no layer, no messenger and no logger
+    // thread at all. The log outlives the instance, so that messages from
+    // vkDestroyInstance still get printed.
+    auto debug_log = options.validation ? std::make_unique<debug_log_t>()
+                                        : std::unique_ptr<debug_log_t>();
+
+    const auto instance = create_instance(debug_log.get(), false);
+    if (!instance)
+    {
+        return run_software_windows(options);
+    }
+
+    const auto debug_messenger =
+        debug_log != nullptr
+            ? create_debug_messenger(instance.get(), debug_log.get())
+            : unique_debug_messenger_t();
+
+    glfwSetErrorCallback(glfw_error_callback);
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+    // The first window is the primary one. It picks the device and the queue
+    // families, and the frame pacer follows its swap chain.
+    auto windows = std::vector<GLFWwindow*>();
+    auto surfaces = std::vector<unique_surface_t>();
+    for (auto i = std::uint32_t{0}; i < options.window_count; i++)
+    {
+        const auto title = i == 0 ? std::string("Vulkan Triangle")
+                                  : fmt::format("Vulkan Triangle ({})", i + 1);
+        GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
+                                              title.c_str(), nullptr, nullptr);
+        if (window == nullptr)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create the GLFW window.\n");
+            return EXIT_FAILURE;
+        }
+
+        windows.push_back(window);
+        surfaces.push_back(create_surface(instance.get(), window));
+    }
+
+    const VkPhysicalDevice physical_device = pick_physical_device(
+        instance.get(), surfaces[0].get(), options.device);
+    if (physical_device == VK_NULL_HANDLE)
+    {
+        surfaces.clear();
+        for (const auto window : windows)
+        {
+            glfwDestroyWindow(window);
+        }
+
+        return run_software_windows(options);
+    }
+
+    const auto [graphics_queue_family_opt, present_queue_family_opt] =
+        find_queue_families(physical_device, surfaces[0].get());
+    const auto graphics_queue_family = graphics_queue_family_opt.value();
+    const auto present_queue_family = present_queue_family_opt.value();
+
+    // Every swap chain is presented in the same call, so they all need to be
+    // presentable from the same queue.
+    for (const auto& surface : surfaces)
+    {
+        auto present_support = VkBool32{VK_FALSE};
+        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device,
+                                             present_queue_family,
+                                             surface.get(), &present_support);
+        if (!present_support)
+        {
+            fmt::print("[FATAL ERROR]: The present queue can't present to "
+                       "every window.\n");
+            std::exit(EXIT_FAILURE);
+        }
     }
 
-    vkDestroyInstance(instance, nullptr);
+    const auto use_dynamic_rendering =
+        options.dynamic_rendering && supports_dynamic_rendering(physical_device);
+    if (options.dynamic_rendering && !use_dynamic_rendering)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The chosen device doesn't support "
+                   "VK_KHR_dynamic_rendering. Falling back to render passes.\n");
+    }
+
+    fmt::print("[INFO]: Rendering with {}.\n",
+               use_dynamic_rendering ? "VK_KHR_dynamic_rendering"
+                                     : "render pass objects");
+
+    const auto use_present_wait = supports_present_wait(physical_device);
+    if (options.low_latency && !use_present_wait)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The chosen device doesn't support "
+                   "VK_KHR_present_wait, so low latency mode can only delay "
+                   "input sampling.\n");
+    }
+
+    // Only the particles need compute work, so there's no point in a queue
+    // for it without them.
+    const auto async_compute_family =
+        options.async_compute && options.particle_count > 0
+            ? find_async_compute_family(physical_device)
+            : std::nullopt;
+
+    const auto [device_owner, graphics_queue, present_queue, compute_queue] =
+        create_logical_device(physical_device, graphics_queue_family,
+                              present_queue_family, async_compute_family,
+                              use_dynamic_rendering, use_present_wait, false);
+    const auto device = device_owner.get();
+
+    // Resources that are replaced while the program runs go in here rather
+    // than being destroyed on the spot, so replacing them never needs a
+    // vkDeviceWaitIdle. Its values are frame numbers.
+    auto deletion_queue = deletion_queue_t();
+
+    auto outputs = std::vector<output_t>();
+    outputs.reserve(windows.size());
+    for (auto i = std::size_t{0}; i < windows.size(); i++)
+    {
+        auto [swap_chain, images, format, extent] = create_swap_chain(
+            physical_device, surfaces[i].get(), windows[i],
+            graphics_queue_family, present_queue_family, device);
+
+        auto image_views = create_image_views(device, images, format);
+
+        outputs.push_back(output_t{
+            .window = windows[i],
+            .surface = surfaces[i].get(),
+            .swap_chain = std::move(swap_chain),
+            .images = std::move(images),
+            .format = format,
+            .extent = extent,
+            .image_views = std::move(image_views),
+            .framebuffers = {},
+            .depth_buffer = {},
+            .image_available_semaphore = create_semaphore(device),
+            .command_buffer = VK_NULL_HANDLE,
+            .render_graph = std::make_unique<render_graph_t>(
+                physical_device, device, deletion_queue),
+            .image_index = 0});
+    }
+
+    // The render pass and pipelines are shared, so every window has to end
+    // up with the same format. The extent can differ, since the viewport and
+    // scissor are dynamic.
+    const auto swap_chain_format = outputs[0].format;
+    const auto swap_chain_extent = outputs[0].extent;
+    for (const auto& output : outputs)
+    {
+        if (output.format != swap_chain_format)
+        {
+            fmt::print("[FATAL ERROR]: The windows' swap chains ended up with "
+                       "different formats ({} and {}).\n",
+                       static_cast<int>(swap_chain_format),
+                       static_cast<int>(output.format));
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    const auto depth_format = options.depth ? find_depth_format(physical_device)
+                                            : VK_FORMAT_UNDEFINED;
+
+    // With dynamic rendering, there are no render pass or framebuffer objects
+    // at all, so nothing but the image views depends on the swap chain.
+    const auto render_pass =
+        use_dynamic_rendering
+            ? unique_render_pass_t()
+            : create_render_pass(swap_chain_format, depth_format,
+                                 VK_ATTACHMENT_LOAD_OP_CLEAR, device);
+
+    const auto dynamic_rendering =
+        use_dynamic_rendering
+            ? std::optional(load_dynamic_rendering_functions(device))
+            : std::nullopt;
+
+    // Written once per frame. Everything in it is shared by all of the draws.
+    auto frame_uniform_ring = std::make_unique<uniform_ring_t>(
+        physical_device, device, sizeof(frame_uniforms_t),
+        UNIFORM_RING_SLOT_COUNT,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    // Its larger levels keep streaming in once the frames have started.
+    auto texture = texture_t(physical_device, device, graphics_queue,
+                             graphics_queue_family, options.texture_path);
+
+    const auto pipeline_layout =
+        create_pipeline_layout(device,
+                               frame_uniform_ring->get_descriptor_set_layout(),
+                               texture.get_descriptor_set_layout());
+    const auto pipeline_cache = create_pipeline_cache(device);
+
+    const auto pipeline_base_info =
+        pipeline_base_info_t{.extent = swap_chain_extent,
+                             .render_pass = render_pass.get(),
+                             .color_format = swap_chain_format,
+                             .depth_format = depth_format,
+                             .layout = pipeline_layout.get()};
+
+    // Declared before the thread pool, as the pipeline workers ask for a
+    // redraw whenever a variant they compiled on demand is ready, and the pool
+    // finishes off its queue when it's destroyed.
+    auto redraw_scheduler = redraw_scheduler_t(
+        options.on_demand_redraw,
+        options.animation_fps > 0
+            ? std::optional(
+                  std::chrono::duration_cast<redraw_scheduler_t::duration_t>(
+                      std::chrono::duration<double>(1.0 /
+                                                    options.animation_fps)))
+            : std::nullopt);
+
+    auto thread_pool = thread_pool_t();
+
+    // The common variants are compiled here, before the first frame, so that
+    // switching between them never hitches. Anything else is compiled the
+    // first time it's drawn with, in the background, and in on-demand mode
+    // the frame that would use it has to be asked for.
+    const auto request_background_redraw = [&redraw_scheduler]() {
+        redraw_scheduler.request_redraw(redraw_reason_t::background);
+    };
+    auto pipelines =
+        build_pipeline_variants(device, pipeline_base_info,
+                                pipeline_cache.get(), thread_pool,
+                                request_background_redraw);
+    if (pipelines == nullptr || !pipelines->is_complete())
+    {
+        fmt::print("[FATAL ERROR]: Failed to build the pipeline variants.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Rebuilt pipelines are picked up by the next frame, so in on-demand mode
+    // the watcher thread has to ask for one.
+    auto shader_hot_reloader = std::optional<shader_hot_reloader_t>();
+    if (options.hot_reload_shaders)
+    {
+        shader_hot_reloader.emplace(
+            "shaders",
+            [device, pipeline_base_info, pipeline_cache = pipeline_cache.get(),
+             &thread_pool, request_background_redraw]() {
+                return build_pipeline_variants(device, pipeline_base_info,
+                                               pipeline_cache, thread_pool,
+                                               request_background_redraw);
+            },
+            request_background_redraw);
+    }
+
+    // Every window shares the same state, so a key press in any of them
+    // affects all of them.
+    auto window_state = window_state_t{
+        .pipeline_variant =
+            pipeline_variant_key_t{.color_mode = color_mode_t::vertex_color,
+                                   .cull_mode = VK_CULL_MODE_BACK_BIT,
+                                   .blend_mode = blend_mode_t::opaque},
+        .redraw_scheduler = &redraw_scheduler,
+        .show_overdraw = false};
+    for (const auto window : windows)
+    {
+        glfwSetWindowUserPointer(window, &window_state);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
+
+    const auto command_pool =
+        create_command_pool(device, graphics_queue_family);
+
+    // Freed along with the pool.
+    const auto command_buffers = create_command_buffers(
+        device, command_pool.get(),
+        static_cast<std::uint32_t>(outputs.size()));
+
+    for (auto i = std::size_t{0}; i < outputs.size(); i++)
+    {
+        auto& output = outputs[i];
+        if (depth_format != VK_FORMAT_UNDEFINED)
+        {
+            output.depth_buffer = create_depth_buffer(
+                physical_device, device, depth_format, output.extent);
+        }
+        if (!use_dynamic_rendering)
+        {
+            output.framebuffers = create_framebuffers(
+                device, render_pass.get(), output.image_views,
+                output.depth_buffer.image_view.get(), output.extent);
+        }
+        output.command_buffer = command_buffers[i];
+    }
+
+    // Shader invocations and GPU time, per window.
+    auto pipeline_statistics =
+        pipeline_statistics_t(physical_device, device, graphics_queue_family,
+                              static_cast<std::uint32_t>(outputs.size()));
+
+    // Set up the first time F4 turns it on, and kept from then on, so that
+    // switching back and forth is instant.
+    auto overdraw_mode = std::unique_ptr<overdraw_mode_t>();
+
+    // The triangle subdivided to the chosen level, and with mixed state, to
+    // a few more levels after it, which all look the same from more vertices.
+    auto meshes = std::vector<mesh_t>();
+    const auto mesh_count = options.mixed_state ? MIXED_STATE_MESH_COUNT
+                                               : std::uint32_t{1};
+    for (auto level = std::uint32_t{0}; level < mesh_count; level++)
+    {
+        meshes.push_back(create_mesh(
+            physical_device, device,
+            (std::min)(options.subdivisions + level,
+                       render_service_t::MAX_SUBDIVISIONS),
+            options.optimize_meshes));
+    }
+
+    // Every level covers the same triangle, so they all share its bounds.
+    const auto triangle_vertices = get_triangle_vertices();
+    auto object_bounds =
+        object_bounds_t{.min = triangle_vertices[0].position,
+                        .max = triangle_vertices[0].position};
+    for (const auto& vertex : triangle_vertices)
+    {
+        object_bounds.min = glm::min(object_bounds.min, vertex.position);
+        object_bounds.max = glm::max(object_bounds.max, vertex.position);
+    }
+
+    // Every window shares the draw list, so objects are only culled for
+    // being smaller than a pixel if they are in the largest of them.
+    auto cull_viewport = swap_chain_extent;
+    for (const auto& output : outputs)
+    {
+        cull_viewport.width = (std::max)(cull_viewport.width,
+                                         output.extent.width);
+        cull_viewport.height = (std::max)(cull_viewport.height,
+                                          output.extent.height);
+    }
+    auto object_culler = object_culler_t(thread_pool);
+
+    // Particles are generated and drawn entirely on the GPU, so unlike the
+    // meshes above nothing is uploaded for them. Each frame draws the
+    // set that was generated alongside the previous one.
+    auto geometry_generator = std::unique_ptr<geometry_generator_t>();
+    auto async_compute = std::optional<async_compute_t>();
+    auto compute_render_graphs = std::vector<std::unique_ptr<render_graph_t>>();
+    if (options.particle_count > 0)
+    {
+        const auto compute_shader_code =
+            load_binary_file("shaders/geometry.comp.spv");
+        if (compute_shader_code.empty())
+        {
+            fmt::print("[FATAL ERROR]: Failed to load the geometry generation "
+                       "shader.\n");
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto compute_shader_module =
+            create_shader_module(device, compute_shader_code);
+        const auto compute_queue_family =
+            async_compute_family.value_or(graphics_queue_family);
+        auto particle_queue_families =
+            std::vector<std::uint32_t>{graphics_queue_family};
+        if (compute_queue_family != graphics_queue_family)
+        {
+            particle_queue_families.push_back(compute_queue_family);
+        }
+
+        geometry_generator = std::make_unique<geometry_generator_t>(
+            physical_device, device, compute_shader_module.get(),
+            pipeline_cache.get(), options.particle_count, sizeof(vertex_t),
+            async_compute_t::SLOT_COUNT, particle_queue_families);
+
+        async_compute.emplace(physical_device, device, graphics_queue_family,
+                              compute_queue_family, compute_queue,
+                              async_compute_family.has_value());
+
+        for (auto i = std::uint32_t{0}; i < async_compute_t::SLOT_COUNT; i++)
+        {
+            compute_render_graphs.push_back(std::make_unique<render_graph_t>(
+                physical_device, device, deletion_queue));
+        }
+    }
+
+    // A single present call waits on the render finished semaphore for
+    // every window at once.
+    const auto [render_finished_semaphore, in_flight_fence] =
+        create_sync_objects(device);
+
+    // Only the push constants change from frame to frame. The vertex buffers
+    // are never touched again.
+    auto draws = std::vector<push_constants_t>();
+    auto draw_list = draw_list_t();
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Used to compare the CPU cost of the two rendering backends, and of
+    // adding more windows.
+    auto total_recording_time = std::chrono::steady_clock::duration::zero();
+    auto total_submission_time = std::chrono::steady_clock::duration::zero();
+    auto frame_count = static_cast<std::uint64_t>(0);
+
+    // The number of the frame being recorded, starting from 1. 0 stands for
+    // "before the first frame", which has always completed.
+    auto frame_number = static_cast<std::uint64_t>(0);
+
+    auto frame_pacer = frame_pacer_t(
+        options.target_fps, options.low_latency, device,
+        use_present_wait ? load_present_wait_function(device) : nullptr);
+
+    for (const auto window : windows)
+    {
+        glfwShowWindow(window);
+    }
+
+    // Reused every frame, so that batching the submit and present doesn't
+    // allocate.
+    auto wait_semaphores = std::vector<VkSemaphore>();
+    auto wait_stages = std::vector<VkPipelineStageFlags>();
+    auto swap_chains = std::vector<VkSwapchainKHR>();
+    auto image_indices = std::vector<std::uint32_t>();
+    auto present_ids = std::vector<std::uint64_t>();
+
+    while (redraw_scheduler.wait_for_redraw(windows))
+    {
+        frame_pacer.begin_frame();
+
+        vkWaitForFences(device, 1, in_flight_fence.get_address(), VK_TRUE,
+                        UINT64_MAX);
+        vkResetFences(device, 1, in_flight_fence.get_address());
+
+        // The fence covers every frame submitted so far.
+        deletion_queue.collect(frame_number);
+        frame_number++;
+
+        for (auto i = std::uint32_t{0}; i < outputs.size(); i++)
+        {
+            const auto extent = outputs[i].extent;
+            pipeline_statistics.collect(
+                i, static_cast<std::uint64_t>(extent.width) * extent.height);
+            if (overdraw_mode != nullptr)
+            {
+                overdraw_mode->view->collect(i);
+            }
+        }
+
+        if (async_compute.has_value())
+        {
+            async_compute->begin_frame(frame_number);
+        }
+
+        // The old pipelines may still be in use by the previous frame, so
+        // they're only destroyed once that has finished.
+        if (shader_hot_reloader.has_value())
+        {
+            if (auto reloaded_pipelines = shader_hot_reloader->poll())
+            {
+                deletion_queue.retire(frame_number - 1, std::move(pipelines));
+                pipelines = std::move(reloaded_pipelines);
+            }
+        }
+
+        for (auto& output : outputs)
+        {
+            vkAcquireNextImageKHR(device, output.swap_chain.get(), UINT64_MAX,
+                                  output.image_available_semaphore.get(),
+                                  VK_NULL_HANDLE, &output.image_index);
+        }
+
+        // Input is sampled as late as possible, so that what's drawn is as
+        // fresh as it can be.
+        frame_pacer.wait_for_input_sampling(outputs[0].swap_chain.get());
+        glfwPollEvents();
+
+        if (window_state.show_overdraw && overdraw_mode == nullptr)
+        {
+            auto extents = std::vector<VkExtent2D>();
+            for (const auto& output : outputs)
+            {
+                extents.push_back(output.extent);
+            }
+
+            overdraw_mode =
+                create_overdraw_mode(physical_device, device,
+                                     pipeline_cache.get(), pipeline_base_info,
+                                     extents);
+            if (overdraw_mode == nullptr)
+            {
+                fmt::print(fmt::fg(fmt::color::yellow),
+                           "[WARNING]: Failed to set up the overdraw view. "
+                           "Are its shaders compiled?\n");
+                window_state.show_overdraw = false;
+            }
+        }
+
+        // Every object is drawn with the same pipeline in the overdraw view.
+        const auto* const overdraw =
+            window_state.show_overdraw ? overdraw_mode.get() : nullptr;
+        const auto graphics_pipeline =
+            overdraw != nullptr ? overdraw->pipeline.get()
+                                : pipelines->get(window_state.pipeline_variant);
+
+        // The next frame has to come along to pick up the levels that are
+        // still uploading, even when nothing else changes.
+        if (texture.stream())
+        {
+            redraw_scheduler.request_redraw(redraw_reason_t::background);
+        }
+
+        const auto recording_start_time = std::chrono::steady_clock::now();
+
+        const auto time =
+            std::chrono::duration<float>(recording_start_time - start_time)
+                .count();
+
+        animate_objects(options.object_count, options.overdraw, time, draws);
+
+        // Only the objects that survive culling are added to the draw list.
+        const auto* const visible_objects =
+            options.cpu_culling
+                ? &object_culler.cull(cull_viewport, object_bounds, draws)
+                : nullptr;
+        const auto visible_count = visible_objects != nullptr
+                                       ? visible_objects->size()
+                                       : draws.size();
+
+        // With mixed state, neighboring objects differ in both pipeline and
+        // vertex buffer, which the sort groups back together. The color modes
+        // are offset from the one that's selected.
+        //
+        // With a depth buffer, opaque objects are ordered by their depth
+        // within each run of state, front to back, so that the early depth
+        // test rejects whatever the nearer ones already cover. Depths are
+        // positive, so their bits sort in the same order as the floats.
+        // Additive objects don't write depth, so their order doesn't matter.
+        draw_list.clear();
+        for (auto k = std::size_t{0}; k < visible_count; k++)
+        {
+            const auto j = visible_objects != nullptr
+                               ? (*visible_objects)[k]
+                               : static_cast<std::uint32_t>(k);
+            auto variant = window_state.pipeline_variant;
+            const auto& mesh = meshes[j % meshes.size()];
+            if (options.mixed_state)
+            {
+                variant.color_mode = static_cast<color_mode_t>(
+                    (static_cast<std::uint32_t>(variant.color_mode) + j) %
+                    COLOR_MODE_COUNT);
+            }
+
+            const auto order =
+                options.depth && variant.blend_mode == blend_mode_t::opaque
+                    ? std::bit_cast<std::uint32_t>(draws[j].depth)
+                    : j;
+            draw_list.add_indexed(overdraw != nullptr
+                                      ? graphics_pipeline
+                                      : pipelines->get(variant),
+                                  mesh.vertex_buffer.get(),
+                                  mesh.index_buffer.get(), mesh.index_count,
+                                  draws[j], order);
+        }
+
+        // Before the first frame, nothing has generated its particles yet.
+        const auto particle_slot = static_cast<std::uint32_t>(
+            frame_number % async_compute_t::SLOT_COUNT);
+        if (async_compute.has_value() && frame_number == 1)
+        {
+            async_compute->submit(
+                particle_slot, [&](VkCommandBuffer p_command_buffer) {
+                    record_particle_generation(
+                        p_command_buffer, *geometry_generator, particle_slot,
+                        time, *compute_render_graphs[particle_slot],
+                        frame_number);
+                });
+        }
+
+        const auto frame_uniform_offset =
+            frame_uniform_ring->push(frame_uniforms_t{
+                .view_projection = glm::mat4(1.0f),
+                .color_scale = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)});
+
+        for (auto i = std::size_t{0}; i < outputs.size(); i++)
+        {
+            auto& output = outputs[i];
+            const auto image_index = output.image_index;
+
+            const auto render_target = render_target_t{
+                .render_pass = render_pass.get(),
+                .framebuffer =
+                    use_dynamic_rendering
+                        ? static_cast<VkFramebuffer>(VK_NULL_HANDLE)
+                        : output.framebuffers[image_index].get(),
+                .image = output.images[image_index],
+                .image_view = output.image_views[image_index].get(),
+                .extent = output.extent,
+                .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .depth_image = output.depth_buffer.image.get(),
+                .depth_image_view = output.depth_buffer.image_view.get()};
+
+            vkResetCommandBuffer(output.command_buffer, 0);
+            begin_command_buffer(output.command_buffer);
+            if (async_compute.has_value() && i == 0)
+            {
+                async_compute->record_graphics_begin(output.command_buffer);
+            }
+            pipeline_statistics.record_begin(output.command_buffer,
+                                             static_cast<std::uint32_t>(i));
+
+            record_command_buffer(
+                output.command_buffer, render_target,
+                dynamic_rendering.has_value() ? &*dynamic_rendering : nullptr,
+                pipeline_layout.get(), frame_uniform_ring->get_descriptor_set(),
+                frame_uniform_offset, texture.get_descriptor_set(), draw_list,
+                graphics_pipeline, geometry_generator.get(), particle_slot,
+                overdraw, static_cast<std::uint32_t>(i), *output.render_graph,
+                frame_number);
+
+            pipeline_statistics.record_end(output.command_buffer,
+                                           static_cast<std::uint32_t>(i));
+            if (async_compute.has_value() && i + 1 == outputs.size())
+            {
+                async_compute->record_graphics_end(output.command_buffer);
+            }
+            end_command_buffer(output.command_buffer);
+        }
+
+        const auto submission_start_time = std::chrono::steady_clock::now();
+        total_recording_time += submission_start_time - recording_start_time;
+        frame_count++;
+
+        wait_semaphores.clear();
+        wait_stages.clear();
+        swap_chains.clear();
+        image_indices.clear();
+        for (const auto& output : outputs)
+        {
+            wait_semaphores.push_back(output.image_available_semaphore.get());
+            wait_stages.push_back(
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            swap_chains.push_back(output.swap_chain.get());
+            image_indices.push_back(output.image_index);
+        }
+
+        if (async_compute.has_value())
+        {
+            wait_semaphores.push_back(
+                async_compute->get_ready_semaphore(particle_slot));
+            wait_stages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+        }
+
+        const auto submit_info = VkSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .waitSemaphoreCount =
+                static_cast<std::uint32_t>(wait_semaphores.size()),
+            .pWaitSemaphores = wait_semaphores.data(),
+            .pWaitDstStageMask = wait_stages.data(),
+            .commandBufferCount =
+                static_cast<std::uint32_t>(command_buffers.size()),
+            .pCommandBuffers = command_buffers.data(),
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = render_finished_semaphore.get_address()};
+
+        const auto submit_result = vkQueueSubmit(graphics_queue, 1, &submit_info,
+                                                 in_flight_fence.get());
+
+        // The next frame's particles are generated while this one renders.
+        // The other slot was last drawn by the previous frame, which the
+        // fence has already covered. The graph's resources are retired with
+        // the next frame's number, since that's the submit that waits for
+        // this work.
+        if (async_compute.has_value())
+        {
+            const auto next_slot =
+                (particle_slot + 1) % async_compute_t::SLOT_COUNT;
+            async_compute->submit(
+                next_slot, [&](VkCommandBuffer p_command_buffer) {
+                    record_particle_generation(
+                        p_command_buffer, *geometry_generator, next_slot, time,
+                        *compute_render_graphs[next_slot], frame_number + 1);
+                });
+        }
+
+        // Every swap chain gets the same id, but only the primary one's is
+        // waited on.
+        present_ids.assign(swap_chains.size(), frame_pacer.get_present_id());
+        const auto present_id_info = VkPresentIdKHR{
+            .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+            .pNext = nullptr,
+            .swapchainCount = static_cast<std::uint32_t>(present_ids.size()),
+            .pPresentIds = present_ids.data()};
+
+        const auto present_info = VkPresentInfoKHR{
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .pNext = present_ids[0] != 0 ? &present_id_info : nullptr,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = render_finished_semaphore.get_address(),
+            .swapchainCount = static_cast<std::uint32_t>(swap_chains.size()),
+            .pSwapchains = swap_chains.data(),
+            .pImageIndices = image_indices.data(),
+            .pResults = nullptr};
+
+        vkQueuePresentKHR(present_queue, &present_info);
+
+        total_submission_time +=
+            std::chrono::steady_clock::now() - submission_start_time;
+
+        if (submit_result != VK_SUCCESS)
+        {
+            print_error("[FATAL ERROR]: Failed to submit the command buffer. "
+                        "Vulkan error {}\n",
+                        submit_result);
+            std::exit(EXIT_FAILURE);
+        }
+
+        frame_pacer.end_frame(outputs[0].swap_chain.get());
+    }
+
+    frame_pacer.print_statistics();
+    pipeline_statistics.print_statistics();
+    if (overdraw_mode != nullptr)
+    {
+        overdraw_mode->view->print_statistics();
+    }
+    redraw_scheduler.print_statistics();
+    draw_list.print_statistics();
+    object_culler.print_statistics();
+    pipelines->print_statistics();
+    texture.print_statistics();
+    if (async_compute.has_value())
+    {
+        async_compute->print_statistics();
+    }
+
+    if (frame_count > 0)
+    {
+        const auto average_recording_time =
+            std::chrono::duration<double, std::micro>(total_recording_time) /
+            static_cast<double>(frame_count);
+        const auto average_submission_time =
+            std::chrono::duration<double, std::micro>(total_submission_time) /
+            static_cast<double>(frame_count);
+        fmt::print("[INFO]: Recorded {} frames for {} window(s) with {}, "
+                   "averaging {:.2f} us of CPU time per frame to record and "
+                   "{:.2f} us to submit and present.\n",
+                   frame_count, outputs.size(),
+                   use_dynamic_rendering ? "dynamic rendering"
+                                         : "render passes",
+                   average_recording_time.count(),
+                   average_submission_time.count());
+    }
+
+    // Stop the watcher first, as it might be in the middle of building
+    // pipelines.
+    shader_hot_reloader.reset();
+
+    // Everything else is destroyed as it goes out of scope, which requires the
+    // GPU to be done with all of it.
+    vkDeviceWaitIdle(device);
 
-    glfwTerminate();
     return EXIT_SUCCESS;
 }
 
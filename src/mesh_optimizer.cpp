@@ -0,0 +1,245 @@
+#include "mesh_optimizer.hpp"
+
+namespace
+{
+
+// Vertices are only welded if they're equal bit for bit, which is what a
+// mesh that was split into a plain triangle list produces.
+struct vertex_hash_t
+{
+    auto operator()(const vertex_t& p_vertex) const -> std::size_t
+    {
+        return std::hash<std::string_view>()(std::string_view(
+            reinterpret_cast<const char*>(&p_vertex), sizeof(vertex_t)));
+    }
+};
+
+struct vertex_equal_t
+{
+    auto operator()(const vertex_t& p_a, const vertex_t& p_b) const -> bool
+    {
+        return std::memcmp(&p_a, &p_b, sizeof(vertex_t)) == 0;
+    }
+};
+
+} // namespace
+
+auto weld_vertices(const std::vector<vertex_t>& p_vertices) -> indexed_mesh_t
+{
+    auto mesh = indexed_mesh_t();
+    mesh.indices.reserve(p_vertices.size());
+
+    auto indices =
+        std::unordered_map<vertex_t, std::uint32_t, vertex_hash_t,
+                           vertex_equal_t>();
+    indices.reserve(p_vertices.size());
+
+    for (const auto& vertex : p_vertices)
+    {
+        const auto [it, inserted] = indices.try_emplace(
+            vertex, static_cast<std::uint32_t>(mesh.vertices.size()));
+        if (inserted)
+        {
+            mesh.vertices.push_back(vertex);
+        }
+        mesh.indices.push_back(it->second);
+    }
+
+    return mesh;
+}
+
+auto optimize_vertex_cache(std::vector<std::uint32_t>& p_indices,
+                           std::uint32_t p_vertex_count,
+                           std::uint32_t p_cache_size) -> void
+{
+    const auto triangle_count = p_indices.size() / 3;
+
+    // Every vertex's triangles, packed back to back.
+    auto offsets = std::vector<std::uint32_t>(p_vertex_count + 1, 0);
+    for (const auto index : p_indices)
+    {
+        offsets[index + 1]++;
+    }
+    for (auto vertex = std::uint32_t{0}; vertex < p_vertex_count; vertex++)
+    {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+
+    auto adjacency = std::vector<std::uint32_t>(p_indices.size());
+    auto fill_offsets = offsets;
+    for (auto triangle = std::size_t{0}; triangle < triangle_count; triangle++)
+    {
+        for (auto corner = std::size_t{0}; corner < 3; corner++)
+        {
+            const auto vertex = p_indices[triangle * 3 + corner];
+            adjacency[fill_offsets[vertex]++] =
+                static_cast<std::uint32_t>(triangle);
+        }
+    }
+
+    // How many of each vertex's triangles are still to be emitted.
+    auto live_counts = std::vector<std::uint32_t>(p_vertex_count);
+    for (auto vertex = std::uint32_t{0}; vertex < p_vertex_count; vertex++)
+    {
+        live_counts[vertex] = offsets[vertex + 1] - offsets[vertex];
+    }
+
+    // Time counts cache insertions, and starts out far enough ahead that
+    // nothing is cached.
+    auto cache_times = std::vector<std::uint64_t>(p_vertex_count, 0);
+    auto time = static_cast<std::uint64_t>(p_cache_size) + 1;
+
+    auto is_emitted = std::vector<bool>(triangle_count, false);
+    auto dead_ends = std::vector<std::uint32_t>();
+    auto candidates = std::vector<std::uint32_t>();
+    auto cursor = std::uint32_t{0};
+
+    auto output = std::vector<std::uint32_t>();
+    output.reserve(triangle_count * 3);
+
+    // When the fan runs out of cached candidates, it carries on from the
+    // most recently used vertex that still has triangles left, and failing
+    // that, from the next one in input order.
+    const auto skip_dead_end = [&]() -> std::optional<std::uint32_t> {
+        while (!dead_ends.empty())
+        {
+            const auto vertex = dead_ends.back();
+            dead_ends.pop_back();
+            if (live_counts[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+
+        for (; cursor < p_vertex_count; cursor++)
+        {
+            if (live_counts[cursor] > 0)
+            {
+                return cursor;
+            }
+        }
+
+        return std::nullopt;
+    };
+
+    auto fan_vertex = skip_dead_end();
+    while (fan_vertex.has_value())
+    {
+        candidates.clear();
+
+        for (auto i = offsets[*fan_vertex]; i < offsets[*fan_vertex + 1]; i++)
+        {
+            const auto triangle = adjacency[i];
+            if (is_emitted[triangle])
+            {
+                continue;
+            }
+            is_emitted[triangle] = true;
+
+            for (auto corner = std::size_t{0}; corner < 3; corner++)
+            {
+                const auto vertex = p_indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                dead_ends.push_back(vertex);
+                candidates.push_back(vertex);
+                live_counts[vertex]--;
+
+                if (time - cache_times[vertex] > p_cache_size)
+                {
+                    cache_times[vertex] = time;
+                    time++;
+                }
+            }
+        }
+
+        // The oldest candidate that will still be cached once all of its
+        // remaining triangles (each adding up to two new vertices) have been
+        // emitted. Candidates that won't make it rank below every one that
+        // will.
+        auto next_vertex = std::optional<std::uint32_t>();
+        auto best_priority = std::int64_t{-1};
+        for (const auto vertex : candidates)
+        {
+            if (live_counts[vertex] == 0)
+            {
+                continue;
+            }
+
+            const auto age = time - cache_times[vertex];
+            const auto priority =
+                age + 2 * live_counts[vertex] <= p_cache_size
+                    ? static_cast<std::int64_t>(age)
+                    : std::int64_t{0};
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                next_vertex = vertex;
+            }
+        }
+
+        fan_vertex = next_vertex.has_value() ? next_vertex : skip_dead_end();
+    }
+
+    p_indices = std::move(output);
+}
+
+auto optimize_vertex_fetch(indexed_mesh_t& p_mesh) -> void
+{
+    constexpr auto UNUSED = std::numeric_limits<std::uint32_t>::max();
+
+    auto remap = std::vector<std::uint32_t>(p_mesh.vertices.size(), UNUSED);
+    auto vertices = std::vector<vertex_t>();
+    vertices.reserve(p_mesh.vertices.size());
+
+    for (auto& index : p_mesh.indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = static_cast<std::uint32_t>(vertices.size());
+            vertices.push_back(p_mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    p_mesh.vertices = std::move(vertices);
+}
+
+auto analyze_vertex_cache(const std::vector<std::uint32_t>& p_indices,
+                          std::uint32_t p_vertex_count,
+                          std::uint32_t p_cache_size)
+    -> vertex_cache_statistics_t
+{
+    // A vertex is evicted once p_cache_size others have been inserted after
+    // it. Like in optimize_vertex_cache(), time starts out far enough ahead
+    // that nothing is cached.
+    auto cache_times = std::vector<std::uint64_t>(p_vertex_count, 0);
+    auto time = static_cast<std::uint64_t>(p_cache_size) + 1;
+    auto is_used = std::vector<bool>(p_vertex_count, false);
+    auto miss_count = std::uint64_t{0};
+    auto used_count = std::uint64_t{0};
+
+    for (const auto index : p_indices)
+    {
+        if (time - cache_times[index] > p_cache_size)
+        {
+            cache_times[index] = time;
+            time++;
+            miss_count++;
+        }
+
+        if (!is_used[index])
+        {
+            is_used[index] = true;
+            used_count++;
+        }
+    }
+
+    const auto triangle_count = p_indices.size() / 3;
+    return vertex_cache_statistics_t{
+        .acmr = triangle_count > 0 ? static_cast<double>(miss_count) /
+                                         static_cast<double>(triangle_count)
+                                   : 0.0,
+        .atvr = used_count > 0 ? static_cast<double>(miss_count) /
+                                     static_cast<double>(used_count)
+                               : 0.0};
+}
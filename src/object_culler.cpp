@@ -0,0 +1,350 @@
+#include "object_culler.hpp"
+
+namespace
+{
+
+enum class result_t : std::uint8_t
+{
+    visible,
+    outside,
+    too_small,
+};
+
+// Four boxes at a time. Like in the software rasterizer, masks are lanes with
+// all bits set (or 1.0f in the scalar version) where the condition holds.
+#if defined(__SSE2__) || defined(_M_X64)
+
+using lanes_t = __m128;
+
+auto splat(float p_value) -> lanes_t { return _mm_set1_ps(p_value); }
+
+auto load_lanes(const float* p_values) -> lanes_t
+{
+    return _mm_load_ps(p_values);
+}
+
+auto multiply_add(lanes_t p_a, lanes_t p_b, lanes_t p_c) -> lanes_t
+{
+    return _mm_add_ps(_mm_mul_ps(p_a, p_b), p_c);
+}
+
+auto clamp(lanes_t p_value, lanes_t p_min, lanes_t p_max) -> lanes_t
+{
+    return _mm_min_ps(_mm_max_ps(p_value, p_min), p_max);
+}
+
+auto greater_than(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_cmpgt_ps(p_a, p_b);
+}
+
+// Whether the lanes round to the same integer.
+auto round_equal(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_cvtps_epi32(p_a), _mm_cvtps_epi32(p_b)));
+}
+
+auto mask_or(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_or_ps(p_a, p_b);
+}
+
+// Bit i is set if lane i of the mask is.
+auto get_mask_bits(lanes_t p_mask) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(_mm_movemask_ps(p_mask));
+}
+
+#else
+
+struct lanes_t
+{
+    std::array<float, 4> values;
+};
+
+template <typename F>
+auto for_each_lane(lanes_t p_a, lanes_t p_b, F p_function) -> lanes_t
+{
+    auto result = lanes_t{};
+    for (auto i = std::size_t{0}; i < 4; i++)
+    {
+        result.values[i] = p_function(p_a.values[i], p_b.values[i]);
+    }
+    return result;
+}
+
+auto splat(float p_value) -> lanes_t
+{
+    return lanes_t{{p_value, p_value, p_value, p_value}};
+}
+
+auto load_lanes(const float* p_values) -> lanes_t
+{
+    return lanes_t{{p_values[0], p_values[1], p_values[2], p_values[3]}};
+}
+
+auto multiply_add(lanes_t p_a, lanes_t p_b, lanes_t p_c) -> lanes_t
+{
+    const auto product =
+        for_each_lane(p_a, p_b, [](float a, float b) { return a * b; });
+    return for_each_lane(product, p_c,
+                         [](float a, float b) { return a + b; });
+}
+
+auto clamp(lanes_t p_value, lanes_t p_min, lanes_t p_max) -> lanes_t
+{
+    const auto lower = for_each_lane(p_value, p_min, [](float a, float b) {
+        return (std::max)(a, b);
+    });
+    return for_each_lane(lower, p_max,
+                         [](float a, float b) { return (std::min)(a, b); });
+}
+
+auto greater_than(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b,
+                         [](float a, float b) { return a > b ? 1.0f : 0.0f; });
+}
+
+// In the current rounding mode, halves to even by default, like
+// _mm_cvtps_epi32.
+auto round_equal(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b, [](float a, float b) {
+        return std::nearbyint(a) == std::nearbyint(b) ? 1.0f : 0.0f;
+    });
+}
+
+auto mask_or(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b,
+                         [](float a, float b) { return (std::max)(a, b); });
+}
+
+auto get_mask_bits(lanes_t p_mask) -> std::uint32_t
+{
+    auto bits = std::uint32_t{0};
+    for (auto i = std::size_t{0}; i < 4; i++)
+    {
+        if (p_mask.values[i] != 0.0f)
+        {
+            bits |= std::uint32_t{1} << i;
+        }
+    }
+    return bits;
+}
+
+#endif
+
+// A batch's clip space boxes, one array per coordinate.
+struct box_batch_t
+{
+    alignas(16) std::array<float, object_culler_t::BATCH_SIZE> min_x;
+    alignas(16) std::array<float, object_culler_t::BATCH_SIZE> min_y;
+    alignas(16) std::array<float, object_culler_t::BATCH_SIZE> max_x;
+    alignas(16) std::array<float, object_culler_t::BATCH_SIZE> max_y;
+};
+
+auto cull_batch(const push_constants_t* p_draws, std::size_t p_count,
+                const object_bounds_t& p_bounds, VkExtent2D p_viewport,
+                std::uint8_t* p_results) -> void
+{
+    // 16 KiB, which stays in L1 between the two loops. It's left
+    // uninitialized, since every lane is written before it's loaded.
+    box_batch_t boxes;
+
+    const auto center = (p_bounds.min + p_bounds.max) * 0.5f;
+    const auto extent = (p_bounds.max - p_bounds.min) * 0.5f;
+
+    // The box around a transformed box is the transformed center, plus the
+    // extent through the absolute value of the transform.
+    for (auto i = std::size_t{0}; i < p_count; i++)
+    {
+        const auto& draw = p_draws[i];
+        const auto& transform = draw.transform;
+        const auto box_center = transform * center + draw.translation;
+        const auto box_extent =
+            glm::vec2(std::abs(transform[0][0]) * extent.x +
+                          std::abs(transform[1][0]) * extent.y,
+                      std::abs(transform[0][1]) * extent.x +
+                          std::abs(transform[1][1]) * extent.y);
+
+        boxes.min_x[i] = box_center.x - box_extent.x;
+        boxes.min_y[i] = box_center.y - box_extent.y;
+        boxes.max_x[i] = box_center.x + box_extent.x;
+        boxes.max_y[i] = box_center.y + box_extent.y;
+    }
+
+    // The last group's spare lanes are tested too, but never stored.
+    const auto group_end = (p_count + 3) & ~std::size_t{3};
+    for (auto i = p_count; i < group_end; i++)
+    {
+        boxes.min_x[i] = 0.0f;
+        boxes.min_y[i] = 0.0f;
+        boxes.max_x[i] = 0.0f;
+        boxes.max_y[i] = 0.0f;
+    }
+
+    const auto one = splat(1.0f);
+    const auto minus_one = splat(-1.0f);
+
+    // Clip space x maps to (x + 1) / 2 * width pixels, and the same for y.
+    // Clamping to the viewport keeps huge boxes from overflowing the
+    // conversion to integers, and doesn't change which pixel centers they
+    // contain inside of it.
+    const auto half_width = splat(0.5f * static_cast<float>(p_viewport.width));
+    const auto half_height =
+        splat(0.5f * static_cast<float>(p_viewport.height));
+    const auto zero = splat(0.0f);
+    const auto width = splat(static_cast<float>(p_viewport.width));
+    const auto height = splat(static_cast<float>(p_viewport.height));
+
+    for (auto i = std::size_t{0}; i < group_end; i += 4)
+    {
+        const auto min_x = load_lanes(&boxes.min_x[i]);
+        const auto min_y = load_lanes(&boxes.min_y[i]);
+        const auto max_x = load_lanes(&boxes.max_x[i]);
+        const auto max_y = load_lanes(&boxes.max_y[i]);
+
+        const auto outside = mask_or(
+            mask_or(greater_than(minus_one, max_x), greater_than(min_x, one)),
+            mask_or(greater_than(minus_one, max_y), greater_than(min_y, one)));
+
+        // A pixel center lies between two edges exactly when they round to
+        // different integers.
+        const auto pixel_min_x =
+            clamp(multiply_add(min_x, half_width, half_width), zero, width);
+        const auto pixel_max_x =
+            clamp(multiply_add(max_x, half_width, half_width), zero, width);
+        const auto pixel_min_y =
+            clamp(multiply_add(min_y, half_height, half_height), zero, height);
+        const auto pixel_max_y =
+            clamp(multiply_add(max_y, half_height, half_height), zero, height);
+        const auto too_small = mask_or(round_equal(pixel_min_x, pixel_max_x),
+                                       round_equal(pixel_min_y, pixel_max_y));
+
+        const auto outside_bits = get_mask_bits(outside);
+        const auto too_small_bits = get_mask_bits(too_small);
+        const auto lane_count = (std::min)(p_count - i, std::size_t{4});
+        for (auto lane = std::size_t{0}; lane < lane_count; lane++)
+        {
+            const auto bit = std::uint32_t{1} << lane;
+            const auto result = (outside_bits & bit) != 0 ? result_t::outside
+                                : (too_small_bits & bit) != 0
+                                    ? result_t::too_small
+                                    : result_t::visible;
+            p_results[i + lane] = static_cast<std::uint8_t>(result);
+        }
+    }
+}
+
+} // namespace
+
+object_culler_t::object_culler_t(thread_pool_t& p_thread_pool)
+    : m_thread_pool(p_thread_pool), m_results(), m_visible_objects(),
+      m_tested_counts(), m_outside_counts(), m_too_small_counts(),
+      m_cull_times(), m_max_helper_count(0)
+{
+}
+
+auto object_culler_t::run_batches(job_t& p_job) -> void
+{
+    while (true)
+    {
+        const auto batch = p_job.next_batch.fetch_add(1);
+        if (batch >= p_job.batch_count)
+        {
+            return;
+        }
+
+        const auto first = batch * BATCH_SIZE;
+        cull_batch(p_job.draws + first,
+                   (std::min)(p_job.object_count - first, BATCH_SIZE),
+                   p_job.bounds, p_job.viewport, p_job.results + first);
+        p_job.completed_batch_count.fetch_add(1, std::memory_order_release);
+    }
+}
+
+auto object_culler_t::cull(VkExtent2D p_viewport,
+                           const object_bounds_t& p_bounds,
+                           const std::vector<push_constants_t>& p_draws)
+    -> const std::vector<std::uint32_t>&
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto object_count = p_draws.size();
+    m_results.resize(object_count);
+
+    const auto job = std::make_shared<job_t>();
+    job->draws = p_draws.data();
+    job->results = m_results.data();
+    job->object_count = object_count;
+    job->batch_count = (object_count + BATCH_SIZE - 1) / BATCH_SIZE;
+    job->bounds = p_bounds;
+    job->viewport = p_viewport;
+    job->next_batch = 0;
+    job->completed_batch_count = 0;
+
+    // Nothing waits on the helpers themselves, only on the batches, so their
+    // futures are dropped.
+    const auto helper_count =
+        job->batch_count > 0 ? (std::min)(m_thread_pool.get_thread_count(),
+                                          job->batch_count - 1)
+                             : std::size_t{0};
+    for (auto i = std::size_t{0}; i < helper_count; i++)
+    {
+        m_thread_pool.submit([job]() { run_batches(*job); });
+    }
+    m_max_helper_count = (std::max)(m_max_helper_count, helper_count);
+
+    run_batches(*job);
+    while (job->completed_batch_count.load(std::memory_order_acquire) <
+           job->batch_count)
+    {
+        std::this_thread::yield();
+    }
+
+    m_visible_objects.clear();
+    auto outside_count = std::size_t{0};
+    auto too_small_count = std::size_t{0};
+    for (auto i = std::size_t{0}; i < object_count; i++)
+    {
+        switch (static_cast<result_t>(m_results[i]))
+        {
+        case result_t::visible:
+            m_visible_objects.push_back(static_cast<std::uint32_t>(i));
+            break;
+        case result_t::outside:
+            outside_count++;
+            break;
+        case result_t::too_small:
+            too_small_count++;
+            break;
+        }
+    }
+
+    m_tested_counts.add(static_cast<double>(object_count));
+    m_outside_counts.add(static_cast<double>(outside_count));
+    m_too_small_counts.add(static_cast<double>(too_small_count));
+    m_cull_times.add(std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count());
+
+    return m_visible_objects;
+}
+
+auto object_culler_t::print_statistics() const -> void
+{
+    if (m_tested_counts.count == 0)
+    {
+        return;
+    }
+
+    fmt::print("[INFO]: Tested {:.0f} objects per frame on average, culling "
+               "{:.1f} outside the viewport and {:.1f} smaller than a pixel. "
+               "Culling took {:.1f} us on average and {:.1f} us at most, with "
+               "up to {} helper threads.\n",
+               m_tested_counts.mean, m_outside_counts.mean,
+               m_too_small_counts.mean, m_cull_times.mean, m_cull_times.max,
+               m_max_helper_count);
+}
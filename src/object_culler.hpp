@@ -0,0 +1,81 @@
+#ifndef INCLUDED_OBJECT_CULLER_HPP
+#define INCLUDED_OBJECT_CULLER_HPP
+
+#include "running_statistics.hpp"
+#include "shader_interface.hpp"
+#include "thread_pool.hpp"
+
+// An axis aligned box in a mesh's own space.
+struct object_bounds_t
+{
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+// Decides on the CPU which objects are worth drawing, before they're added to
+// the draw list. An object is dropped if its bounds are entirely outside the
+// viewport, or if they're so small that they don't contain a single pixel
+// center in one of the axes, in which case the rasterizer wouldn't have
+// produced any fragments for it anyway.
+//
+// The objects are split into batches of BATCH_SIZE. Each batch first
+// transforms its objects' bounds into clip space boxes, stored as separate
+// arrays of min and max coordinates that fit in L1, and then tests four boxes
+// at a time, with SSE2 where it's available. The pool's threads and the
+// calling thread take batches until there are none left, so a pool that's
+// busy with something else only slows culling down, and never stalls it.
+//
+// The boxes are transformed by each object's push constants alone, so the
+// frame's view_projection has to be the identity, like it is now.
+class object_culler_t
+{
+  public:
+    static constexpr auto BATCH_SIZE = std::size_t{1024};
+
+    explicit object_culler_t(thread_pool_t& p_thread_pool);
+
+    object_culler_t(const object_culler_t&) = delete;
+    auto operator=(const object_culler_t&) -> object_culler_t& = delete;
+
+    // Every object in p_draws has the bounds p_bounds before its transform.
+    // Returns the indices of the objects that survive, in order, valid until
+    // the next call.
+    auto cull(VkExtent2D p_viewport, const object_bounds_t& p_bounds,
+              const std::vector<push_constants_t>& p_draws)
+        -> const std::vector<std::uint32_t>&;
+
+    auto print_statistics() const -> void;
+
+  private:
+    // Shared with the helper jobs, which may only get to run after cull() has
+    // already returned. By then there are no batches left for them to take.
+    struct job_t
+    {
+        const push_constants_t* draws;
+        std::uint8_t* results;
+        std::size_t object_count;
+        std::size_t batch_count;
+        object_bounds_t bounds;
+        VkExtent2D viewport;
+
+        std::atomic<std::size_t> next_batch;
+        std::atomic<std::size_t> completed_batch_count;
+    };
+
+    static auto run_batches(job_t& p_job) -> void;
+
+    thread_pool_t& m_thread_pool;
+
+    // One result_t from object_culler.cpp per object.
+    std::vector<std::uint8_t> m_results;
+    std::vector<std::uint32_t> m_visible_objects;
+
+    // Per frame. Times are in microseconds.
+    running_statistics_t m_tested_counts;
+    running_statistics_t m_outside_counts;
+    running_statistics_t m_too_small_counts;
+    running_statistics_t m_cull_times;
+    std::size_t m_max_helper_count;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "options.hpp"
+
+#include "render_service.hpp"
+
+namespace
+{
+
+// A flag counts as set if the variable exists and isn't "0" or empty. If it
+// doesn't exist, p_default is used instead.
+auto get_environment_flag(const char* p_name, bool p_default = false) -> bool
+{
+    const auto value = std::getenv(p_name);
+    if (value == nullptr)
+    {
+        return p_default;
+    }
+
+    return std::string_view(value) != "" && std::string_view(value) != "0";
+}
+
+auto get_environment_string(const char* p_name) -> std::string
+{
+    const auto value = std::getenv(p_name);
+    return value != nullptr ? std::string(value) : std::string();
+}
+
+#ifdef NDEBUG
+constexpr auto VALIDATION_BY_DEFAULT = false;
+#else
+constexpr auto VALIDATION_BY_DEFAULT = true;
+#endif
+
+auto get_environment_uint(const char* p_name, std::uint32_t p_default)
+    -> std::uint32_t
+{
+    const auto value = std::getenv(p_name);
+    if (value == nullptr)
+    {
+        return p_default;
+    }
+
+    auto result = p_default;
+    const auto end = value + std::strlen(value);
+    const auto [pointer, error] = std::from_chars(value, end, result);
+    if (error != std::errc() || pointer != end)
+    {
+        fmt::print(stderr,
+                   "[ERROR]: {} should be a non-negative integer, not \"{}\". "
+                   "Using {} instead.\n",
+                   p_name, value, p_default);
+        return p_default;
+    }
+
+    return result;
+}
+
+} // namespace
+
+auto load_options() -> options_t
+{
+    return options_t{
+        .validation = get_environment_flag("VULKAN_TRIANGLE_VALIDATION",
+                                           VALIDATION_BY_DEFAULT),
+        .hot_reload_shaders = get_environment_flag("VULKAN_TRIANGLE_HOT_RELOAD"),
+        .dynamic_rendering =
+            get_environment_flag("VULKAN_TRIANGLE_DYNAMIC_RENDERING"),
+        .object_count =
+            (std::max)(get_environment_uint("VULKAN_TRIANGLE_OBJECT_COUNT", 1),
+                       1u),
+        .mixed_state = get_environment_flag("VULKAN_TRIANGLE_MIXED_STATE"),
+        .overdraw = (std::max)(
+            get_environment_uint("VULKAN_TRIANGLE_OVERDRAW", 1), 1u),
+        .depth = get_environment_flag("VULKAN_TRIANGLE_DEPTH"),
+        .subdivisions = (std::min)(
+            get_environment_uint("VULKAN_TRIANGLE_SUBDIVISIONS", 0),
+            render_service_t::MAX_SUBDIVISIONS),
+        .optimize_meshes =
+            get_environment_flag("VULKAN_TRIANGLE_OPTIMIZE_MESHES", true),
+        .cpu_culling =
+            get_environment_flag("VULKAN_TRIANGLE_CPU_CULLING", true),
+        .texture_path = get_environment_string("VULKAN_TRIANGLE_TEXTURE"),
+        .particle_count =
+            get_environment_uint("VULKAN_TRIANGLE_PARTICLE_COUNT", 0),
+        .device = get_environment_string("VULKAN_TRIANGLE_DEVICE"),
+        .target_fps = get_environment_uint("VULKAN_TRIANGLE_TARGET_FPS", 0),
+        .low_latency = get_environment_flag("VULKAN_TRIANGLE_LOW_LATENCY"),
+        .on_demand_redraw = get_environment_flag("VULKAN_TRIANGLE_ON_DEMAND"),
+        .animation_fps =
+            get_environment_uint("VULKAN_TRIANGLE_ANIMATION_FPS", 0),
+        .window_count =
+            (std::max)(get_environment_uint("VULKAN_TRIANGLE_WINDOW_COUNT", 1),
+                       1u),
+        .async_compute =
+            get_environment_flag("VULKAN_TRIANGLE_ASYNC_COMPUTE", true),
+        .service_endpoint = get_environment_string("VULKAN_TRIANGLE_SERVICE"),
+        .stream_path = get_environment_string("VULKAN_TRIANGLE_STREAM"),
+        .stream_chunk_triangle_count = get_environment_uint(
+            "VULKAN_TRIANGLE_STREAM_CHUNK_TRIANGLES", 262144),
+        .stream_buffer_count = std::clamp(
+            get_environment_uint("VULKAN_TRIANGLE_STREAM_BUFFERS", 3), 2u, 3u),
+        .stream_frame_count =
+            (std::max)(get_environment_uint("VULKAN_TRIANGLE_STREAM_FRAMES", 1),
+                       1u),
+    };
+}
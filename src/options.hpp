@@ -0,0 +1,121 @@
+#ifndef INCLUDED_OPTIONS_HPP
+#define INCLUDED_OPTIONS_HPP
+
+// Runtime options. These are all read from environment variables, so that they
+// work the same way no matter how the program was launched (including through
+// wWinMain on Windows, which doesn't get a usable argv).
+struct options_t
+{
+    // VULKAN_TRIANGLE_VALIDATION: load VK_LAYER_KHRONOS_validation and log its
+    // messages. Defaults to on in debug builds and off when NDEBUG is defined.
+    bool validation;
+
+    // VULKAN_TRIANGLE_HOT_RELOAD: watch the shaders directory and rebuild the
+    // graphics pipeline in the background whenever a GLSL source changes.
+    bool hot_reload_shaders;
+
+    // VULKAN_TRIANGLE_DYNAMIC_RENDERING: render with VK_KHR_dynamic_rendering
+    // instead of render pass and framebuffer objects, if the device allows it.
+    bool dynamic_rendering;
+
+    // VULKAN_TRIANGLE_OBJECT_COUNT: how many animated triangles to draw. Each
+    // one is positioned with push constants. Defaults to 1.
+    std::uint32_t object_count;
+
+    // VULKAN_TRIANGLE_MIXED_STATE: give neighboring objects different color
+    // modes and vertex buffers, so that drawing them in order would need a
+    // bind for nearly every draw.
+    bool mixed_state;
+
+    // VULKAN_TRIANGLE_OVERDRAW: scale the objects up so that they overlap
+    // their neighbors, covering the window roughly this many times over.
+    // Defaults to 1, where they don't overlap at all.
+    std::uint32_t overdraw;
+
+    // VULKAN_TRIANGLE_DEPTH: draw with a depth buffer, giving each object its
+    // own depth and drawing the opaque ones front to back, so that hidden
+    // fragments are rejected before they're shaded. Only affects the windows.
+    bool depth;
+
+    // VULKAN_TRIANGLE_SUBDIVISIONS: how many times to subdivide the windows'
+    // triangle, each level quadrupling its triangle count. Defaults to 0, and
+    // is capped at render_service_t::MAX_SUBDIVISIONS.
+    std::uint32_t subdivisions;
+
+    // VULKAN_TRIANGLE_OPTIMIZE_MESHES: reorder the meshes' triangles for the
+    // post-transform vertex cache, and their vertices for fetch locality, when
+    // they're created. Defaults to on.
+    bool optimize_meshes;
+
+    // VULKAN_TRIANGLE_CPU_CULLING: leave out the windows' objects that are
+    // outside the viewport or smaller than a pixel before they're added to
+    // the draw list. Defaults to on.
+    bool cpu_culling;
+
+    // VULKAN_TRIANGLE_TEXTURE: a KTX2 file with pre-built BC1 or BC7 mips to
+    // texture the objects with. Empty means untextured.
+    std::string texture_path;
+
+    // VULKAN_TRIANGLE_PARTICLE_COUNT: how many particles a compute shader
+    // generates on the GPU every frame. Defaults to 0, which disables it.
+    std::uint32_t particle_count;
+
+    // VULKAN_TRIANGLE_DEVICE: the physical device to use, given as either its
+    // UUID or part of its name. Empty means pick one automatically.
+    std::string device;
+
+    // VULKAN_TRIANGLE_TARGET_FPS: cap the frame rate, sleeping between frames
+    // instead of rendering ones that are never shown. Defaults to 0, no cap.
+    std::uint32_t target_fps;
+
+    // VULKAN_TRIANGLE_LOW_LATENCY: delay polling input until just before a
+    // frame is recorded, and wait for the previous frame to be displayed
+    // first if VK_KHR_present_wait is available.
+    bool low_latency;
+
+    // VULKAN_TRIANGLE_ON_DEMAND: only render when something changed, and
+    // sleep in glfwWaitEvents otherwise.
+    bool on_demand_redraw;
+
+    // VULKAN_TRIANGLE_ANIMATION_FPS: in on-demand mode, how many times a
+    // second to redraw the animation anyway. Defaults to 0, which freezes it
+    // between other redraws.
+    std::uint32_t animation_fps;
+
+    // VULKAN_TRIANGLE_WINDOW_COUNT: how many windows to render to. They share
+    // the device and everything on it, and are submitted and presented
+    // together. Defaults to 1.
+    std::uint32_t window_count;
+
+    // VULKAN_TRIANGLE_ASYNC_COMPUTE: generate particles on a compute-only
+    // queue family, overlapping with the graphics queue, if the device has
+    // one. Defaults to on. Turning it off submits the same work to the
+    // graphics queue instead.
+    bool async_compute;
+
+    // VULKAN_TRIANGLE_SERVICE: run as a headless render service instead of
+    // opening windows, taking jobs from "-" (the standard input) or from a
+    // Unix domain socket at the given path. Empty means off.
+    std::string service_endpoint;
+
+    // VULKAN_TRIANGLE_STREAM: draw a file of vertices headlessly instead of
+    // opening windows, streaming it through a few device buffers a chunk at
+    // a time, however large it is. Empty means off.
+    std::string stream_path;
+
+    // VULKAN_TRIANGLE_STREAM_CHUNK_TRIANGLES: how many triangles each chunk
+    // holds, rounded up to a multiple of 65536. Defaults to 262144.
+    std::uint32_t stream_chunk_triangle_count;
+
+    // VULKAN_TRIANGLE_STREAM_BUFFERS: how many chunks can be in flight, 2 or
+    // 3. Defaults to 3.
+    std::uint32_t stream_buffer_count;
+
+    // VULKAN_TRIANGLE_STREAM_FRAMES: how many times to draw the whole file.
+    // Defaults to 1.
+    std::uint32_t stream_frame_count;
+};
+
+auto load_options() -> options_t;
+
+#endif
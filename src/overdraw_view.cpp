@@ -0,0 +1,654 @@
+#include "overdraw_view.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(1);
+
+// Counts are never negative, and stay far below infinity.
+auto half_to_float(std::uint16_t p_half) -> float
+{
+    const auto exponent = static_cast<int>((p_half >> 10) & 0x1f);
+    const auto mantissa = static_cast<float>(p_half & 0x3ff);
+
+    return exponent == 0 ? std::ldexp(mantissa, -24)
+                         : std::ldexp(mantissa + 1024.0f, exponent - 25);
+}
+
+auto choose_format(VkPhysicalDevice p_physical_device) -> VkFormat
+{
+    constexpr auto REQUIRED_FEATURES = static_cast<VkFormatFeatureFlags>(
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+    auto properties = VkFormatProperties{};
+    vkGetPhysicalDeviceFormatProperties(p_physical_device, VK_FORMAT_R32_SFLOAT,
+                                        &properties);
+
+    return (properties.optimalTilingFeatures & REQUIRED_FEATURES) ==
+                   REQUIRED_FEATURES
+               ? VK_FORMAT_R32_SFLOAT
+               : VK_FORMAT_R16_SFLOAT;
+}
+
+auto get_texel_size(VkFormat p_format) -> VkDeviceSize
+{
+    return p_format == VK_FORMAT_R32_SFLOAT ? 4 : 2;
+}
+
+} // namespace
+
+overdraw_view_t::overdraw_view_t(VkPhysicalDevice p_physical_device,
+                                 VkDevice p_device,
+                                 VkPipelineCache p_pipeline_cache,
+                                 VkShaderModule p_vertex_shader_module,
+                                 VkShaderModule p_fragment_shader_module,
+                                 VkRenderPass p_render_pass,
+                                 VkFormat p_color_format,
+                                 VkFormat p_depth_format,
+                                 const std::vector<VkExtent2D>& p_extents)
+    : m_device(p_device), m_format(choose_format(p_physical_device)),
+      m_extent{.width = 0, .height = 0}, m_targets(), m_image_views(),
+      m_sampler(), m_descriptor_set_layout(), m_descriptor_pool(),
+      m_pipeline_layout(), m_pipeline(), m_total_counts(), m_average_counts(),
+      m_max_counts(), m_last_report_time()
+{
+    for (const auto& extent : p_extents)
+    {
+        m_extent.width = (std::max)(m_extent.width, extent.width);
+        m_extent.height = (std::max)(m_extent.height, extent.height);
+    }
+
+    const auto sampler_create_info = VkSamplerCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE};
+
+    auto sampler = static_cast<VkSampler>(VK_NULL_HANDLE);
+    const auto sampler_result =
+        vkCreateSampler(p_device, &sampler_create_info, nullptr, &sampler);
+    if (sampler_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the overdraw sampler. "
+                   "Vulkan error {}.\n",
+                   sampler_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_sampler = unique_sampler_t(sampler, {p_device});
+
+    const auto binding = VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .pImmutableSamplers = nullptr};
+
+    const auto layout_create_info = VkDescriptorSetLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = 1,
+        .pBindings = &binding};
+
+    auto descriptor_set_layout =
+        static_cast<VkDescriptorSetLayout>(VK_NULL_HANDLE);
+    const auto layout_result = vkCreateDescriptorSetLayout(
+        p_device, &layout_create_info, nullptr, &descriptor_set_layout);
+    if (layout_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the overdraw descriptor "
+                   "set layout. Vulkan error {}.\n",
+                   layout_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_set_layout =
+        unique_descriptor_set_layout_t(descriptor_set_layout, {p_device});
+
+    const auto target_count = static_cast<std::uint32_t>(p_extents.size());
+    const auto pool_size =
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                             .descriptorCount = target_count};
+
+    const auto pool_create_info = VkDescriptorPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = target_count,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size};
+
+    auto descriptor_pool = static_cast<VkDescriptorPool>(VK_NULL_HANDLE);
+    const auto pool_result = vkCreateDescriptorPool(
+        p_device, &pool_create_info, nullptr, &descriptor_pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the overdraw descriptor "
+                   "pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_pool = unique_descriptor_pool_t(descriptor_pool, {p_device});
+
+    for (const auto& extent : p_extents)
+    {
+        const auto image_create_info = VkImageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = m_format,
+            .extent = VkExtent3D{.width = m_extent.width,
+                                 .height = m_extent.height,
+                                 .depth = 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                     VK_IMAGE_USAGE_SAMPLED_BIT |
+                     VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+        auto image = static_cast<VkImage>(VK_NULL_HANDLE);
+        const auto image_result =
+            vkCreateImage(p_device, &image_create_info, nullptr, &image);
+        if (image_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create an overdraw target. "
+                       "Vulkan error {}.\n",
+                       image_result);
+            std::exit(EXIT_FAILURE);
+        }
+        auto image_owner = unique_image_t(image, {p_device});
+
+        auto memory_requirements = VkMemoryRequirements{};
+        vkGetImageMemoryRequirements(p_device, image, &memory_requirements);
+
+        const auto memory_type = find_memory_type(
+            p_physical_device, memory_requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!memory_type.has_value())
+        {
+            fmt::print("[FATAL ERROR]: Failed to find device local memory for "
+                       "an overdraw target.\n");
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto allocate_info = VkMemoryAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = memory_requirements.size,
+            .memoryTypeIndex = *memory_type};
+
+        auto image_memory = static_cast<VkDeviceMemory>(VK_NULL_HANDLE);
+        const auto allocate_result =
+            vkAllocateMemory(p_device, &allocate_info, nullptr, &image_memory);
+        if (allocate_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to allocate memory for an "
+                       "overdraw target. Vulkan error {}.\n",
+                       allocate_result);
+            std::exit(EXIT_FAILURE);
+        }
+        auto image_memory_owner =
+            unique_device_memory_t(image_memory, {p_device});
+        vkBindImageMemory(p_device, image, image_memory, 0);
+
+        const auto view_create_info = VkImageViewCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = m_format,
+            .components =
+                VkComponentMapping{.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+            .subresourceRange =
+                VkImageSubresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                        .baseMipLevel = 0,
+                                        .levelCount = 1,
+                                        .baseArrayLayer = 0,
+                                        .layerCount = 1}};
+
+        auto image_view = static_cast<VkImageView>(VK_NULL_HANDLE);
+        const auto view_result = vkCreateImageView(p_device, &view_create_info,
+                                                   nullptr, &image_view);
+        if (view_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create an overdraw target's "
+                       "image view. Vulkan error {}.\n",
+                       view_result);
+            std::exit(EXIT_FAILURE);
+        }
+        m_image_views.push_back(unique_image_view_t(image_view, {p_device}));
+
+        const auto set_allocate_info = VkDescriptorSetAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .descriptorPool = descriptor_pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &descriptor_set_layout};
+
+        auto descriptor_set = static_cast<VkDescriptorSet>(VK_NULL_HANDLE);
+        const auto set_result = vkAllocateDescriptorSets(
+            p_device, &set_allocate_info, &descriptor_set);
+        if (set_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to allocate an overdraw "
+                       "descriptor set. Vulkan error {}.\n",
+                       set_result);
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto image_info = VkDescriptorImageInfo{
+            .sampler = sampler,
+            .imageView = image_view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        const auto write = VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptor_set,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &image_info,
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr};
+        vkUpdateDescriptorSets(p_device, 1, &write, 0, nullptr);
+
+        // Only the window's own extent is read back.
+        const auto readback_size = static_cast<VkDeviceSize>(extent.width) *
+                                   extent.height * get_texel_size(m_format);
+        auto [readback_buffer, readback_memory] = create_buffer(
+            p_physical_device, p_device, readback_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        // Unmapped when the memory is freed.
+        auto readback_data = static_cast<void*>(nullptr);
+        vkMapMemory(p_device, readback_memory.get(), 0, readback_size, 0,
+                    &readback_data);
+
+        m_targets.push_back(target_t{
+            .extent = extent,
+            .image = std::move(image_owner),
+            .image_memory = std::move(image_memory_owner),
+            .descriptor_set = descriptor_set,
+            .readback_buffer = std::move(readback_buffer),
+            .readback_memory = std::move(readback_memory),
+            .readback_data = static_cast<const std::byte*>(readback_data),
+            .is_written = false,
+            .max_count = 1.0f});
+    }
+
+    create_pipeline(p_pipeline_cache, p_vertex_shader_module,
+                    p_fragment_shader_module, p_render_pass, p_color_format,
+                    p_depth_format);
+
+    fmt::print("[INFO]: Counting fragments in {} targets of {}x{}.\n",
+               m_format == VK_FORMAT_R32_SFLOAT ? "R32_SFLOAT" : "R16_SFLOAT",
+               m_extent.width, m_extent.height);
+}
+
+auto overdraw_view_t::create_pipeline(VkPipelineCache p_pipeline_cache,
+                                      VkShaderModule p_vertex_shader_module,
+                                      VkShaderModule p_fragment_shader_module,
+                                      VkRenderPass p_render_pass,
+                                      VkFormat p_color_format,
+                                      VkFormat p_depth_format) -> void
+{
+    // The color map's top end.
+    const auto push_constant_range =
+        VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                            .offset = 0,
+                            .size = sizeof(float)};
+
+    const auto descriptor_set_layout = m_descriptor_set_layout.get();
+    const auto layout_create_info = VkPipelineLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount = 1,
+        .pSetLayouts = &descriptor_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range};
+
+    auto pipeline_layout = static_cast<VkPipelineLayout>(VK_NULL_HANDLE);
+    const auto layout_result = vkCreatePipelineLayout(
+        m_device, &layout_create_info, nullptr, &pipeline_layout);
+    if (layout_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the heat map pipeline "
+                   "layout. Vulkan error {}.\n",
+                   layout_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_pipeline_layout = unique_pipeline_layout_t(pipeline_layout, {m_device});
+
+    const auto shader_stages = std::array<VkPipelineShaderStageCreateInfo, 2>{
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = p_vertex_shader_module,
+            .pName = "main",
+            .pSpecializationInfo = nullptr},
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = p_fragment_shader_module,
+            .pName = "main",
+            .pSpecializationInfo = nullptr}};
+
+    const auto dynamic_states = std::array<VkDynamicState, 2>{
+        VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    const auto dynamic_state = VkPipelineDynamicStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .dynamicStateCount = static_cast<std::uint32_t>(dynamic_states.size()),
+        .pDynamicStates = dynamic_states.data()};
+
+    // The full screen triangle is made up in the vertex shader.
+    const auto vertex_input = VkPipelineVertexInputStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .vertexBindingDescriptionCount = 0,
+        .pVertexBindingDescriptions = nullptr,
+        .vertexAttributeDescriptionCount = 0,
+        .pVertexAttributeDescriptions = nullptr};
+
+    const auto input_assembly = VkPipelineInputAssemblyStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .primitiveRestartEnable = VK_FALSE};
+
+    const auto viewport_state = VkPipelineViewportStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .viewportCount = 1,
+        .pViewports = nullptr,
+        .scissorCount = 1,
+        .pScissors = nullptr};
+
+    const auto rasterization = VkPipelineRasterizationStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_CLOCKWISE,
+        .depthBiasEnable = VK_FALSE,
+        .depthBiasConstantFactor = 0.0f,
+        .depthBiasClamp = 0.0f,
+        .depthBiasSlopeFactor = 0.0f,
+        .lineWidth = 1.0f};
+
+    const auto multisampling = VkPipelineMultisampleStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .sampleShadingEnable = VK_FALSE,
+        .minSampleShading = 0.0f,
+        .pSampleMask = nullptr,
+        .alphaToCoverageEnable = VK_FALSE,
+        .alphaToOneEnable = VK_FALSE};
+
+    // The window's depth buffer, if it has one, is cleared by the render pass
+    // and otherwise left alone.
+    const auto depth_stencil_state = VkPipelineDepthStencilStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .depthTestEnable = VK_FALSE,
+        .depthWriteEnable = VK_FALSE,
+        .depthCompareOp = VK_COMPARE_OP_ALWAYS,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+        .front = {},
+        .back = {},
+        .minDepthBounds = 0.0f,
+        .maxDepthBounds = 1.0f};
+
+    const auto color_blend_attachment = VkPipelineColorBlendAttachmentState{
+        .blendEnable = VK_FALSE,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT};
+
+    const auto color_blending = VkPipelineColorBlendStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = 1,
+        .pAttachments = &color_blend_attachment,
+        .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}};
+
+    const auto rendering_info = VkPipelineRenderingCreateInfoKHR{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .pNext = nullptr,
+        .viewMask = 0,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &p_color_format,
+        .depthAttachmentFormat = p_depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED};
+
+    const auto create_info = VkGraphicsPipelineCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = p_render_pass == VK_NULL_HANDLE ? &rendering_info : nullptr,
+        .flags = 0,
+        .stageCount = static_cast<std::uint32_t>(shader_stages.size()),
+        .pStages = shader_stages.data(),
+        .pVertexInputState = &vertex_input,
+        .pInputAssemblyState = &input_assembly,
+        .pTessellationState = nullptr,
+        .pViewportState = &viewport_state,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisampling,
+        .pDepthStencilState = p_depth_format != VK_FORMAT_UNDEFINED
+                                  ? &depth_stencil_state
+                                  : nullptr,
+        .pColorBlendState = &color_blending,
+        .pDynamicState = &dynamic_state,
+        .layout = pipeline_layout,
+        .renderPass = p_render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = 0};
+
+    auto pipeline = static_cast<VkPipeline>(VK_NULL_HANDLE);
+    const auto result = vkCreateGraphicsPipelines(
+        m_device, p_pipeline_cache, 1, &create_info, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the heat map pipeline. "
+                   "Vulkan error {}.\n",
+                   result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_pipeline = unique_pipeline_t(pipeline, {m_device});
+}
+
+auto overdraw_view_t::record_readback(VkCommandBuffer p_command_buffer,
+                                      std::uint32_t p_slot) -> void
+{
+    auto& target = m_targets[p_slot];
+
+    const auto region = VkBufferImageCopy{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            VkImageSubresourceLayers{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                     .mipLevel = 0,
+                                     .baseArrayLayer = 0,
+                                     .layerCount = 1},
+        .imageOffset = VkOffset3D{.x = 0, .y = 0, .z = 0},
+        .imageExtent = VkExtent3D{.width = target.extent.width,
+                                  .height = target.extent.height,
+                                  .depth = 1}};
+    vkCmdCopyImageToBuffer(p_command_buffer, target.image.get(),
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           target.readback_buffer.get(), 1, &region);
+
+    // The render graph doesn't know about the host, so the copy is made
+    // visible to it by hand.
+    const auto host_barrier =
+        VkMemoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                        .pNext = nullptr,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = VK_ACCESS_HOST_READ_BIT};
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &host_barrier, 0,
+                         nullptr, 0, nullptr);
+
+    target.is_written = true;
+}
+
+auto overdraw_view_t::record_heat_map(VkCommandBuffer p_command_buffer,
+                                      std::uint32_t p_slot) -> void
+{
+    const auto& target = m_targets[p_slot];
+
+    vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      m_pipeline.get());
+    vkCmdBindDescriptorSets(p_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            m_pipeline_layout.get(), 0, 1,
+                            &target.descriptor_set, 0, nullptr);
+
+    const auto viewport =
+        VkViewport{.x = 0.0f,
+                   .y = 0.0f,
+                   .width = static_cast<float>(target.extent.width),
+                   .height = static_cast<float>(target.extent.height),
+                   .minDepth = 0.0f,
+                   .maxDepth = 1.0f};
+    vkCmdSetViewport(p_command_buffer, 0, 1, &viewport);
+
+    const auto scissor = VkRect2D{.offset = VkOffset2D{.x = 0, .y = 0},
+                                  .extent = target.extent};
+    vkCmdSetScissor(p_command_buffer, 0, 1, &scissor);
+
+    vkCmdPushConstants(p_command_buffer, m_pipeline_layout.get(),
+                       VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float),
+                       &target.max_count);
+    vkCmdDraw(p_command_buffer, 3, 1, 0, 0);
+}
+
+auto overdraw_view_t::collect(std::uint32_t p_slot) -> void
+{
+    auto& target = m_targets[p_slot];
+    if (!target.is_written)
+    {
+        return;
+    }
+    target.is_written = false;
+
+    const auto pixel_count =
+        static_cast<std::size_t>(target.extent.width) * target.extent.height;
+
+    auto total = 0.0;
+    auto max = 0.0f;
+    auto covered_count = std::size_t{0};
+    const auto add = [&](float p_count) {
+        total += static_cast<double>(p_count);
+        max = (std::max)(max, p_count);
+        covered_count += p_count > 0.0f ? 1 : 0;
+    };
+
+    if (m_format == VK_FORMAT_R32_SFLOAT)
+    {
+        const auto counts =
+            reinterpret_cast<const float*>(target.readback_data);
+        for (auto i = std::size_t{0}; i < pixel_count; i++)
+        {
+            add(counts[i]);
+        }
+    }
+    else
+    {
+        const auto counts =
+            reinterpret_cast<const std::uint16_t*>(target.readback_data);
+        for (auto i = std::size_t{0}; i < pixel_count; i++)
+        {
+            add(half_to_float(counts[i]));
+        }
+    }
+
+    const auto average = total / static_cast<double>(pixel_count);
+    m_total_counts.add(total);
+    m_average_counts.add(average);
+    m_max_counts.add(static_cast<double>(max));
+    target.max_count = (std::max)(max, 1.0f);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_last_report_time >= REPORT_INTERVAL)
+    {
+        m_last_report_time = now;
+        fmt::print("[INFO]: Overdraw in window {}: {:.0f} fragments, {:.2f} "
+                   "per pixel and {:.2f} per covered pixel on average, {:.0f} "
+                   "at most.\n",
+                   p_slot, total, average,
+                   covered_count > 0
+                       ? total / static_cast<double>(covered_count)
+                       : 0.0,
+                   max);
+    }
+}
+
+auto overdraw_view_t::print_statistics() const -> void
+{
+    if (m_total_counts.count == 0)
+    {
+        return;
+    }
+
+    fmt::print("[INFO]: Over {} frames with the overdraw view, each window "
+               "had {:.0f} fragments on average, {:.2f} per pixel, and at "
+               "most {:.0f} on one pixel.\n",
+               m_total_counts.count, m_total_counts.mean,
+               m_average_counts.mean, m_max_counts.max);
+}
@@ -0,0 +1,121 @@
+#ifndef INCLUDED_OVERDRAW_VIEW_HPP
+#define INCLUDED_OVERDRAW_VIEW_HPP
+
+#include "running_statistics.hpp"
+#include "vulkan_handle.hpp"
+
+// A debug view of where the fragment work goes. Instead of the scene, every
+// window shows how many fragments landed on each of its pixels.
+//
+// The scene is drawn into a single channel float target per window, with a
+// fragment shader that outputs 1 and additive blending, so each pixel ends up
+// holding its fragment count. The target is then copied into a host visible
+// buffer, and a full screen pass color maps it onto the window, from blue
+// through green and yellow to red at the previous frame's maximum. Once the
+// frame's fence has been waited on, the counts are summed up on the CPU,
+// which gives the frame's total, average and maximum overdraw.
+//
+// The targets are R32_SFLOAT where the device can blend it, and R16_SFLOAT
+// (which every device can) otherwise. Both count exactly up to 2048.
+class overdraw_view_t
+{
+  public:
+    // The heat map is drawn into the same render targets as the scene, which
+    // p_render_pass (VK_NULL_HANDLE with dynamic rendering), p_color_format
+    // and p_depth_format (VK_FORMAT_UNDEFINED without a depth buffer)
+    // describe. There's a target for each of p_extents, one per window.
+    overdraw_view_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                    VkPipelineCache p_pipeline_cache,
+                    VkShaderModule p_vertex_shader_module,
+                    VkShaderModule p_fragment_shader_module,
+                    VkRenderPass p_render_pass, VkFormat p_color_format,
+                    VkFormat p_depth_format,
+                    const std::vector<VkExtent2D>& p_extents);
+
+    overdraw_view_t(const overdraw_view_t&) = delete;
+    auto operator=(const overdraw_view_t&) -> overdraw_view_t& = delete;
+
+    // What the fragments are counted in.
+    auto get_format() const -> VkFormat { return m_format; }
+
+    // Every target is the size of the largest window, and each window only
+    // uses its own extent from the top left corner.
+    auto get_extent() const -> VkExtent2D { return m_extent; }
+    auto get_image_views() const -> const std::vector<unique_image_view_t>&
+    {
+        return m_image_views;
+    }
+    auto get_image(std::uint32_t p_slot) const -> VkImage
+    {
+        return m_targets[p_slot].image.get();
+    }
+    auto get_readback_buffer(std::uint32_t p_slot) const -> VkBuffer
+    {
+        return m_targets[p_slot].readback_buffer.get();
+    }
+
+    // Copies p_slot's counts into its readback buffer, and makes them visible
+    // to the host. The target has to be in
+    // VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL.
+    auto record_readback(VkCommandBuffer p_command_buffer,
+                         std::uint32_t p_slot) -> void;
+
+    // Draws p_slot's heat map. Has to be recorded inside a render pass (or
+    // dynamic rendering instance) on the window's render target, and the
+    // target has to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+    auto record_heat_map(VkCommandBuffer p_command_buffer,
+                         std::uint32_t p_slot) -> void;
+
+    // Sums up the counts p_slot read back in the last frame, which has to
+    // have completed. Prints them about once a second.
+    auto collect(std::uint32_t p_slot) -> void;
+
+    auto print_statistics() const -> void;
+
+  private:
+    struct target_t
+    {
+        VkExtent2D extent;
+
+        unique_image_t image;
+        unique_device_memory_t image_memory;
+        VkDescriptorSet descriptor_set;
+
+        unique_buffer_t readback_buffer;
+        unique_device_memory_t readback_memory;
+        const std::byte* readback_data;
+
+        // Whether the readback was recorded since it was last collected.
+        bool is_written;
+
+        // The color map's top end, from the previous frame.
+        float max_count;
+    };
+
+    auto create_pipeline(VkPipelineCache p_pipeline_cache,
+                         VkShaderModule p_vertex_shader_module,
+                         VkShaderModule p_fragment_shader_module,
+                         VkRenderPass p_render_pass, VkFormat p_color_format,
+                         VkFormat p_depth_format) -> void;
+
+    VkDevice m_device;
+    VkFormat m_format;
+    VkExtent2D m_extent;
+
+    std::vector<target_t> m_targets;
+    std::vector<unique_image_view_t> m_image_views;
+
+    unique_sampler_t m_sampler;
+    unique_descriptor_set_layout_t m_descriptor_set_layout;
+    unique_descriptor_pool_t m_descriptor_pool;
+    unique_pipeline_layout_t m_pipeline_layout;
+    unique_pipeline_t m_pipeline;
+
+    // Per window and frame.
+    running_statistics_t m_total_counts;
+    running_statistics_t m_average_counts;
+    running_statistics_t m_max_counts;
+    std::chrono::steady_clock::time_point m_last_report_time;
+};
+
+#endif
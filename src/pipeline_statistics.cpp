@@ -0,0 +1,187 @@
+#include "pipeline_statistics.hpp"
+
+namespace
+{
+
+constexpr auto PIPELINE_STATISTICS =
+    static_cast<VkQueryPipelineStatisticFlags>(
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT);
+
+auto create_query_pool(VkDevice p_device, VkQueryType p_type,
+                       std::uint32_t p_query_count,
+                       VkQueryPipelineStatisticFlags p_statistics)
+    -> unique_query_pool_t
+{
+    const auto create_info =
+        VkQueryPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                              .pNext = nullptr,
+                              .flags = 0,
+                              .queryType = p_type,
+                              .queryCount = p_query_count,
+                              .pipelineStatistics = p_statistics};
+
+    auto query_pool = static_cast<VkQueryPool>(VK_NULL_HANDLE);
+    const auto result =
+        vkCreateQueryPool(p_device, &create_info, nullptr, &query_pool);
+    if (result != VK_SUCCESS)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Failed to create a query pool for the pipeline "
+                   "statistics. Vulkan error {}.\n",
+                   result);
+        return unique_query_pool_t();
+    }
+
+    return unique_query_pool_t(query_pool, {p_device});
+}
+
+} // namespace
+
+pipeline_statistics_t::pipeline_statistics_t(VkPhysicalDevice p_physical_device,
+                                             VkDevice p_device,
+                                             std::uint32_t p_graphics_family,
+                                             std::uint32_t p_slot_count)
+    : m_device(p_device), m_statistics_pool(), m_timestamp_pool(),
+      m_timestamp_period(0.0), m_written(p_slot_count, false),
+      m_vertex_invocations(), m_primitives(), m_fragment_invocations(),
+      m_fragments_per_pixel(), m_gpu_times()
+{
+    // create_logical_device enables the feature wherever it's supported.
+    auto features = VkPhysicalDeviceFeatures{};
+    vkGetPhysicalDeviceFeatures(p_physical_device, &features);
+    if (features.pipelineStatisticsQuery == VK_TRUE)
+    {
+        m_statistics_pool =
+            create_query_pool(p_device, VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                              p_slot_count, PIPELINE_STATISTICS);
+    }
+
+    auto family_count = std::uint32_t{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device, &family_count,
+                                             nullptr);
+    auto families = std::vector<VkQueueFamilyProperties>(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(p_physical_device, &family_count,
+                                             families.data());
+
+    if (p_graphics_family < families.size() &&
+        families[p_graphics_family].timestampValidBits != 0)
+    {
+        m_timestamp_pool = create_query_pool(
+            p_device, VK_QUERY_TYPE_TIMESTAMP, p_slot_count * 2, 0);
+
+        auto properties = VkPhysicalDeviceProperties{};
+        vkGetPhysicalDeviceProperties(p_physical_device, &properties);
+        m_timestamp_period =
+            static_cast<double>(properties.limits.timestampPeriod);
+    }
+
+    if (m_statistics_pool.get() == VK_NULL_HANDLE)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: The device doesn't support pipeline statistics "
+                   "queries, so shader invocations won't be counted.\n");
+    }
+}
+
+auto pipeline_statistics_t::record_begin(VkCommandBuffer p_command_buffer,
+                                         std::uint32_t p_slot) -> void
+{
+    if (const auto pool = m_statistics_pool.get(); pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(p_command_buffer, pool, p_slot, 1);
+        vkCmdBeginQuery(p_command_buffer, pool, p_slot, 0);
+    }
+
+    if (const auto pool = m_timestamp_pool.get(); pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(p_command_buffer, pool, p_slot * 2, 2);
+        vkCmdWriteTimestamp(p_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            pool, p_slot * 2);
+    }
+}
+
+auto pipeline_statistics_t::record_end(VkCommandBuffer p_command_buffer,
+                                       std::uint32_t p_slot) -> void
+{
+    if (const auto pool = m_statistics_pool.get(); pool != VK_NULL_HANDLE)
+    {
+        vkCmdEndQuery(p_command_buffer, pool, p_slot);
+    }
+
+    if (const auto pool = m_timestamp_pool.get(); pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(p_command_buffer,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool,
+                            p_slot * 2 + 1);
+    }
+
+    m_written[p_slot] = true;
+}
+
+auto pipeline_statistics_t::collect(std::uint32_t p_slot,
+                                    std::uint64_t p_pixel_count) -> void
+{
+    if (!m_written[p_slot])
+    {
+        return;
+    }
+    m_written[p_slot] = false;
+
+    if (m_statistics_pool.get() != VK_NULL_HANDLE)
+    {
+        auto counts = std::array<std::uint64_t, STATISTIC_COUNT>{};
+        const auto result = vkGetQueryPoolResults(
+            m_device, m_statistics_pool.get(), p_slot, 1, sizeof(counts),
+            counts.data(), sizeof(counts), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            const auto [vertex_invocations, primitives, fragment_invocations] =
+                counts;
+            m_vertex_invocations.add(static_cast<double>(vertex_invocations));
+            m_primitives.add(static_cast<double>(primitives));
+            m_fragment_invocations.add(
+                static_cast<double>(fragment_invocations));
+            m_fragments_per_pixel.add(
+                static_cast<double>(fragment_invocations) /
+                static_cast<double>(
+                    (std::max)(p_pixel_count, std::uint64_t{1})));
+        }
+    }
+
+    if (m_timestamp_pool.get() != VK_NULL_HANDLE)
+    {
+        auto timestamps = std::array<std::uint64_t, 2>{};
+        const auto result = vkGetQueryPoolResults(
+            m_device, m_timestamp_pool.get(), p_slot * 2, 2,
+            sizeof(timestamps), timestamps.data(), sizeof(std::uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS && timestamps[1] >= timestamps[0])
+        {
+            const auto ticks = timestamps[1] - timestamps[0];
+            m_gpu_times.add(static_cast<double>(ticks) * m_timestamp_period *
+                            1e-6);
+        }
+    }
+}
+
+auto pipeline_statistics_t::print_statistics() const -> void
+{
+    if (m_fragment_invocations.count > 0)
+    {
+        fmt::print("[INFO]: Per frame and window on average, {:.0f} vertex "
+                   "shader invocations, {:.0f} primitives rasterized and "
+                   "{:.0f} fragment shader invocations, shading each pixel "
+                   "{:.2f} times.\n",
+                   m_vertex_invocations.mean, m_primitives.mean,
+                   m_fragment_invocations.mean, m_fragments_per_pixel.mean);
+    }
+
+    if (m_gpu_times.count > 0)
+    {
+        fmt::print("[INFO]: A window's frame took {:.3f} ms on the GPU on "
+                   "average, {:.3f} to {:.3f} ms.\n",
+                   m_gpu_times.mean, m_gpu_times.min, m_gpu_times.max);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef INCLUDED_PIPELINE_STATISTICS_HPP
+#define INCLUDED_PIPELINE_STATISTICS_HPP
+
+#include "running_statistics.hpp"
+#include "vulkan_handle.hpp"
+
+// Measures how much work the GPU does to draw a frame, per slot (one per
+// window). A pipeline statistics query counts the vertex shader invocations,
+// the primitives that reach the rasterizer and the fragment shader
+// invocations, and a pair of timestamps gives the GPU time the commands took.
+//
+// Fragment invocations divided by the number of pixels is how many times each
+// pixel was shaded, which is what the depth test and front-to-back ordering
+// bring down in scenes with a lot of overdraw.
+//
+// The queries are read back after the fence of the frame that wrote them has
+// been waited on, so reading never stalls. Either half is left out if the
+// device can't do it (pipelineStatisticsQuery, or timestamps on the graphics
+// queue), and everything is a no-op if it can do neither.
+class pipeline_statistics_t
+{
+  public:
+    pipeline_statistics_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                          std::uint32_t p_graphics_family,
+                          std::uint32_t p_slot_count);
+
+    pipeline_statistics_t(const pipeline_statistics_t&) = delete;
+    auto operator=(const pipeline_statistics_t&)
+        -> pipeline_statistics_t& = delete;
+
+    // Around everything recorded for p_slot in a frame. Both have to be
+    // recorded outside of a render pass, into the same command buffer.
+    auto record_begin(VkCommandBuffer p_command_buffer, std::uint32_t p_slot)
+        -> void;
+    auto record_end(VkCommandBuffer p_command_buffer, std::uint32_t p_slot)
+        -> void;
+
+    // Reads back what p_slot counted in the last frame, which has to have
+    // completed. p_pixel_count is the size of the slot's render target.
+    auto collect(std::uint32_t p_slot, std::uint64_t p_pixel_count) -> void;
+
+    auto print_statistics() const -> void;
+
+  private:
+    // Vertex shader invocations, clipping primitives and fragment shader
+    // invocations, in the order the query writes them.
+    static constexpr auto STATISTIC_COUNT = std::uint32_t{3};
+
+    VkDevice m_device;
+
+    unique_query_pool_t m_statistics_pool;
+    unique_query_pool_t m_timestamp_pool;
+    double m_timestamp_period;
+
+    // Whether each slot's queries were recorded since they were last read.
+    std::vector<bool> m_written;
+
+    running_statistics_t m_vertex_invocations;
+    running_statistics_t m_primitives;
+    running_statistics_t m_fragment_invocations;
+    running_statistics_t m_fragments_per_pixel;
+
+    // In milliseconds.
+    running_statistics_t m_gpu_times;
+};
+
+#endif
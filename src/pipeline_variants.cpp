@@ -0,0 +1,197 @@
+#include "pipeline_variants.hpp"
+
+auto get_all_pipeline_variants() -> std::vector<pipeline_variant_key_t>
+{
+    constexpr auto CULL_MODES = std::array<VkCullModeFlags, 2>{
+        VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_NONE};
+
+    auto keys = std::vector<pipeline_variant_key_t>();
+    for (auto color_mode = static_cast<std::uint32_t>(0);
+         color_mode < COLOR_MODE_COUNT; color_mode++)
+    {
+        for (const auto cull_mode : CULL_MODES)
+        {
+            keys.push_back(pipeline_variant_key_t{
+                .color_mode = static_cast<color_mode_t>(color_mode),
+                .cull_mode = cull_mode});
+        }
+    }
+
+    return keys;
+}
+
+pipeline_variant_library_t::pipeline_variant_library_t(
+    VkDevice p_device, VkPipelineCache p_pipeline_cache,
+    thread_pool_t& p_thread_pool,
+    const std::vector<pipeline_variant_key_t>& p_keys,
+    build_function_t p_build_pipeline, compiled_function_t p_on_compiled)
+    : m_device(p_device), m_pipeline_cache(p_pipeline_cache),
+      m_thread_pool(p_thread_pool),
+      m_build_pipeline(std::move(p_build_pipeline)),
+      m_on_compiled(std::move(p_on_compiled)), m_shards(),
+      m_fallback(VK_NULL_HANDLE), m_complete(true), m_jobs_mutex(), m_jobs(),
+      m_lookup_count(0), m_fallback_count(0), m_compile_times(),
+      m_failed_count(0)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Each job writes into its own slot, so the workers don't need to
+    // synchronize with each other at all.
+    auto pipelines = std::vector<VkPipeline>(p_keys.size(), VK_NULL_HANDLE);
+    auto jobs = std::vector<std::future<void>>();
+    jobs.reserve(p_keys.size());
+
+    for (auto i = static_cast<std::size_t>(0); i < p_keys.size(); i++)
+    {
+        jobs.push_back(p_thread_pool.submit([&, i]() {
+            pipelines[i] = m_build_pipeline(p_keys[i], p_pipeline_cache);
+        }));
+    }
+
+    for (auto& job : jobs)
+    {
+        job.wait();
+    }
+
+    auto built_count = std::size_t{0};
+    for (auto i = static_cast<std::size_t>(0); i < p_keys.size(); i++)
+    {
+        if (pipelines[i] == VK_NULL_HANDLE)
+        {
+            m_complete = false;
+            continue;
+        }
+
+        auto& shard = get_shard(pipeline_variant_key_hash_t()(p_keys[i]));
+        shard.pipelines.emplace(p_keys[i],
+                                unique_pipeline_t(pipelines[i], {p_device}));
+        built_count++;
+    }
+
+    if (!p_keys.empty())
+    {
+        m_fallback = pipelines[0];
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time);
+    fmt::print("[INFO]: Built {} of {} pipeline variants on {} threads in "
+               "{:.1f} ms.\n",
+               built_count, p_keys.size(), p_thread_pool.get_thread_count(),
+               elapsed.count());
+}
+
+pipeline_variant_library_t::~pipeline_variant_library_t()
+{
+    // The jobs take the lock themselves once they're done, so it can't be
+    // held while waiting for them.
+    auto jobs = std::vector<std::future<void>>();
+    {
+        const auto lock = std::scoped_lock(m_jobs_mutex);
+        jobs = std::move(m_jobs);
+    }
+
+    for (auto& job : jobs)
+    {
+        job.wait();
+    }
+}
+
+auto pipeline_variant_library_t::get(const pipeline_variant_key_t& p_key) const
+    -> VkPipeline
+{
+    m_lookup_count.fetch_add(1, std::memory_order_relaxed);
+
+    const auto hash = pipeline_variant_key_hash_t()(p_key);
+    auto& shard = get_shard(hash);
+
+    // The common case, a variant that's already been compiled, only needs
+    // the shared lock.
+    {
+        const auto lock = std::shared_lock(shard.mutex);
+        const auto pipeline = shard.pipelines.find(p_key);
+        if (pipeline != shard.pipelines.end())
+        {
+            if (pipeline->second)
+            {
+                return pipeline->second.get();
+            }
+
+            m_fallback_count.fetch_add(1, std::memory_order_relaxed);
+            return m_fallback;
+        }
+    }
+
+    // Another thread may have inserted the variant between the two locks, in
+    // which case it's already compiling, or even done.
+    auto inserted = false;
+    {
+        const auto lock = std::unique_lock(shard.mutex);
+        const auto [pipeline, emplaced] =
+            shard.pipelines.try_emplace(p_key, unique_pipeline_t());
+        if (pipeline->second)
+        {
+            return pipeline->second.get();
+        }
+
+        inserted = emplaced;
+    }
+
+    if (inserted)
+    {
+        const auto lock = std::scoped_lock(m_jobs_mutex);
+        m_jobs.push_back(m_thread_pool.submit(
+            [this, p_key, hash]() { compile(p_key, hash); }));
+    }
+
+    m_fallback_count.fetch_add(1, std::memory_order_relaxed);
+    return m_fallback;
+}
+
+auto pipeline_variant_library_t::compile(const pipeline_variant_key_t& p_key,
+                                         std::size_t p_hash) const -> void
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto pipeline = m_build_pipeline(p_key, m_pipeline_cache);
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time);
+
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        auto& shard = get_shard(p_hash);
+        const auto lock = std::unique_lock(shard.mutex);
+        shard.pipelines.at(p_key) = unique_pipeline_t(pipeline, {m_device});
+    }
+
+    {
+        const auto lock = std::scoped_lock(m_jobs_mutex);
+        m_compile_times.add(elapsed.count());
+        m_failed_count += pipeline == VK_NULL_HANDLE ? 1 : 0;
+    }
+
+    if (pipeline == VK_NULL_HANDLE)
+    {
+        fmt::print(fmt::fg(fmt::color::yellow),
+                   "[WARNING]: Failed to compile a pipeline variant. It will "
+                   "keep using the fallback.\n");
+    }
+    else if (m_on_compiled)
+    {
+        m_on_compiled();
+    }
+}
+
+auto pipeline_variant_library_t::print_statistics() const -> void
+{
+    const auto lock = std::scoped_lock(m_jobs_mutex);
+    if (m_compile_times.count == 0)
+    {
+        return;
+    }
+
+    fmt::print("[INFO]: Compiled {} pipeline variants on demand ({} failed), "
+               "taking {:.1f} ms on average. {} of {} lookups used the "
+               "fallback meanwhile.\n",
+               m_compile_times.count, m_failed_count, m_compile_times.mean,
+               m_fallback_count.load(), m_lookup_count.load());
+}
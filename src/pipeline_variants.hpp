@@ -0,0 +1,161 @@
+#ifndef INCLUDED_PIPELINE_VARIANTS_HPP
+#define INCLUDED_PIPELINE_VARIANTS_HPP
+
+#include "running_statistics.hpp"
+#include "thread_pool.hpp"
+#include "vulkan_handle.hpp"
+
+// Selected in shader.frag through specialization constant 0, so that each mode
+// gets its own compiled shader instead of a runtime branch.
+enum class color_mode_t : std::uint32_t
+{
+    vertex_color = 0,
+    grayscale = 1,
+    inverted = 2,
+};
+
+constexpr auto COLOR_MODE_COUNT = static_cast<std::uint32_t>(3);
+
+enum class blend_mode_t : std::uint32_t
+{
+    opaque = 0,
+    // Adds the fragment's color to what's already in the target.
+    additive = 1,
+};
+
+// Everything that a pipeline differs in. It's small and trivially copyable, so
+// that looking one up every draw costs a hash and a compare. Fields left out
+// of a designated initializer default to zero, the state everything had before
+// they were added.
+struct pipeline_variant_key_t
+{
+    color_mode_t color_mode;
+    VkCullModeFlags cull_mode;
+    blend_mode_t blend_mode;
+
+    auto operator==(const pipeline_variant_key_t&) const -> bool = default;
+};
+
+struct pipeline_variant_key_hash_t
+{
+    auto operator()(const pipeline_variant_key_t& p_key) const -> std::size_t
+    {
+        // Each field fits in a byte, so they're packed into one integer, and
+        // then mixed with the splitmix64 finalizer so that every bit of the
+        // hash depends on all of them. Both the map's buckets and the
+        // library's shards are picked from it.
+        auto bits = static_cast<std::uint64_t>(p_key.color_mode) |
+                    (static_cast<std::uint64_t>(p_key.cull_mode) << 8) |
+                    (static_cast<std::uint64_t>(p_key.blend_mode) << 16);
+        bits ^= bits >> 30;
+        bits *= 0xbf58476d1ce4e5b9;
+        bits ^= bits >> 27;
+        bits *= 0x94d049bb133111eb;
+        bits ^= bits >> 31;
+        return static_cast<std::size_t>(bits);
+    }
+};
+
+// Every permutation that the program switches to often enough to be worth
+// compiling before the first frame.
+auto get_all_pipeline_variants() -> std::vector<pipeline_variant_key_t>;
+
+// A concurrent cache of pipelines, keyed by variant. The variants that it's
+// created with are compiled up front in parallel. Anything else is compiled on
+// the thread pool the first time it's asked for, and until it's ready, lookups
+// return the fallback pipeline instead, so that a new state never stalls a
+// frame on the driver.
+//
+// The map is split into shards, each behind its own reader-writer lock, so
+// lookups from several threads only contend when one of them is inserting
+// into the same shard.
+class pipeline_variant_library_t
+{
+  public:
+    // Called on the worker threads, for the initial variants and for every
+    // miss later on, so everything that it captures has to outlive the
+    // library. Should return VK_NULL_HANDLE if the variant couldn't be built.
+    using build_function_t = std::function<VkPipeline(
+        const pipeline_variant_key_t&, VkPipelineCache)>;
+
+    // Called on a worker thread whenever a pipeline that was missing becomes
+    // available.
+    using compiled_function_t = std::function<void()>;
+
+    // Blocks until every one of p_keys has been built. The first of them is
+    // the fallback. The pipeline cache is shared by all of the workers, and
+    // must outlive the library, as must the thread pool.
+    pipeline_variant_library_t(VkDevice p_device,
+                               VkPipelineCache p_pipeline_cache,
+                               thread_pool_t& p_thread_pool,
+                               const std::vector<pipeline_variant_key_t>& p_keys,
+                               build_function_t p_build_pipeline,
+                               compiled_function_t p_on_compiled = nullptr);
+
+    // Waits for any compiles still in flight.
+    ~pipeline_variant_library_t();
+
+    pipeline_variant_library_t(const pipeline_variant_library_t&) = delete;
+    auto operator=(const pipeline_variant_library_t&)
+        -> pipeline_variant_library_t& = delete;
+
+    // True if every initial variant was built successfully.
+    auto is_complete() const -> bool { return m_complete; }
+
+    // Returns the fallback pipeline for a variant that isn't ready yet, and
+    // queues its compile if it's the first time it's been asked for. A
+    // variant that failed to compile keeps getting the fallback. Safe to call
+    // from any thread.
+    auto get(const pipeline_variant_key_t& p_key) const -> VkPipeline;
+
+    auto print_statistics() const -> void;
+
+  private:
+    static constexpr auto SHARD_BITS = 4;
+    static constexpr auto SHARD_COUNT = std::size_t{1} << SHARD_BITS;
+
+    struct shard_t
+    {
+        std::shared_mutex mutex;
+        // A null pipeline is a variant that's still compiling, or that
+        // failed to.
+        std::unordered_map<pipeline_variant_key_t, unique_pipeline_t,
+                           pipeline_variant_key_hash_t>
+            pipelines;
+    };
+
+    auto get_shard(std::size_t p_hash) const -> shard_t&
+    {
+        // The low bits pick the bucket within the shard's map, so the shard
+        // comes from the high ones.
+        constexpr auto SHIFT =
+            std::numeric_limits<std::size_t>::digits - SHARD_BITS;
+        return m_shards[p_hash >> SHIFT];
+    }
+
+    auto compile(const pipeline_variant_key_t& p_key, std::size_t p_hash) const
+        -> void;
+
+    VkDevice m_device;
+    VkPipelineCache m_pipeline_cache;
+    thread_pool_t& m_thread_pool;
+    build_function_t m_build_pipeline;
+    compiled_function_t m_on_compiled;
+
+    mutable std::array<shard_t, SHARD_COUNT> m_shards;
+    VkPipeline m_fallback;
+    bool m_complete;
+
+    mutable std::mutex m_jobs_mutex;
+    mutable std::vector<std::future<void>> m_jobs;
+
+    mutable std::atomic<std::uint64_t> m_lookup_count;
+    mutable std::atomic<std::uint64_t> m_fallback_count;
+
+    // In milliseconds, per variant compiled after a miss. Guarded by
+    // m_jobs_mutex, along with the failure count.
+    mutable running_statistics_t m_compile_times;
+    mutable std::uint64_t m_failed_count;
+};
+
+#endif
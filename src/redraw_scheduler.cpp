@@ -0,0 +1,103 @@
+#include "redraw_scheduler.hpp"
+
+namespace
+{
+
+auto any_window_should_close(const std::vector<GLFWwindow*>& p_windows) -> bool
+{
+    return std::any_of(p_windows.begin(), p_windows.end(),
+                       [](GLFWwindow* p_window) {
+                           return glfwWindowShouldClose(p_window) != 0;
+                       });
+}
+
+} // namespace
+
+redraw_scheduler_t::redraw_scheduler_t(
+    bool p_on_demand, std::optional<duration_t> p_animation_interval)
+    : m_on_demand(p_on_demand), m_animation_interval(p_animation_interval),
+      m_next_animation_tick(std::chrono::steady_clock::now()), m_dirty(true),
+      m_requests(), m_redraw_count(0),
+      m_start_time(std::chrono::steady_clock::now())
+{
+}
+
+auto redraw_scheduler_t::request_redraw(redraw_reason_t p_reason) -> void
+{
+    m_requests[static_cast<std::size_t>(p_reason)].fetch_add(
+        1, std::memory_order_relaxed);
+
+    // Only the first request after a redraw needs to wake the main thread.
+    if (!m_dirty.exchange(true, std::memory_order_acq_rel))
+    {
+        glfwPostEmptyEvent();
+    }
+}
+
+auto redraw_scheduler_t::wait_for_redraw(
+    const std::vector<GLFWwindow*>& p_windows) -> bool
+{
+    if (!m_on_demand)
+    {
+        m_redraw_count++;
+        return !any_window_should_close(p_windows);
+    }
+
+    while (!m_dirty.exchange(false, std::memory_order_acq_rel))
+    {
+        if (any_window_should_close(p_windows))
+        {
+            return false;
+        }
+
+        if (!m_animation_interval.has_value())
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= m_next_animation_tick)
+        {
+            // Skips any ticks that were missed rather than rendering them
+            // back to back.
+            m_next_animation_tick =
+                (std::max)(m_next_animation_tick + *m_animation_interval,
+                           now);
+            request_redraw(redraw_reason_t::animation);
+            continue;
+        }
+
+        glfwWaitEventsTimeout(
+            std::chrono::duration<double>(m_next_animation_tick - now)
+                .count());
+    }
+
+    m_redraw_count++;
+    return !any_window_should_close(p_windows);
+}
+
+auto redraw_scheduler_t::print_statistics() const -> void
+{
+    if (!m_on_demand)
+    {
+        return;
+    }
+
+    const auto elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - m_start_time)
+                             .count();
+
+    const auto get_request_count = [this](redraw_reason_t p_reason) {
+        return m_requests[static_cast<std::size_t>(p_reason)].load();
+    };
+
+    fmt::print("[INFO]: Rendered {} frames on demand in {:.1f} s. Redraws "
+               "were requested {} times by input, {} by the window system, "
+               "{} by other threads and {} by the animation timer.\n",
+               m_redraw_count, elapsed,
+               get_request_count(redraw_reason_t::input),
+               get_request_count(redraw_reason_t::window),
+               get_request_count(redraw_reason_t::background),
+               get_request_count(redraw_reason_t::animation));
+}
@@ -0,0 +1,59 @@
+#ifndef INCLUDED_REDRAW_SCHEDULER_HPP
+#define INCLUDED_REDRAW_SCHEDULER_HPP
+
+// Why a redraw was requested. Only used for the statistics.
+enum class redraw_reason_t
+{
+    input,
+    window,
+    background,
+    animation,
+};
+
+constexpr auto REDRAW_REASON_COUNT = std::size_t{4};
+
+// Decides whether the main loop renders continuously or only when something
+// changed.
+//
+// In on-demand mode, the main thread blocks in glfwWaitEvents until a redraw
+// is requested, so an idle window uses no CPU or GPU time at all. Requests
+// can come from GLFW callbacks on the main thread, from any other thread
+// (which wake the main thread with glfwPostEmptyEvent), or from an optional
+// animation timer, in which case glfwWaitEventsTimeout sleeps until the next
+// tick.
+class redraw_scheduler_t
+{
+  public:
+    using duration_t = std::chrono::steady_clock::duration;
+
+    // p_animation_interval only matters in on-demand mode. Without it, the
+    // scene only changes when something requests a redraw.
+    redraw_scheduler_t(bool p_on_demand,
+                       std::optional<duration_t> p_animation_interval);
+
+    redraw_scheduler_t(const redraw_scheduler_t&) = delete;
+    auto operator=(const redraw_scheduler_t&) -> redraw_scheduler_t& = delete;
+
+    // Safe to call from any thread.
+    auto request_redraw(redraw_reason_t p_reason) -> void;
+
+    // Called by the main thread at the top of the loop. Processes events
+    // until a redraw is due, and returns false if any of p_windows was closed
+    // in the meantime. Returns straight away when rendering continuously.
+    auto wait_for_redraw(const std::vector<GLFWwindow*>& p_windows) -> bool;
+
+    auto print_statistics() const -> void;
+
+  private:
+    bool m_on_demand;
+    std::optional<duration_t> m_animation_interval;
+    std::chrono::steady_clock::time_point m_next_animation_tick;
+
+    std::atomic<bool> m_dirty;
+
+    std::array<std::atomic<std::uint64_t>, REDRAW_REASON_COUNT> m_requests;
+    std::uint64_t m_redraw_count;
+    std::chrono::steady_clock::time_point m_start_time;
+};
+
+#endif
@@ -0,0 +1,789 @@
+#include "render_graph.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+struct access_info_t
+{
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags image_usage;
+    bool is_read;
+    bool is_write;
+};
+
+auto get_access_info(render_graph_access_t p_access) -> access_info_t
+{
+    switch (p_access)
+    {
+    case render_graph_access_t::color_attachment_write:
+        // Blending and loads read the attachment as well.
+        return access_info_t{
+            .stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            .is_read = true,
+            .is_write = true};
+    case render_graph_access_t::depth_attachment_write:
+        return access_info_t{
+            .stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            .is_read = true,
+            .is_write = true};
+    case render_graph_access_t::fragment_sampled_read:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             .access = VK_ACCESS_SHADER_READ_BIT,
+                             .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             .image_usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                             .is_read = true,
+                             .is_write = false};
+    case render_graph_access_t::compute_storage_read:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             .access = VK_ACCESS_SHADER_READ_BIT,
+                             .layout = VK_IMAGE_LAYOUT_GENERAL,
+                             .image_usage = VK_IMAGE_USAGE_STORAGE_BIT,
+                             .is_read = true,
+                             .is_write = false};
+    case render_graph_access_t::compute_storage_write:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             .access = VK_ACCESS_SHADER_WRITE_BIT,
+                             .layout = VK_IMAGE_LAYOUT_GENERAL,
+                             .image_usage = VK_IMAGE_USAGE_STORAGE_BIT,
+                             .is_read = false,
+                             .is_write = true};
+    case render_graph_access_t::compute_storage_read_write:
+        return access_info_t{
+            .stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .layout = VK_IMAGE_LAYOUT_GENERAL,
+            .image_usage = VK_IMAGE_USAGE_STORAGE_BIT,
+            .is_read = true,
+            .is_write = true};
+    case render_graph_access_t::vertex_buffer_read:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                             .access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                             .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                             .image_usage = 0,
+                             .is_read = true,
+                             .is_write = false};
+    case render_graph_access_t::indirect_buffer_read:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             .access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                             .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                             .image_usage = 0,
+                             .is_read = true,
+                             .is_write = false};
+    case render_graph_access_t::transfer_read:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             .access = VK_ACCESS_TRANSFER_READ_BIT,
+                             .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                             .image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                             .is_read = true,
+                             .is_write = false};
+    case render_graph_access_t::transfer_write:
+        return access_info_t{.stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             .access = VK_ACCESS_TRANSFER_WRITE_BIT,
+                             .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             .image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                             .is_read = false,
+                             .is_write = true};
+    }
+
+    return access_info_t{};
+}
+
+// What the barrier derivation knows about a resource at a point in the
+// graph.
+struct tracked_state_t
+{
+    // The stages and accesses of the last write (or layout transition), and
+    // the reads that have happened since.
+    VkPipelineStageFlags write_stages;
+    VkAccessFlags write_access;
+    VkPipelineStageFlags read_stages;
+
+    // What the last write has already been made visible to.
+    VkPipelineStageFlags visible_stages;
+    VkAccessFlags visible_access;
+
+    VkImageLayout layout;
+};
+
+} // namespace
+
+render_graph_t::render_graph_t(VkPhysicalDevice p_physical_device,
+                               VkDevice p_device,
+                               deletion_queue_t& p_deletion_queue)
+    : m_physical_device(p_physical_device), m_device(p_device),
+      m_deletion_queue(p_deletion_queue), m_last_frame_number(0)
+{
+}
+
+auto render_graph_t::import_image(
+    std::string_view p_name, VkImage p_image, VkImageView p_image_view,
+    VkImageAspectFlags p_aspect, const render_graph_state_t& p_initial_state,
+    std::optional<render_graph_state_t> p_final_state)
+    -> render_graph_resource_t
+{
+    m_resources.push_back(resource_t{
+        .name = std::string(p_name),
+        .kind = resource_kind_t::imported_image,
+        .image_info = render_graph_image_info_t{.format = VK_FORMAT_UNDEFINED,
+                                                .extent = {},
+                                                .aspect = p_aspect,
+                                                .usage = 0},
+        .initial_state = p_initial_state,
+        .final_state = p_final_state,
+        .image = p_image,
+        .image_view = p_image_view,
+        .buffer = VK_NULL_HANDLE});
+
+    return render_graph_resource_t{
+        static_cast<std::uint32_t>(m_resources.size() - 1)};
+}
+
+auto render_graph_t::import_buffer(std::string_view p_name, VkBuffer p_buffer)
+    -> render_graph_resource_t
+{
+    m_resources.push_back(
+        resource_t{.name = std::string(p_name),
+                   .kind = resource_kind_t::imported_buffer,
+                   .image_info = {},
+                   .initial_state = std::nullopt,
+                   .final_state = std::nullopt,
+                   .image = VK_NULL_HANDLE,
+                   .image_view = VK_NULL_HANDLE,
+                   .buffer = p_buffer});
+
+    return render_graph_resource_t{
+        static_cast<std::uint32_t>(m_resources.size() - 1)};
+}
+
+auto render_graph_t::create_image(std::string_view p_name,
+                                  const render_graph_image_info_t& p_info)
+    -> render_graph_resource_t
+{
+    m_resources.push_back(
+        resource_t{.name = std::string(p_name),
+                   .kind = resource_kind_t::transient_image,
+                   .image_info = p_info,
+                   .initial_state = std::nullopt,
+                   .final_state = std::nullopt,
+                   .image = VK_NULL_HANDLE,
+                   .image_view = VK_NULL_HANDLE,
+                   .buffer = VK_NULL_HANDLE});
+
+    return render_graph_resource_t{
+        static_cast<std::uint32_t>(m_resources.size() - 1)};
+}
+
+auto render_graph_t::add_pass(std::string_view p_name,
+                              std::vector<render_graph_use_t> p_uses,
+                              record_function_t p_record,
+                              bool p_has_side_effects) -> void
+{
+    m_passes.push_back(pass_t{.name = std::string(p_name),
+                              .uses = std::move(p_uses),
+                              .record = std::move(p_record),
+                              .has_side_effects = p_has_side_effects});
+}
+
+auto render_graph_t::execute(VkCommandBuffer p_command_buffer,
+                             std::uint64_t p_frame_number) -> void
+{
+    auto key = get_key();
+    if (m_compiled == nullptr || key != m_compiled_key)
+    {
+        // The previous frame may still be using the old transient images.
+        if (m_compiled != nullptr)
+        {
+            m_deletion_queue.retire(m_last_frame_number, std::move(m_compiled));
+        }
+
+        m_compiled = compile();
+        m_compiled_key = std::move(key);
+    }
+
+    record(p_command_buffer);
+
+    m_last_frame_number = p_frame_number;
+    m_resources.clear();
+    m_passes.clear();
+}
+
+auto render_graph_t::get_image(render_graph_resource_t p_resource) const
+    -> VkImage
+{
+    const auto& resource = m_resources[p_resource.index];
+    if (resource.kind == resource_kind_t::transient_image)
+    {
+        return m_compiled->images[p_resource.index].get();
+    }
+
+    return resource.image;
+}
+
+auto render_graph_t::get_image_view(render_graph_resource_t p_resource) const
+    -> VkImageView
+{
+    const auto& resource = m_resources[p_resource.index];
+    if (resource.kind == resource_kind_t::transient_image)
+    {
+        return m_compiled->image_views[p_resource.index].get();
+    }
+
+    return resource.image_view;
+}
+
+auto render_graph_t::get_buffer(render_graph_resource_t p_resource) const
+    -> VkBuffer
+{
+    return m_resources[p_resource.index].buffer;
+}
+
+// Everything that affects compilation, which excludes the imported handles
+// and the record functions.
+auto render_graph_t::get_key() const -> std::string
+{
+    auto key = std::string();
+
+    const auto append_state =
+        [&key](const std::optional<render_graph_state_t>& p_state) {
+            if (p_state.has_value())
+            {
+                key += fmt::format("{},{},{};", p_state->stage, p_state->access,
+                                   static_cast<int>(p_state->layout));
+            }
+            else
+            {
+                key += "-;";
+            }
+        };
+
+    for (const auto& resource : m_resources)
+    {
+        const auto& info = resource.image_info;
+        key += fmt::format("r:{}:{}:{}:{}x{}:{}:{}:", resource.name,
+                           static_cast<int>(resource.kind),
+                           static_cast<int>(info.format), info.extent.width,
+                           info.extent.height, info.aspect, info.usage);
+        append_state(resource.initial_state);
+        append_state(resource.final_state);
+    }
+
+    for (const auto& pass : m_passes)
+    {
+        key += fmt::format("p:{}:{}:", pass.name, pass.has_side_effects);
+        for (const auto& use : pass.uses)
+        {
+            key += fmt::format("{}/{},", use.resource.index,
+                               static_cast<int>(use.access));
+        }
+    }
+
+    return key;
+}
+
+// Walks the passes backwards from the outputs. A pass stays if it has side
+// effects or writes something a later live pass (or an output) needs, and
+// then everything it reads is needed too.
+auto render_graph_t::find_live_passes() const -> std::vector<bool>
+{
+    auto needed = std::vector<bool>(m_resources.size(), false);
+    for (auto i = std::size_t{0}; i < m_resources.size(); i++)
+    {
+        needed[i] = m_resources[i].final_state.has_value();
+    }
+
+    auto live = std::vector<bool>(m_passes.size(), false);
+    for (auto i = m_passes.size(); i-- > 0;)
+    {
+        const auto& pass = m_passes[i];
+
+        live[i] = pass.has_side_effects ||
+                  std::any_of(pass.uses.begin(), pass.uses.end(),
+                              [&needed](const render_graph_use_t& p_use) {
+                                  return get_access_info(p_use.access)
+                                             .is_write &&
+                                         needed[p_use.resource.index];
+                              });
+
+        if (!live[i])
+        {
+            continue;
+        }
+
+        for (const auto& use : pass.uses)
+        {
+            if (get_access_info(use.access).is_read)
+            {
+                needed[use.resource.index] = true;
+            }
+        }
+    }
+
+    return live;
+}
+
+// Creates the transient images used by live passes and binds them to memory.
+// Images are handed out to memory blocks greedily in order of first use; an
+// image can reuse a block once every image already in it is dead. Returns
+// the block index of each resource.
+auto render_graph_t::allocate_transient_images(
+    compiled_t& p_compiled, const std::vector<bool>& p_live_passes) const
+    -> std::vector<std::optional<std::uint32_t>>
+{
+    struct lifetime_t
+    {
+        std::uint32_t first_pass;
+        std::uint32_t last_pass;
+        VkImageUsageFlags usage;
+    };
+
+    auto lifetimes = std::vector<std::optional<lifetime_t>>(m_resources.size());
+    for (auto i = std::uint32_t{0}; i < m_passes.size(); i++)
+    {
+        if (!p_live_passes[i])
+        {
+            continue;
+        }
+
+        for (const auto& use : m_passes[i].uses)
+        {
+            auto& lifetime = lifetimes[use.resource.index];
+            const auto usage = get_access_info(use.access).image_usage;
+            if (lifetime.has_value())
+            {
+                lifetime->last_pass = i;
+                lifetime->usage |= usage;
+            }
+            else
+            {
+                lifetime = lifetime_t{
+                    .first_pass = i, .last_pass = i, .usage = usage};
+            }
+        }
+    }
+
+    struct block_t
+    {
+        std::uint32_t memory_type_bits;
+        VkDeviceSize size;
+        std::uint32_t last_pass;
+    };
+
+    auto blocks = std::vector<block_t>();
+    auto block_of =
+        std::vector<std::optional<std::uint32_t>>(m_resources.size());
+
+    // Resources are declared before their first use, and lifetimes only
+    // include live passes, so walking them in declaration order of first use
+    // means sorting by first_pass.
+    auto order = std::vector<std::uint32_t>();
+    for (auto i = std::uint32_t{0}; i < m_resources.size(); i++)
+    {
+        if (m_resources[i].kind == resource_kind_t::transient_image &&
+            lifetimes[i].has_value())
+        {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&lifetimes](std::uint32_t p_a, std::uint32_t p_b) {
+                         return lifetimes[p_a]->first_pass <
+                                lifetimes[p_b]->first_pass;
+                     });
+
+    for (const auto index : order)
+    {
+        const auto& resource = m_resources[index];
+        const auto& lifetime = *lifetimes[index];
+
+        const auto create_info = VkImageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = resource.image_info.format,
+            .extent = VkExtent3D{.width = resource.image_info.extent.width,
+                                 .height = resource.image_info.extent.height,
+                                 .depth = 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = resource.image_info.usage | lifetime.usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+        auto image = static_cast<VkImage>(VK_NULL_HANDLE);
+        const auto result =
+            vkCreateImage(m_device, &create_info, nullptr, &image);
+        if (result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create the transient image "
+                       "{}. Vulkan error {}.\n",
+                       resource.name, result);
+            std::exit(EXIT_FAILURE);
+        }
+        p_compiled.images[index] = unique_image_t(image, {m_device});
+
+        auto requirements = VkMemoryRequirements{};
+        vkGetImageMemoryRequirements(m_device, image, &requirements);
+
+        // Binding at offset 0 satisfies any alignment, so only the size and
+        // memory types matter.
+        const auto block = std::find_if(
+            blocks.begin(), blocks.end(),
+            [&lifetime, &requirements](const block_t& p_block) {
+                return p_block.last_pass < lifetime.first_pass &&
+                       (p_block.memory_type_bits &
+                        requirements.memoryTypeBits) != 0;
+            });
+
+        if (block != blocks.end())
+        {
+            block->memory_type_bits &= requirements.memoryTypeBits;
+            block->size = (std::max)(block->size, requirements.size);
+            block->last_pass = lifetime.last_pass;
+            block_of[index] =
+                static_cast<std::uint32_t>(block - blocks.begin());
+        }
+        else
+        {
+            blocks.push_back(
+                block_t{.memory_type_bits = requirements.memoryTypeBits,
+                        .size = requirements.size,
+                        .last_pass = lifetime.last_pass});
+            block_of[index] = static_cast<std::uint32_t>(blocks.size() - 1);
+        }
+    }
+
+    for (const auto& block : blocks)
+    {
+        const auto memory_type =
+            find_memory_type(m_physical_device, block.memory_type_bits,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!memory_type.has_value())
+        {
+            fmt::print("[FATAL ERROR]: Failed to find a memory type for the "
+                       "render graph's transient images.\n");
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto allocate_info = VkMemoryAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = block.size,
+            .memoryTypeIndex = *memory_type};
+
+        auto memory = static_cast<VkDeviceMemory>(VK_NULL_HANDLE);
+        const auto result =
+            vkAllocateMemory(m_device, &allocate_info, nullptr, &memory);
+        if (result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to allocate memory for the "
+                       "render graph's transient images. Vulkan error {}.\n",
+                       result);
+            std::exit(EXIT_FAILURE);
+        }
+
+        p_compiled.memory_blocks.emplace_back(
+            memory, device_memory_deleter_t{m_device});
+    }
+
+    for (const auto index : order)
+    {
+        const auto& resource = m_resources[index];
+        const auto image = p_compiled.images[index].get();
+
+        vkBindImageMemory(m_device, image,
+                          p_compiled.memory_blocks[*block_of[index]].get(), 0);
+
+        const auto create_info = VkImageViewCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = resource.image_info.format,
+            .components =
+                VkComponentMapping{.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+            .subresourceRange = VkImageSubresourceRange{
+                .aspectMask = resource.image_info.aspect,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1}};
+
+        auto image_view = static_cast<VkImageView>(VK_NULL_HANDLE);
+        const auto result =
+            vkCreateImageView(m_device, &create_info, nullptr, &image_view);
+        if (result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create a view of the "
+                       "transient image {}. Vulkan error {}.\n",
+                       resource.name, result);
+            std::exit(EXIT_FAILURE);
+        }
+        p_compiled.image_views[index] =
+            unique_image_view_t(image_view, {m_device});
+    }
+
+    return block_of;
+}
+
+auto render_graph_t::compile() const -> std::unique_ptr<compiled_t>
+{
+    auto compiled = std::make_unique<compiled_t>();
+    compiled->images.resize(m_resources.size());
+    compiled->image_views.resize(m_resources.size());
+
+    const auto live = find_live_passes();
+    compiled->culled_pass_count =
+        static_cast<std::uint32_t>(std::count(live.begin(), live.end(), false));
+
+    const auto block_of = allocate_transient_images(*compiled, live);
+
+    auto states = std::vector<tracked_state_t>(m_resources.size());
+    auto started = std::vector<bool>(m_resources.size(), false);
+    auto block_last_resource = std::vector<std::optional<std::uint32_t>>(
+        compiled->memory_blocks.size());
+
+    for (auto i = std::size_t{0}; i < m_resources.size(); i++)
+    {
+        const auto& initial = m_resources[i].initial_state;
+        states[i] = tracked_state_t{
+            .write_stages = initial.has_value() ? initial->stage : 0,
+            .write_access = initial.has_value() ? initial->access : 0,
+            .read_stages = 0,
+            .visible_stages = 0,
+            .visible_access = 0,
+            .layout = initial.has_value() ? initial->layout
+                                          : VK_IMAGE_LAYOUT_UNDEFINED};
+    }
+
+    // Adds the barrier needed to get p_state from where it is to p_stage,
+    // p_access and p_layout, and updates p_state to match.
+    const auto transition = [](step_t& p_step, std::uint32_t p_resource,
+                               bool p_is_image, tracked_state_t& p_state,
+                               VkPipelineStageFlags p_stage,
+                               VkAccessFlags p_access, VkImageLayout p_layout,
+                               bool p_is_write) {
+        const auto layout_change = p_is_image && p_layout != p_state.layout;
+
+        if (p_is_write || layout_change)
+        {
+            // Write after read only needs an execution dependency, but write
+            // after write and layout transitions need the old writes to be
+            // made available too.
+            const auto src_stages = p_state.write_stages | p_state.read_stages;
+            if (src_stages != 0 || layout_change)
+            {
+                p_step.src_stages |=
+                    src_stages != 0 ? src_stages
+                                    : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                p_step.dst_stages |= p_stage;
+                p_step.barriers.push_back(
+                    barrier_t{.resource = p_resource,
+                              .src_access = p_state.write_access,
+                              .dst_access = p_access,
+                              .old_layout = p_state.layout,
+                              .new_layout = p_is_image ? p_layout
+                                                       : p_state.layout});
+            }
+
+            p_state = tracked_state_t{
+                .write_stages = p_stage,
+                .write_access = p_is_write ? p_access : 0,
+                .read_stages = p_is_write ? 0 : p_stage,
+                .visible_stages = p_stage,
+                .visible_access = p_access,
+                .layout = p_is_image ? p_layout : p_state.layout};
+            return;
+        }
+
+        // Read after read needs nothing. Read after write only needs a
+        // barrier if the write hasn't been made visible to this stage and
+        // access yet.
+        if (p_state.write_stages != 0 &&
+            ((p_stage & ~p_state.visible_stages) != 0 ||
+             (p_access & ~p_state.visible_access) != 0))
+        {
+            p_step.src_stages |= p_state.write_stages;
+            p_step.dst_stages |= p_stage;
+            p_step.barriers.push_back(
+                barrier_t{.resource = p_resource,
+                          .src_access = p_state.write_access,
+                          .dst_access = p_access,
+                          .old_layout = p_state.layout,
+                          .new_layout = p_state.layout});
+
+            p_state.visible_stages |= p_stage;
+            p_state.visible_access |= p_access;
+        }
+
+        p_state.read_stages |= p_stage;
+    };
+
+    for (auto i = std::uint32_t{0}; i < m_passes.size(); i++)
+    {
+        if (!live[i])
+        {
+            continue;
+        }
+
+        auto step = step_t{
+            .pass = i, .src_stages = 0, .dst_stages = 0, .barriers = {}};
+
+        for (const auto& use : m_passes[i].uses)
+        {
+            const auto index = use.resource.index;
+            const auto is_image =
+                m_resources[index].kind != resource_kind_t::imported_buffer;
+
+            // An aliased image has to wait for whichever image used its
+            // memory before it. Its old contents are discarded either way.
+            if (!started[index] && block_of[index].has_value())
+            {
+                auto& previous = block_last_resource[*block_of[index]];
+                if (previous.has_value())
+                {
+                    const auto& previous_state = states[*previous];
+                    states[index].write_stages = previous_state.write_stages |
+                                                 previous_state.read_stages;
+                    states[index].write_access = previous_state.write_access;
+                }
+                previous = index;
+            }
+            started[index] = true;
+
+            const auto info = get_access_info(use.access);
+            transition(step, index, is_image, states[index], info.stage,
+                       info.access, info.layout, info.is_write);
+        }
+
+        compiled->steps.push_back(std::move(step));
+    }
+
+    auto final_step = step_t{
+        .pass = std::nullopt, .src_stages = 0, .dst_stages = 0, .barriers = {}};
+
+    for (auto i = std::uint32_t{0}; i < m_resources.size(); i++)
+    {
+        const auto& final_state = m_resources[i].final_state;
+        if (!final_state.has_value())
+        {
+            continue;
+        }
+
+        const auto is_image =
+            m_resources[i].kind != resource_kind_t::imported_buffer;
+
+        // Treated as a write, so that it always waits for everything before
+        // it.
+        transition(final_step, i, is_image, states[i], final_state->stage,
+                   final_state->access, final_state->layout, true);
+    }
+
+    compiled->steps.push_back(std::move(final_step));
+
+    auto barrier_count = std::size_t{0};
+    auto batch_count = std::size_t{0};
+    for (const auto& step : compiled->steps)
+    {
+        barrier_count += step.barriers.size();
+        batch_count += step.barriers.empty() ? 0 : 1;
+    }
+
+    const auto transient_count = static_cast<std::size_t>(std::count_if(
+        compiled->images.begin(), compiled->images.end(),
+        [](const unique_image_t& p_image) {
+            return static_cast<bool>(p_image);
+        }));
+
+    fmt::print("[INFO]: Compiled the render graph: {} passes ({} culled), {} "
+               "barriers in {} batches, {} transient images in {} memory "
+               "blocks.\n",
+               m_passes.size(), compiled->culled_pass_count, barrier_count,
+               batch_count, transient_count, compiled->memory_blocks.size());
+
+    return compiled;
+}
+
+auto render_graph_t::record(VkCommandBuffer p_command_buffer) const -> void
+{
+    auto image_barriers = std::vector<VkImageMemoryBarrier>();
+    auto buffer_barriers = std::vector<VkBufferMemoryBarrier>();
+
+    for (const auto& step : m_compiled->steps)
+    {
+        image_barriers.clear();
+        buffer_barriers.clear();
+
+        for (const auto& barrier : step.barriers)
+        {
+            const auto& resource = m_resources[barrier.resource];
+            if (resource.kind == resource_kind_t::imported_buffer)
+            {
+                buffer_barriers.push_back(VkBufferMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .pNext = nullptr,
+                    .srcAccessMask = barrier.src_access,
+                    .dstAccessMask = barrier.dst_access,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .buffer = resource.buffer,
+                    .offset = 0,
+                    .size = VK_WHOLE_SIZE});
+                continue;
+            }
+
+            image_barriers.push_back(VkImageMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = barrier.src_access,
+                .dstAccessMask = barrier.dst_access,
+                .oldLayout = barrier.old_layout,
+                .newLayout = barrier.new_layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = get_image(render_graph_resource_t{barrier.resource}),
+                .subresourceRange = VkImageSubresourceRange{
+                    .aspectMask = resource.image_info.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1}});
+        }
+
+        if (!step.barriers.empty())
+        {
+            vkCmdPipelineBarrier(
+                p_command_buffer, step.src_stages, step.dst_stages, 0, 0,
+                nullptr, static_cast<std::uint32_t>(buffer_barriers.size()),
+                buffer_barriers.data(),
+                static_cast<std::uint32_t>(image_barriers.size()),
+                image_barriers.data());
+        }
+
+        if (step.pass.has_value())
+        {
+            m_passes[*step.pass].record(p_command_buffer);
+        }
+    }
+}
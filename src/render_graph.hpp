@@ -0,0 +1,201 @@
+#ifndef INCLUDED_RENDER_GRAPH_HPP
+#define INCLUDED_RENDER_GRAPH_HPP
+
+#include "deletion_queue.hpp"
+#include "vulkan_handle.hpp"
+
+// How a pass uses a resource. Each one implies the pipeline stage, access mask
+// and (for images) layout, so passes never spell out barriers themselves.
+enum class render_graph_access_t
+{
+    color_attachment_write,
+    depth_attachment_write,
+    fragment_sampled_read,
+    compute_storage_read,
+    compute_storage_write,
+    compute_storage_read_write,
+    vertex_buffer_read,
+    indirect_buffer_read,
+    transfer_read,
+    transfer_write,
+};
+
+// Identifies a resource within the graph currently being declared.
+struct render_graph_resource_t
+{
+    std::uint32_t index;
+};
+
+struct render_graph_use_t
+{
+    render_graph_resource_t resource;
+    render_graph_access_t access;
+};
+
+// The state an imported resource is in before the graph runs, or has to be
+// left in afterwards.
+struct render_graph_state_t
+{
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+
+    auto operator==(const render_graph_state_t&) const -> bool = default;
+};
+
+// Describes an image that only lives for the duration of the graph. The usage
+// flags implied by its accesses are added automatically.
+struct render_graph_image_info_t
+{
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageAspectFlags aspect;
+    VkImageUsageFlags usage;
+
+    auto operator==(const render_graph_image_info_t&) const -> bool = default;
+};
+
+// A small frame graph. Every frame, the passes and the resources they use are
+// declared again, in the order they should be recorded in. execute() then:
+// - culls passes whose results are never used by an output (an imported
+//   resource with a final state) or a pass with side effects,
+// - derives the pipeline barriers and layout transitions between the passes
+//   that remain, batched into one vkCmdPipelineBarrier per pass,
+// - creates the transient images, letting images whose lifetimes don't
+//   overlap share the same memory,
+// - and records everything.
+//
+// Everything but the record functions and the imported handles is compiled
+// once and reused for as long as the declarations don't change. This assumes
+// a single frame in flight, like the rest of the program, so transient images
+// don't need to be synchronized with the previous frame's use of them.
+class render_graph_t
+{
+  public:
+    using record_function_t = std::function<void(VkCommandBuffer)>;
+
+    // Transient resources that are replaced by a recompile are retired into
+    // p_deletion_queue, which has to outlive the graph.
+    render_graph_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                   deletion_queue_t& p_deletion_queue);
+
+    render_graph_t(const render_graph_t&) = delete;
+    auto operator=(const render_graph_t&) -> render_graph_t& = delete;
+
+    // An image that the graph doesn't own, like a swap chain image. If
+    // p_final_state is set, the image is an output of the graph, and is
+    // transitioned to that state at the end.
+    auto import_image(std::string_view p_name, VkImage p_image,
+                      VkImageView p_image_view, VkImageAspectFlags p_aspect,
+                      const render_graph_state_t& p_initial_state,
+                      std::optional<render_graph_state_t> p_final_state)
+        -> render_graph_resource_t;
+
+    // A buffer that the graph doesn't own. Its previous contents are assumed
+    // to have been written by an earlier frame, which has already completed.
+    auto import_buffer(std::string_view p_name, VkBuffer p_buffer)
+        -> render_graph_resource_t;
+
+    auto create_image(std::string_view p_name,
+                      const render_graph_image_info_t& p_info)
+        -> render_graph_resource_t;
+
+    // Passes with side effects are never culled, even if nothing reads what
+    // they write. A pass may only use each resource once.
+    auto add_pass(std::string_view p_name,
+                  std::vector<render_graph_use_t> p_uses,
+                  record_function_t p_record, bool p_has_side_effects = false)
+        -> void;
+
+    // Compiles the graph if it changed since the last call, records it into
+    // p_command_buffer, and clears the declarations for the next frame.
+    // p_frame_number is the frame the command buffer belongs to.
+    auto execute(VkCommandBuffer p_command_buffer, std::uint64_t p_frame_number)
+        -> void;
+
+    // Only valid inside a record function.
+    auto get_image(render_graph_resource_t p_resource) const -> VkImage;
+    auto get_image_view(render_graph_resource_t p_resource) const
+        -> VkImageView;
+    auto get_buffer(render_graph_resource_t p_resource) const -> VkBuffer;
+
+  private:
+    enum class resource_kind_t
+    {
+        imported_image,
+        imported_buffer,
+        transient_image,
+    };
+
+    struct resource_t
+    {
+        std::string name;
+        resource_kind_t kind;
+        render_graph_image_info_t image_info;
+        std::optional<render_graph_state_t> initial_state;
+        std::optional<render_graph_state_t> final_state;
+
+        VkImage image;
+        VkImageView image_view;
+        VkBuffer buffer;
+    };
+
+    struct pass_t
+    {
+        std::string name;
+        std::vector<render_graph_use_t> uses;
+        record_function_t record;
+        bool has_side_effects;
+    };
+
+    struct barrier_t
+    {
+        std::uint32_t resource;
+        VkAccessFlags src_access;
+        VkAccessFlags dst_access;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+    };
+
+    // The barriers recorded before a pass, or after the last one.
+    struct step_t
+    {
+        std::optional<std::uint32_t> pass;
+        VkPipelineStageFlags src_stages;
+        VkPipelineStageFlags dst_stages;
+        std::vector<barrier_t> barriers;
+    };
+
+    struct compiled_t
+    {
+        std::vector<step_t> steps;
+        std::uint32_t culled_pass_count;
+
+        // Indexed by resource. Null for anything that isn't a transient
+        // image, or a transient image that no remaining pass uses.
+        std::vector<unique_image_t> images;
+        std::vector<unique_image_view_t> image_views;
+        std::vector<unique_device_memory_t> memory_blocks;
+    };
+
+    auto get_key() const -> std::string;
+    auto compile() const -> std::unique_ptr<compiled_t>;
+    auto find_live_passes() const -> std::vector<bool>;
+    auto allocate_transient_images(compiled_t& p_compiled,
+                                   const std::vector<bool>& p_live_passes) const
+        -> std::vector<std::optional<std::uint32_t>>;
+    auto record(VkCommandBuffer p_command_buffer) const -> void;
+
+    VkPhysicalDevice m_physical_device;
+    VkDevice m_device;
+    deletion_queue_t& m_deletion_queue;
+
+    std::vector<resource_t> m_resources;
+    std::vector<pass_t> m_passes;
+
+    std::string m_compiled_key;
+    std::unique_ptr<compiled_t> m_compiled;
+    std::uint64_t m_last_frame_number;
+};
+
+#endif
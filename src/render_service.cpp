@@ -0,0 +1,638 @@
+#include "render_service.hpp"
+
+#include "pipeline_variants.hpp"
+
+namespace
+{
+
+// Keeps a single job from asking for an unbounded amount of push constants.
+constexpr auto MAX_OBJECTS_PER_JOB = std::uint32_t{65536};
+
+constexpr auto DEFAULT_EXTENT = std::uint32_t{256};
+
+auto to_milliseconds(std::chrono::steady_clock::duration p_duration) -> double
+{
+    return std::chrono::duration<double, std::milli>(p_duration).count();
+}
+
+auto parse_uint(std::string_view p_value) -> std::optional<std::uint32_t>
+{
+    auto result = std::uint32_t{0};
+    const auto end = p_value.data() + p_value.size();
+    const auto [pointer, error] =
+        std::from_chars(p_value.data(), end, result);
+    if (error != std::errc() || pointer != end)
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+auto parse_float(std::string_view p_value) -> std::optional<float>
+{
+    const auto text = std::string(p_value);
+    auto end = static_cast<char*>(nullptr);
+    const auto result = std::strtof(text.c_str(), &end);
+    if (text.empty() || end != text.c_str() + text.size() ||
+        !std::isfinite(result))
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+} // namespace
+
+render_service_client_t::render_service_client_t(int p_fd)
+    : m_mutex(), m_fd(p_fd)
+{
+}
+
+render_service_client_t::~render_service_client_t()
+{
+#ifdef __linux__
+    if (m_fd != STANDARD_OUTPUT)
+    {
+        close(m_fd);
+    }
+#endif
+}
+
+auto render_service_client_t::send(std::string_view p_line) -> void
+{
+    const auto line = fmt::format("{}\n", p_line);
+
+    const auto lock = std::scoped_lock(m_mutex);
+    if (m_fd == STANDARD_OUTPUT)
+    {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fflush(stdout);
+        return;
+    }
+
+#ifdef __linux__
+    // MSG_NOSIGNAL keeps a client that hung up from killing the service with
+    // SIGPIPE.
+    auto sent = std::size_t{0};
+    while (sent < line.size())
+    {
+        const auto result = ::send(m_fd, line.data() + sent,
+                                   line.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0)
+        {
+            return;
+        }
+        sent += static_cast<std::size_t>(result);
+    }
+#endif
+}
+
+render_service_t::render_service_t(std::string_view p_endpoint,
+                                   std::uint32_t p_max_extent)
+    : m_max_extent(p_max_extent), m_mutex(), m_condition(), m_queue(),
+      m_stopped(false), m_next_job_number(0), m_queue_depths(),
+      m_batch_sizes(), m_wait_times(), m_render_times(), m_latencies(),
+      m_failed_count(0),
+#ifdef __linux__
+      m_socket_path(), m_listen_fd(-1), m_client_connections(),
+#endif
+      m_reader_thread()
+{
+    if (p_endpoint == "-")
+    {
+        fmt::print("[INFO]: The render service is reading jobs from the "
+                   "standard input.\n");
+        m_reader_thread = std::thread(&render_service_t::read_standard_input,
+                                      this);
+        return;
+    }
+
+#ifdef __linux__
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (p_endpoint.size() >= sizeof(address.sun_path))
+    {
+        fmt::print("[FATAL ERROR]: The render service socket path \"{}\" is "
+                   "too long.\n",
+                   p_endpoint);
+        std::exit(EXIT_FAILURE);
+    }
+    std::memcpy(address.sun_path, p_endpoint.data(), p_endpoint.size());
+
+    m_socket_path = std::string(p_endpoint);
+
+    // A socket left behind by a previous run would make bind() fail.
+    unlink(m_socket_path.c_str());
+
+    m_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen_fd < 0 ||
+        bind(m_listen_fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+        listen(m_listen_fd, SOMAXCONN) != 0)
+    {
+        fmt::print("[FATAL ERROR]: Failed to listen on the render service "
+                   "socket \"{}\": {}.\n",
+                   m_socket_path, std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+
+    fmt::print("[INFO]: The render service is listening on \"{}\".\n",
+               m_socket_path);
+    m_reader_thread = std::thread(&render_service_t::accept_clients, this);
+#else
+    fmt::print("[FATAL ERROR]: The render service can only read jobs from the "
+               "standard input on this platform, so the endpoint has to be "
+               "\"-\", not \"{}\".\n",
+               p_endpoint);
+    std::exit(EXIT_FAILURE);
+#endif
+}
+
+render_service_t::~render_service_t()
+{
+    stop();
+
+#ifdef __linux__
+    // Wakes the threads that are blocked in accept() or recv().
+    if (m_listen_fd >= 0)
+    {
+        shutdown(m_listen_fd, SHUT_RDWR);
+    }
+#endif
+
+    // Once the reader has stopped, no more client threads can be started.
+    if (m_reader_thread.joinable())
+    {
+        m_reader_thread.join();
+    }
+
+#ifdef __linux__
+    // A finished connection's descriptor may already have been closed, and
+    // its number reused.
+    {
+        const auto lock = std::scoped_lock(m_mutex);
+        for (const auto& connection : m_client_connections)
+        {
+            if (!connection.is_finished)
+            {
+                shutdown(connection.fd, SHUT_RDWR);
+            }
+        }
+    }
+
+    for (auto& connection : m_client_connections)
+    {
+        connection.thread.join();
+    }
+
+    if (m_listen_fd >= 0)
+    {
+        close(m_listen_fd);
+        unlink(m_socket_path.c_str());
+    }
+#endif
+}
+
+auto render_service_t::take_jobs(std::size_t p_max_count, bool p_wait)
+    -> std::vector<render_job_t>
+{
+    auto lock = std::unique_lock(m_mutex);
+    if (p_wait)
+    {
+        m_condition.wait(lock,
+                         [this]() { return !m_queue.empty() || m_stopped; });
+    }
+
+    if (m_queue.empty())
+    {
+        return {};
+    }
+
+    m_queue_depths.add(static_cast<double>(m_queue.size()));
+
+    const auto count = (std::min)(p_max_count, m_queue.size());
+    auto jobs = std::vector<render_job_t>(
+        std::make_move_iterator(m_queue.begin()),
+        std::make_move_iterator(m_queue.begin() + count));
+    m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+
+    m_batch_sizes.add(static_cast<double>(count));
+
+    const auto now = clock_t::now();
+    for (auto& job : jobs)
+    {
+        job.submitted_time = now;
+        m_wait_times.add(to_milliseconds(now - job.received_time));
+    }
+
+    return jobs;
+}
+
+auto render_service_t::complete(
+    const render_job_t& p_job,
+    const std::vector<std::filesystem::path>& p_paths) -> void
+{
+    const auto now = clock_t::now();
+    const auto latency = to_milliseconds(now - p_job.received_time);
+
+    {
+        const auto lock = std::scoped_lock(m_mutex);
+        m_render_times.add(to_milliseconds(now - p_job.submitted_time));
+        m_latencies.add(latency);
+    }
+
+    auto reply = fmt::format("{} ok {:.3f}", p_job.id, latency);
+    for (const auto& path : p_paths)
+    {
+        reply += ' ';
+        reply += path.string();
+    }
+
+    p_job.client->send(reply);
+}
+
+auto render_service_t::fail(const render_job_t& p_job,
+                            std::string_view p_message) -> void
+{
+    {
+        const auto lock = std::scoped_lock(m_mutex);
+        m_failed_count++;
+    }
+
+    p_job.client->send(fmt::format("{} error {}", p_job.id, p_message));
+}
+
+auto render_service_t::print_statistics() const -> void
+{
+    const auto lock = std::scoped_lock(m_mutex);
+    if (m_batch_sizes.count == 0)
+    {
+        return;
+    }
+
+    fmt::print("[INFO]: The render service completed {} jobs ({} failed) in "
+               "{} batches of {:.1f} jobs on average. The queue held {:.1f} "
+               "jobs on average and {:.0f} at most.\n",
+               m_latencies.count, m_failed_count, m_batch_sizes.count,
+               m_batch_sizes.mean, m_queue_depths.mean, m_queue_depths.max);
+
+    fmt::print("[INFO]: Job latency was {:.3f} ms on average ({:.3f} ms "
+               "queued, {:.3f} ms rendering and reading back), {:.3f} ms at "
+               "most.\n",
+               m_latencies.mean, m_wait_times.mean, m_render_times.mean,
+               m_latencies.max);
+}
+
+auto render_service_t::handle_line(
+    std::string_view p_line,
+    const std::shared_ptr<render_service_client_t>& p_client) -> void
+{
+    if (!p_line.empty() && p_line.back() == '\r')
+    {
+        p_line.remove_suffix(1);
+    }
+
+    if (p_line.empty())
+    {
+        return;
+    }
+
+    if (p_line == "quit")
+    {
+        stop();
+        return;
+    }
+
+    if (p_line == "stats")
+    {
+        p_client->send(format_statistics());
+        return;
+    }
+
+    auto job = render_job_t{.id = {},
+                            .width = DEFAULT_EXTENT,
+                            .height = DEFAULT_EXTENT,
+                            .frame_count = 1,
+                            .object_count = 1,
+                            .color_mode = 0,
+                            .subdivisions = 0,
+                            .time = 0.0f,
+                            .output_path = {},
+                            .client = p_client,
+                            .received_time = clock_t::now(),
+                            .submitted_time = {}};
+
+    const auto lock = std::scoped_lock(m_mutex);
+    m_next_job_number++;
+    job.id = std::to_string(m_next_job_number);
+
+    if (const auto error = parse_job(p_line, job))
+    {
+        m_failed_count++;
+        p_client->send(fmt::format("{} error {}", job.id, *error));
+        return;
+    }
+
+    if (job.output_path.empty())
+    {
+        job.output_path = fmt::format("render_{}.ppm", job.id);
+    }
+
+    m_queue.push_back(std::move(job));
+    m_condition.notify_one();
+}
+
+// Returns an error message if the line isn't a valid job. The id is parsed
+// first, so that the error can be matched to the request.
+auto render_service_t::parse_job(std::string_view p_line,
+                                 render_job_t& p_job) const
+    -> std::optional<std::string>
+{
+    auto pairs = std::vector<std::pair<std::string_view, std::string_view>>();
+    while (!p_line.empty())
+    {
+        const auto start = p_line.find_first_not_of(' ');
+        if (start == std::string_view::npos)
+        {
+            break;
+        }
+        p_line.remove_prefix(start);
+
+        const auto token = p_line.substr(0, p_line.find(' '));
+        p_line.remove_prefix(token.size());
+
+        const auto equals = token.find('=');
+        if (equals == std::string_view::npos)
+        {
+            return fmt::format("expected key=value, not \"{}\"", token);
+        }
+        pairs.emplace_back(token.substr(0, equals), token.substr(equals + 1));
+    }
+
+    for (const auto& [key, value] : pairs)
+    {
+        if (key == "id" && !value.empty())
+        {
+            p_job.id = std::string(value);
+        }
+    }
+
+    for (const auto& [key, value] : pairs)
+    {
+        if (key == "id")
+        {
+            continue;
+        }
+
+        if (key == "output")
+        {
+            p_job.output_path = std::filesystem::path(value);
+            continue;
+        }
+
+        if (key == "time")
+        {
+            const auto time = parse_float(value);
+            if (!time.has_value())
+            {
+                return fmt::format("time should be a number, not \"{}\"",
+                                   value);
+            }
+            p_job.time = *time;
+            continue;
+        }
+
+        const auto number = parse_uint(value);
+        if (!number.has_value())
+        {
+            return fmt::format("{} should be a non-negative integer, not "
+                               "\"{}\"",
+                               key, value);
+        }
+
+        if (key == "width")
+        {
+            p_job.width = *number;
+        }
+        else if (key == "height")
+        {
+            p_job.height = *number;
+        }
+        else if (key == "frames")
+        {
+            p_job.frame_count = *number;
+        }
+        else if (key == "objects")
+        {
+            p_job.object_count = *number;
+        }
+        else if (key == "color")
+        {
+            p_job.color_mode = *number;
+        }
+        else if (key == "subdivisions")
+        {
+            p_job.subdivisions = *number;
+        }
+        else
+        {
+            return fmt::format("unknown key \"{}\"", key);
+        }
+    }
+
+    if (p_job.width == 0 || p_job.height == 0 || p_job.width > m_max_extent ||
+        p_job.height > m_max_extent)
+    {
+        return fmt::format("the resolution has to be between 1x1 and {}x{}",
+                           m_max_extent, m_max_extent);
+    }
+
+    if (p_job.frame_count == 0 || p_job.frame_count > MAX_FRAMES_PER_JOB)
+    {
+        return fmt::format("frames has to be between 1 and {}",
+                           MAX_FRAMES_PER_JOB);
+    }
+
+    if (p_job.object_count == 0 || p_job.object_count > MAX_OBJECTS_PER_JOB)
+    {
+        return fmt::format("objects has to be between 1 and {}",
+                           MAX_OBJECTS_PER_JOB);
+    }
+
+    if (p_job.color_mode >= COLOR_MODE_COUNT)
+    {
+        return fmt::format("color has to be less than {}", COLOR_MODE_COUNT);
+    }
+
+    if (p_job.subdivisions > MAX_SUBDIVISIONS)
+    {
+        return fmt::format("subdivisions has to be at most {}",
+                           MAX_SUBDIVISIONS);
+    }
+
+    return std::nullopt;
+}
+
+auto render_service_t::stop() -> void
+{
+    const auto lock = std::scoped_lock(m_mutex);
+    m_stopped = true;
+    m_condition.notify_all();
+}
+
+auto render_service_t::format_statistics() const -> std::string
+{
+    const auto lock = std::scoped_lock(m_mutex);
+    return fmt::format("stats queued={} completed={} failed={} "
+                       "average_queue_depth={:.2f} average_latency_ms={:.3f} "
+                       "max_latency_ms={:.3f}",
+                       m_queue.size(), m_latencies.count, m_failed_count,
+                       m_queue_depths.mean, m_latencies.mean,
+                       m_latencies.max);
+}
+
+// Ends at the end of the input or at "quit", either of which stops the
+// service.
+auto render_service_t::read_standard_input() -> void
+{
+    const auto client = std::make_shared<render_service_client_t>(
+        render_service_client_t::STANDARD_OUTPUT);
+
+    auto buffer = std::array<char, 4096>();
+    auto line = std::string();
+    while (std::fgets(buffer.data(), static_cast<int>(buffer.size()), stdin))
+    {
+        line += buffer.data();
+        if (line.empty() || line.back() != '\n')
+        {
+            continue;
+        }
+
+        line.pop_back();
+        handle_line(line, client);
+        line.clear();
+
+        if (const auto lock = std::scoped_lock(m_mutex); m_stopped)
+        {
+            return;
+        }
+    }
+
+    if (!line.empty())
+    {
+        handle_line(line, client);
+    }
+
+    stop();
+}
+
+#ifdef __linux__
+auto render_service_t::accept_clients() -> void
+{
+    while (true)
+    {
+        const auto fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        auto finished_threads = std::vector<std::thread>();
+
+        {
+            const auto lock = std::scoped_lock(m_mutex);
+            if (m_stopped)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                return;
+            }
+
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+
+                fmt::print(stderr,
+                           "[ERROR]: The render service stopped accepting "
+                           "connections: {}.\n",
+                           std::strerror(errno));
+                return;
+            }
+
+            // Without this, a long running service would keep a thread and
+            // its stack for every client it has ever served.
+            for (auto& connection : m_client_connections)
+            {
+                if (connection.is_finished)
+                {
+                    finished_threads.push_back(std::move(connection.thread));
+                }
+            }
+            m_client_connections.erase(
+                std::remove_if(m_client_connections.begin(),
+                               m_client_connections.end(),
+                               [](const client_connection_t& p_connection) {
+                                   return p_connection.is_finished;
+                               }),
+                m_client_connections.end());
+
+            m_client_connections.push_back(client_connection_t{
+                .fd = fd,
+                .thread = std::thread(&render_service_t::read_socket, this,
+                                      fd),
+                .is_finished = false});
+        }
+
+        // They've already marked themselves finished, so they're only
+        // returning, and never need the lock again.
+        for (auto& thread : finished_threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+// Ends when the client hangs up, or when the service is destroyed.
+auto render_service_t::read_socket(int p_fd) -> void
+{
+    const auto client = std::make_shared<render_service_client_t>(p_fd);
+
+    auto buffer = std::array<char, 4096>();
+    auto pending = std::string();
+    while (true)
+    {
+        const auto result = recv(p_fd, buffer.data(), buffer.size(), 0);
+        if (result <= 0)
+        {
+            break;
+        }
+        pending.append(buffer.data(), static_cast<std::size_t>(result));
+
+        auto line_start = std::size_t{0};
+        auto line_end = pending.find('\n');
+        while (line_end != std::string::npos)
+        {
+            handle_line(std::string_view(pending).substr(
+                            line_start, line_end - line_start),
+                        client);
+            line_start = line_end + 1;
+            line_end = pending.find('\n', line_start);
+        }
+        pending.erase(0, line_start);
+    }
+
+    // The descriptor stays open for as long as queued jobs need to reply on
+    // it, so the connection is only marked finished here, not closed. Until
+    // the descriptor is closed, no other connection can have its number.
+    const auto lock = std::scoped_lock(m_mutex);
+    for (auto& connection : m_client_connections)
+    {
+        if (connection.fd == p_fd && !connection.is_finished)
+        {
+            connection.is_finished = true;
+        }
+    }
+}
+#endif
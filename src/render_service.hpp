@@ -0,0 +1,152 @@
+#ifndef INCLUDED_RENDER_SERVICE_HPP
+#define INCLUDED_RENDER_SERVICE_HPP
+
+#include "running_statistics.hpp"
+
+// Where a job came from, and where its reply goes.
+class render_service_client_t
+{
+  public:
+    static constexpr auto STANDARD_OUTPUT = -1;
+
+    // p_fd is a connected socket, or STANDARD_OUTPUT. Sockets are closed
+    // once the last job holding on to the client is done.
+    explicit render_service_client_t(int p_fd);
+    ~render_service_client_t();
+
+    render_service_client_t(const render_service_client_t&) = delete;
+    auto operator=(const render_service_client_t&)
+        -> render_service_client_t& = delete;
+
+    // Writes p_line and a newline. Safe to call from any thread. Failures
+    // are ignored, since the client may have gone away.
+    auto send(std::string_view p_line) -> void;
+
+  private:
+    std::mutex m_mutex;
+    int m_fd;
+};
+
+// One request: render frame_count frames of the scene at time, time + 1/60,
+// and so on, and write them to output_path as binary PPM files. With more
+// than one frame, "_<frame>" is inserted before the extension. Each object is
+// the triangle split into 4^subdivisions smaller ones.
+struct render_job_t
+{
+    std::string id;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t frame_count;
+    std::uint32_t object_count;
+    std::uint32_t color_mode;
+    std::uint32_t subdivisions;
+    float time;
+    std::filesystem::path output_path;
+
+    std::shared_ptr<render_service_client_t> client;
+    std::chrono::steady_clock::time_point received_time;
+    std::chrono::steady_clock::time_point submitted_time;
+};
+
+// The transport and the bookkeeping for the headless render service. Jobs
+// arrive as lines of text, either on the standard input or, on Linux, on
+// connections to a Unix domain socket, and are parsed on reader threads into
+// a queue. The render loop takes them off in batches, and completes each one
+// with the paths it wrote, which are sent back to whoever asked.
+//
+// A job is a line of space separated key=value pairs, like
+//
+//     id=a width=640 height=480 frames=2 objects=16 time=0.5 output=a.ppm
+//
+// Every key is optional, and color picks the color mode. The reply is "<id>
+// ok <latency in ms> <paths>..." or "<id> error <message>". A line with just
+// "stats" replies with the queue depth and latencies so far, and "quit" stops
+// the service once the queued jobs are done.
+class render_service_t
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    static constexpr auto MAX_FRAMES_PER_JOB = std::uint32_t{240};
+
+    // 4^9 triangles, about 15 MB of vertices.
+    static constexpr auto MAX_SUBDIVISIONS = std::uint32_t{9};
+
+    // p_endpoint is "-" for the standard input, or the path of the socket to
+    // create. p_max_extent caps the resolution of a job.
+    render_service_t(std::string_view p_endpoint, std::uint32_t p_max_extent);
+    ~render_service_t();
+
+    render_service_t(const render_service_t&) = delete;
+    auto operator=(const render_service_t&) -> render_service_t& = delete;
+
+    // Takes up to p_max_count queued jobs. If p_wait is set and the queue is
+    // empty, blocks until a job arrives. Returns nothing once the service has
+    // been stopped and the queue has drained.
+    auto take_jobs(std::size_t p_max_count, bool p_wait)
+        -> std::vector<render_job_t>;
+
+    // Replies to the job's client and records its latency.
+    auto complete(const render_job_t& p_job,
+                  const std::vector<std::filesystem::path>& p_paths) -> void;
+    auto fail(const render_job_t& p_job, std::string_view p_message) -> void;
+
+    auto print_statistics() const -> void;
+
+  private:
+#ifdef __linux__
+    // A connection to the socket, and the thread reading it. Finished
+    // threads are joined when the next client connects.
+    struct client_connection_t
+    {
+        int fd;
+        std::thread thread;
+        bool is_finished;
+    };
+#endif
+
+    auto handle_line(std::string_view p_line,
+                     const std::shared_ptr<render_service_client_t>& p_client)
+        -> void;
+    auto parse_job(std::string_view p_line, render_job_t& p_job) const
+        -> std::optional<std::string>;
+    auto stop() -> void;
+    auto format_statistics() const -> std::string;
+
+    auto read_standard_input() -> void;
+#ifdef __linux__
+    auto accept_clients() -> void;
+    auto read_socket(int p_fd) -> void;
+#endif
+
+    std::uint32_t m_max_extent;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<render_job_t> m_queue;
+    bool m_stopped;
+    std::uint64_t m_next_job_number;
+
+    // In milliseconds, except for the queue depth, which is sampled whenever
+    // jobs are taken.
+    running_statistics_t m_queue_depths;
+    running_statistics_t m_batch_sizes;
+    running_statistics_t m_wait_times;
+    running_statistics_t m_render_times;
+    running_statistics_t m_latencies;
+    std::uint64_t m_failed_count;
+
+#ifdef __linux__
+    std::string m_socket_path;
+    int m_listen_fd;
+
+    // Guarded by m_mutex. Only the reader thread starts and joins client
+    // threads, until the service is destroyed.
+    std::vector<client_connection_t> m_client_connections;
+#endif
+
+    // Reads the standard input, or accepts connections to the socket.
+    std::thread m_reader_thread;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include "running_statistics.hpp"
+
+auto running_statistics_t::add(double p_sample) -> void
+{
+    // Welford's algorithm.
+    count++;
+    const auto delta = p_sample - mean;
+    mean += delta / static_cast<double>(count);
+    sum_of_squared_deviations += delta * (p_sample - mean);
+
+    min = count == 1 ? p_sample : (std::min)(min, p_sample);
+    max = count == 1 ? p_sample : (std::max)(max, p_sample);
+}
+
+auto running_statistics_t::get_standard_deviation() const -> double
+{
+    return count > 1
+               ? std::sqrt(sum_of_squared_deviations /
+                           static_cast<double>(count - 1))
+               : 0.0;
+}
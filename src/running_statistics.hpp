@@ -0,0 +1,17 @@
+#ifndef INCLUDED_RUNNING_STATISTICS_HPP
+#define INCLUDED_RUNNING_STATISTICS_HPP
+
+// Mean, variance and range of a stream of samples, without storing them.
+struct running_statistics_t
+{
+    std::uint64_t count = 0;
+    double mean = 0.0;
+    double sum_of_squared_deviations = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    auto add(double p_sample) -> void;
+    auto get_standard_deviation() const -> double;
+};
+
+#endif
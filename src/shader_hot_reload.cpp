@@ -0,0 +1,238 @@
+#include "shader_hot_reload.hpp"
+
+namespace
+{
+
+constexpr auto WATCH_INTERVAL = std::chrono::milliseconds(250);
+
+// Editors tend to save in several steps (truncate, write, rename, ...), so we
+// wait for things to settle down a little before compiling anything.
+constexpr auto DEBOUNCE_INTERVAL = std::chrono::milliseconds(50);
+
+auto is_glsl_source(const std::filesystem::path& p_path) -> bool
+{
+    constexpr auto GLSL_EXTENSIONS = std::array<std::string_view, 6>{
+        ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese"};
+
+    const auto extension = p_path.extension().string();
+    return std::find(GLSL_EXTENSIONS.begin(), GLSL_EXTENSIONS.end(),
+                     extension) != GLSL_EXTENSIONS.end();
+}
+
+// This is the same invocation as the compile_shader() function in
+// CMakeLists.txt, so that the hot reloaded shaders are identical to the ones
+// produced by the build.
+auto compile_shader(const std::filesystem::path& p_source) -> bool
+{
+    const auto output = p_source.string() + ".spv";
+    const auto command =
+        fmt::format("glslc -o \"{}\" \"{}\"", output, p_source.string());
+
+    const auto status = std::system(command.c_str());
+    if (status != 0)
+    {
+        fmt::print(stderr, fmt::fg(fmt::color::red),
+                   "[ERROR]: Failed to compile {} (glslc returned {}). Keeping "
+                   "the old pipelines.\n",
+                   p_source.string(), status);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+shader_hot_reloader_t::shader_hot_reloader_t(
+    std::filesystem::path p_shader_directory,
+    build_function_t p_build_pipelines, ready_function_t p_on_ready)
+    : m_shader_directory(std::move(p_shader_directory)),
+      m_build_pipelines(std::move(p_build_pipelines)),
+      m_on_ready(std::move(p_on_ready)), m_running(true)
+{
+#ifdef __linux__
+    m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify_fd < 0 ||
+        inotify_add_watch(m_inotify_fd, m_shader_directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        fmt::print(stderr,
+                   "[ERROR]: Failed to watch {} for changes. Shader hot "
+                   "reloading is disabled.\n",
+                   m_shader_directory.string());
+        m_running = false;
+        return;
+    }
+#else
+    // Without inotify, we just poll the modification times. Record the
+    // initial ones so that we don't rebuild everything straight away.
+    for (const auto& entry :
+         std::filesystem::directory_iterator(m_shader_directory))
+    {
+        if (is_glsl_source(entry.path()))
+        {
+            m_write_times[entry.path()] = entry.last_write_time();
+        }
+    }
+#endif
+
+    fmt::print("[INFO]: Watching {} for shader changes.\n",
+               m_shader_directory.string());
+
+    m_thread = std::thread(&shader_hot_reloader_t::run, this);
+}
+
+shader_hot_reloader_t::~shader_hot_reloader_t()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+#ifdef __linux__
+    if (m_inotify_fd >= 0)
+    {
+        close(m_inotify_fd);
+    }
+#endif
+}
+
+auto shader_hot_reloader_t::poll()
+    -> std::unique_ptr<pipeline_variant_library_t>
+{
+    // The watcher thread only holds the lock for as long as it takes to
+    // publish a library, but even then, we'd rather pick it up next frame
+    // than stall the render loop.
+    auto lock = std::unique_lock(m_ready_pipelines_mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return nullptr;
+    }
+
+    return std::move(m_ready_pipelines);
+}
+
+auto shader_hot_reloader_t::run() -> void
+{
+    while (m_running)
+    {
+        const auto changed_sources = wait_for_changes();
+        if (!changed_sources.empty() && m_running)
+        {
+            rebuild(changed_sources);
+        }
+    }
+}
+
+#ifdef __linux__
+auto shader_hot_reloader_t::wait_for_changes()
+    -> std::vector<std::filesystem::path>
+{
+    auto changed_sources = std::set<std::filesystem::path>();
+
+    auto poll_fd = pollfd{.fd = m_inotify_fd, .events = POLLIN, .revents = 0};
+    auto timeout = static_cast<int>(WATCH_INTERVAL.count());
+
+    // Keep reading until the directory has been quiet for DEBOUNCE_INTERVAL.
+    while (::poll(&poll_fd, 1, timeout) > 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+        const auto length = read(m_inotify_fd, buffer, sizeof(buffer));
+
+        for (auto offset = static_cast<ssize_t>(0); offset < length;)
+        {
+            const auto event =
+                reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0)
+            {
+                const auto path = m_shader_directory / event->name;
+                if (is_glsl_source(path))
+                {
+                    changed_sources.insert(path);
+                }
+            }
+
+            offset += sizeof(inotify_event) + event->len;
+        }
+
+        timeout = static_cast<int>(DEBOUNCE_INTERVAL.count());
+    }
+
+    return {changed_sources.begin(), changed_sources.end()};
+}
+#else
+auto shader_hot_reloader_t::wait_for_changes()
+    -> std::vector<std::filesystem::path>
+{
+    std::this_thread::sleep_for(WATCH_INTERVAL);
+
+    auto changed_sources = std::vector<std::filesystem::path>();
+    auto error = std::error_code();
+    for (const auto& entry :
+         std::filesystem::directory_iterator(m_shader_directory, error))
+    {
+        if (!is_glsl_source(entry.path()))
+        {
+            continue;
+        }
+
+        const auto write_time = entry.last_write_time(error);
+        auto& known_write_time = m_write_times[entry.path()];
+        if (write_time != known_write_time)
+        {
+            known_write_time = write_time;
+            changed_sources.push_back(entry.path());
+        }
+    }
+
+    if (!changed_sources.empty())
+    {
+        std::this_thread::sleep_for(DEBOUNCE_INTERVAL);
+    }
+
+    return changed_sources;
+}
+#endif
+
+auto shader_hot_reloader_t::rebuild(
+    const std::vector<std::filesystem::path>& p_changed_sources) -> void
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    for (const auto& source : p_changed_sources)
+    {
+        fmt::print("[INFO]: {} changed, recompiling.\n", source.string());
+        if (!compile_shader(source))
+        {
+            return;
+        }
+    }
+
+    auto pipelines = m_build_pipelines();
+    if (pipelines == nullptr || !pipelines->is_complete())
+    {
+        fmt::print(stderr, fmt::fg(fmt::color::red),
+                   "[ERROR]: Failed to rebuild the pipelines. Keeping the old "
+                   "ones.\n");
+        return;
+    }
+
+    // If the render loop hasn't picked up the previous library yet, it is
+    // simply replaced. The GPU has never seen it, so it is destroyed right
+    // away (outside of the lock, once it goes out of scope).
+    {
+        const auto lock = std::lock_guard(m_ready_pipelines_mutex);
+        std::swap(m_ready_pipelines, pipelines);
+    }
+
+    if (m_on_ready)
+    {
+        m_on_ready();
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time);
+    fmt::print("[INFO]: Reloaded the shaders in {:.1f} ms.\n",
+               elapsed.count());
+}
@@ -0,0 +1,60 @@
+#ifndef INCLUDED_SHADER_HOT_RELOAD_HPP
+#define INCLUDED_SHADER_HOT_RELOAD_HPP
+
+#include "pipeline_variants.hpp"
+
+// Watches a directory of GLSL shaders and, whenever one of them changes,
+// recompiles it with glslc and rebuilds the pipeline variants on a background
+// thread. The render loop picks finished libraries up with poll(), which never
+// blocks, and is responsible for swapping them in at a frame boundary.
+class shader_hot_reloader_t
+{
+  public:
+    // Called on the watcher thread. Should return nullptr (rather than
+    // exiting) if the pipelines can't be built.
+    using build_function_t =
+        std::function<std::unique_ptr<pipeline_variant_library_t>()>;
+
+    // Called on the watcher thread once a library is ready to be polled.
+    using ready_function_t = std::function<void()>;
+
+    shader_hot_reloader_t(std::filesystem::path p_shader_directory,
+                          build_function_t p_build_pipelines,
+                          ready_function_t p_on_ready = nullptr);
+    ~shader_hot_reloader_t();
+
+    shader_hot_reloader_t(const shader_hot_reloader_t&) = delete;
+    auto operator=(const shader_hot_reloader_t&)
+        -> shader_hot_reloader_t& = delete;
+
+    // Returns the newest library if one has been built since the last call.
+    auto poll() -> std::unique_ptr<pipeline_variant_library_t>;
+
+  private:
+    auto run() -> void;
+    auto wait_for_changes() -> std::vector<std::filesystem::path>;
+    auto rebuild(const std::vector<std::filesystem::path>& p_changed_sources)
+        -> void;
+
+    std::filesystem::path m_shader_directory;
+    build_function_t m_build_pipelines;
+    ready_function_t m_on_ready;
+
+    std::atomic<bool> m_running;
+
+    std::mutex m_ready_pipelines_mutex;
+    std::unique_ptr<pipeline_variant_library_t> m_ready_pipelines;
+
+#ifdef __linux__
+    int m_inotify_fd;
+#else
+    std::map<std::filesystem::path, std::filesystem::file_time_type>
+        m_write_times;
+#endif
+
+    // Declared last, so that everything above is initialized by the time the
+    // thread starts running.
+    std::thread m_thread;
+};
+
+#endif
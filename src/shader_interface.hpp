@@ -0,0 +1,73 @@
+#ifndef INCLUDED_SHADER_INTERFACE_HPP
+#define INCLUDED_SHADER_INTERFACE_HPP
+
+// The data that shader.vert and shader.frag read. The software rasterizer
+// consumes the same structures, so that both backends draw the same scene.
+
+struct vertex_t
+{
+    glm::vec2 position;
+    glm::vec3 color;
+
+    constexpr static auto get_binding_description()
+        -> VkVertexInputBindingDescription
+    {
+        return VkVertexInputBindingDescription{.binding = 0,
+                                               .stride = sizeof(vertex_t),
+                                               .inputRate =
+                                                   VK_VERTEX_INPUT_RATE_VERTEX};
+    }
+
+    constexpr static auto get_attribute_descriptions()
+        -> std::array<VkVertexInputAttributeDescription, 2>
+    {
+        return std::array<VkVertexInputAttributeDescription, 2>{
+            VkVertexInputAttributeDescription{.location = 0,
+                                              .binding = 0,
+                                              .format = VK_FORMAT_R32G32_SFLOAT,
+                                              .offset =
+                                                  offsetof(vertex_t, position)},
+            VkVertexInputAttributeDescription{
+                .location = 1,
+                .binding = 0,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = offsetof(vertex_t, color)},
+        };
+    }
+};
+
+// geometry.comp writes vertices as five tightly packed floats.
+static_assert(sizeof(vertex_t) == 5 * sizeof(float));
+
+// Per-draw data, set with vkCmdPushConstants. This has to match the
+// push_constant block in shader.vert, which uses the std430 layout rules.
+struct push_constants_t
+{
+    glm::mat2 transform;
+    glm::vec2 translation;
+
+    // The object's z in clip space, from 0 (nearest) to 1. Only matters with
+    // a depth buffer, and the software rasterizer ignores it.
+    float depth;
+
+    alignas(16) glm::vec4 tint;
+};
+
+static_assert(sizeof(push_constants_t) == 48);
+static_assert(offsetof(push_constants_t, translation) == 16);
+static_assert(offsetof(push_constants_t, depth) == 24);
+static_assert(offsetof(push_constants_t, tint) == 32);
+
+// Per-frame data, read from a slot in the uniform ring. This has to match the
+// frame uniform block in shader.vert and shader.frag, which uses the std140
+// layout rules.
+struct frame_uniforms_t
+{
+    glm::mat4 view_projection;
+    glm::vec4 color_scale;
+};
+
+static_assert(sizeof(frame_uniforms_t) == 80);
+static_assert(offsetof(frame_uniforms_t, color_scale) == 64);
+
+#endif
@@ -0,0 +1,639 @@
+#include "software_rasterizer.hpp"
+
+namespace
+{
+
+// Positions are snapped to this many subpixel steps, like the 8 bits of
+// subpixel precision that GPUs typically have.
+constexpr auto SUBPIXEL_STEPS = 256.0f;
+
+// Four horizontally adjacent pixels. SSE2 is part of x86-64, so it's always
+// there on the machines this is meant for. Elsewhere the same operations are
+// done one lane at a time. Masks are lanes too: all bits set (or 1.0f in the
+// scalar version) where the condition holds.
+#if defined(__SSE2__) || defined(_M_X64)
+
+using lanes_t = __m128;
+
+auto splat(float p_value) -> lanes_t { return _mm_set1_ps(p_value); }
+
+auto make_lanes(float p_0, float p_1, float p_2, float p_3) -> lanes_t
+{
+    return _mm_setr_ps(p_0, p_1, p_2, p_3);
+}
+
+auto add(lanes_t p_a, lanes_t p_b) -> lanes_t { return _mm_add_ps(p_a, p_b); }
+
+auto subtract(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_sub_ps(p_a, p_b);
+}
+
+auto multiply(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_mul_ps(p_a, p_b);
+}
+
+auto clamp(lanes_t p_value, lanes_t p_min, lanes_t p_max) -> lanes_t
+{
+    return _mm_min_ps(_mm_max_ps(p_value, p_min), p_max);
+}
+
+auto greater_than(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_cmpgt_ps(p_a, p_b);
+}
+
+auto equal(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_cmpeq_ps(p_a, p_b);
+}
+
+auto mask_and(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_and_ps(p_a, p_b);
+}
+
+auto mask_or(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return _mm_or_ps(p_a, p_b);
+}
+
+auto make_mask(bool p_value) -> lanes_t
+{
+    return _mm_castsi128_ps(_mm_set1_epi32(p_value ? -1 : 0));
+}
+
+// Bit i is set if lane i of the mask is.
+auto get_mask_bits(lanes_t p_mask) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(_mm_movemask_ps(p_mask));
+}
+
+// Rounds to the nearest integer.
+auto round_to_integers(lanes_t p_value) -> std::array<std::int32_t, 4>
+{
+    auto result = std::array<std::int32_t, 4>();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(result.data()),
+                     _mm_cvtps_epi32(p_value));
+    return result;
+}
+
+#else
+
+struct lanes_t
+{
+    std::array<float, 4> values;
+};
+
+template <typename F>
+auto for_each_lane(lanes_t p_a, lanes_t p_b, F p_function) -> lanes_t
+{
+    auto result = lanes_t{};
+    for (auto i = std::size_t{0}; i < 4; i++)
+    {
+        result.values[i] = p_function(p_a.values[i], p_b.values[i]);
+    }
+    return result;
+}
+
+auto splat(float p_value) -> lanes_t
+{
+    return lanes_t{{p_value, p_value, p_value, p_value}};
+}
+
+auto make_lanes(float p_0, float p_1, float p_2, float p_3) -> lanes_t
+{
+    return lanes_t{{p_0, p_1, p_2, p_3}};
+}
+
+auto add(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b, [](float a, float b) { return a + b; });
+}
+
+auto subtract(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b, [](float a, float b) { return a - b; });
+}
+
+auto multiply(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b, [](float a, float b) { return a * b; });
+}
+
+auto clamp(lanes_t p_value, lanes_t p_min, lanes_t p_max) -> lanes_t
+{
+    const auto lower = for_each_lane(p_value, p_min, [](float a, float b) {
+        return (std::max)(a, b);
+    });
+    return for_each_lane(lower, p_max,
+                         [](float a, float b) { return (std::min)(a, b); });
+}
+
+auto greater_than(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b,
+                         [](float a, float b) { return a > b ? 1.0f : 0.0f; });
+}
+
+auto equal(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b,
+                         [](float a, float b) { return a == b ? 1.0f : 0.0f; });
+}
+
+auto mask_and(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return multiply(p_a, p_b);
+}
+
+auto mask_or(lanes_t p_a, lanes_t p_b) -> lanes_t
+{
+    return for_each_lane(p_a, p_b,
+                         [](float a, float b) { return (std::max)(a, b); });
+}
+
+auto make_mask(bool p_value) -> lanes_t
+{
+    return splat(p_value ? 1.0f : 0.0f);
+}
+
+auto get_mask_bits(lanes_t p_mask) -> std::uint32_t
+{
+    auto bits = std::uint32_t{0};
+    for (auto i = std::size_t{0}; i < 4; i++)
+    {
+        if (p_mask.values[i] != 0.0f)
+        {
+            bits |= std::uint32_t{1} << i;
+        }
+    }
+    return bits;
+}
+
+auto round_to_integers(lanes_t p_value) -> std::array<std::int32_t, 4>
+{
+    auto result = std::array<std::int32_t, 4>();
+    for (auto i = std::size_t{0}; i < 4; i++)
+    {
+        result[i] = static_cast<std::int32_t>(std::lround(p_value.values[i]));
+    }
+    return result;
+}
+
+#endif
+
+// a * b + c.
+auto multiply_add(lanes_t p_a, lanes_t p_b, lanes_t p_c) -> lanes_t
+{
+    return add(multiply(p_a, p_b), p_c);
+}
+
+// The centers of four pixels, relative to the first one's left edge.
+auto get_lane_centers() -> lanes_t
+{
+    return make_lanes(0.5f, 1.5f, 2.5f, 3.5f);
+}
+
+auto encode_srgb(float p_linear) -> float
+{
+    return p_linear <= 0.0031308f
+               ? 12.92f * p_linear
+               : 1.055f * std::pow(p_linear, 1.0f / 2.4f) - 0.055f;
+}
+
+} // namespace
+
+software_rasterizer_t::software_rasterizer_t(thread_pool_t& p_thread_pool)
+    : m_thread_pool(p_thread_pool), m_extent(), m_tile_columns(0),
+      m_vertices(nullptr), m_vertex_count(0), m_draws(nullptr),
+      m_frame_uniforms(), m_variant(), m_bin_sets(), m_pixels(),
+      m_srgb_table(), m_frame_times(), m_triangle_count(0)
+{
+    for (auto i = std::size_t{0}; i < m_srgb_table.size(); i++)
+    {
+        const auto linear = static_cast<float>(i) /
+                            static_cast<float>(m_srgb_table.size() - 1);
+        m_srgb_table[i] = static_cast<std::uint8_t>(
+            std::lround(encode_srgb(linear) * 255.0f));
+    }
+}
+
+auto software_rasterizer_t::render(VkExtent2D p_extent,
+                                   const vertex_t* p_vertices,
+                                   std::uint32_t p_vertex_count,
+                                   const std::vector<push_constants_t>& p_draws,
+                                   const frame_uniforms_t& p_frame_uniforms,
+                                   const pipeline_variant_key_t& p_variant)
+    -> void
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    m_extent = p_extent;
+    m_vertices = p_vertices;
+    m_vertex_count = p_vertex_count;
+    m_draws = &p_draws;
+    m_frame_uniforms = p_frame_uniforms;
+    m_variant = p_variant;
+
+    m_pixels.resize(static_cast<std::size_t>(p_extent.width) *
+                    p_extent.height * 4);
+
+    m_tile_columns = (p_extent.width + TILE_SIZE - 1) / TILE_SIZE;
+    const auto tile_rows = (p_extent.height + TILE_SIZE - 1) / TILE_SIZE;
+    const auto tile_count = m_tile_columns * tile_rows;
+
+    const auto thread_count = m_thread_pool.get_thread_count();
+    m_bin_sets.resize(thread_count);
+    for (auto& bin_set : m_bin_sets)
+    {
+        bin_set.tiles.resize(tile_count);
+    }
+
+    const auto triangle_count =
+        p_draws.size() * static_cast<std::size_t>(p_vertex_count / 3);
+
+    auto futures = std::vector<std::future<void>>();
+    for (auto i = std::size_t{0}; i < thread_count; i++)
+    {
+        const auto first_triangle = triangle_count * i / thread_count;
+        const auto end_triangle = triangle_count * (i + 1) / thread_count;
+        futures.push_back(m_thread_pool.submit(
+            [this, &bin_set = m_bin_sets[i], first_triangle, end_triangle]() {
+                set_up_triangles(bin_set, first_triangle, end_triangle);
+            }));
+    }
+
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+    futures.clear();
+
+    // Every tile is cleared by the thread that rasterizes it. Interleaving
+    // the tiles spreads busy areas of the frame across the threads.
+    for (auto i = std::size_t{0}; i < thread_count; i++)
+    {
+        futures.push_back(
+            m_thread_pool.submit([this, i, thread_count, tile_count]() {
+                for (auto tile = static_cast<std::uint32_t>(i);
+                     tile < tile_count;
+                     tile += static_cast<std::uint32_t>(thread_count))
+                {
+                    rasterize_tile(tile);
+                }
+            }));
+    }
+
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+
+    m_frame_times.add(std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start_time)
+                          .count());
+    m_triangle_count += triangle_count;
+}
+
+auto software_rasterizer_t::print_statistics() const -> void
+{
+    if (m_frame_times.count == 0)
+    {
+        return;
+    }
+
+    const auto total_seconds =
+        m_frame_times.mean * static_cast<double>(m_frame_times.count) / 1000.0;
+
+    fmt::print("[INFO]: The software rasterizer drew {} frames on {} threads "
+               "in {:.3f} ms on average (standard deviation {:.3f} ms), "
+               "{:.0f} triangles per second.\n",
+               m_frame_times.count, m_thread_pool.get_thread_count(),
+               m_frame_times.mean, m_frame_times.get_standard_deviation(),
+               static_cast<double>(m_triangle_count) / total_seconds);
+}
+
+// Runs the vertex shader, culls, and sets up and bins the triangles in
+// [p_first_triangle, p_end_triangle).
+auto software_rasterizer_t::set_up_triangles(bin_set_t& p_bin_set,
+                                             std::size_t p_first_triangle,
+                                             std::size_t p_end_triangle)
+    -> void
+{
+    p_bin_set.triangles.clear();
+    for (auto& tile : p_bin_set.tiles)
+    {
+        tile.clear();
+    }
+
+    const auto width = static_cast<float>(m_extent.width);
+    const auto height = static_cast<float>(m_extent.height);
+    const auto triangles_per_draw =
+        static_cast<std::size_t>(m_vertex_count / 3);
+
+    for (auto i = p_first_triangle; i < p_end_triangle; i++)
+    {
+        const auto& draw = (*m_draws)[i / triangles_per_draw];
+        const auto first_vertex = (i % triangles_per_draw) * 3;
+
+        auto positions = std::array<glm::vec2, 3>();
+        auto colors = std::array<glm::vec3, 3>();
+        auto is_behind_eye = false;
+
+        for (auto j = std::size_t{0}; j < 3; j++)
+        {
+            const auto& vertex = m_vertices[first_vertex + j];
+            const auto clip_position =
+                m_frame_uniforms.view_projection *
+                glm::vec4(draw.transform * vertex.position + draw.translation,
+                          0.0f, 1.0f);
+            if (clip_position.w <= 0.0f)
+            {
+                is_behind_eye = true;
+                break;
+            }
+
+            // Vulkan's framebuffer y axis points down, just like the rows of
+            // the pixel buffer.
+            const auto window_position =
+                (glm::vec2(clip_position) / clip_position.w + 1.0f) * 0.5f *
+                glm::vec2(width, height);
+            positions[j] = glm::round(window_position * SUBPIXEL_STEPS) /
+                           SUBPIXEL_STEPS;
+            colors[j] = vertex.color * glm::vec3(draw.tint);
+        }
+
+        if (is_behind_eye)
+        {
+            continue;
+        }
+
+        // Twice the signed area. It's positive for triangles that are
+        // clockwise on screen, which the pipeline treats as front facing.
+        auto area = (static_cast<double>(positions[1].x) - positions[0].x) *
+                        (static_cast<double>(positions[2].y) - positions[0].y) -
+                    (static_cast<double>(positions[1].y) - positions[0].y) *
+                        (static_cast<double>(positions[2].x) - positions[0].x);
+        if (area == 0.0)
+        {
+            continue;
+        }
+
+        if (area < 0.0)
+        {
+            if (m_variant.cull_mode == VK_CULL_MODE_BACK_BIT)
+            {
+                continue;
+            }
+
+            std::swap(positions[1], positions[2]);
+            std::swap(colors[1], colors[2]);
+            area = -area;
+        }
+
+        const auto min_position =
+            glm::min(positions[0], glm::min(positions[1], positions[2]));
+        const auto max_position =
+            glm::max(positions[0], glm::max(positions[1], positions[2]));
+
+        // The pixels whose centers fall within the bounds.
+        auto triangle = triangle_t{};
+        triangle.min_x = (std::max)(
+            static_cast<std::int32_t>(std::ceil(min_position.x - 0.5f)), 0);
+        triangle.min_y = (std::max)(
+            static_cast<std::int32_t>(std::ceil(min_position.y - 0.5f)), 0);
+        triangle.max_x = (std::min)(
+            static_cast<std::int32_t>(std::floor(max_position.x - 0.5f)),
+            static_cast<std::int32_t>(m_extent.width) - 1);
+        triangle.max_y = (std::min)(
+            static_cast<std::int32_t>(std::floor(max_position.y - 0.5f)),
+            static_cast<std::int32_t>(m_extent.height) - 1);
+        if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+        {
+            continue;
+        }
+
+        // Edge i is the one opposite vertex i, and its edge function is that
+        // vertex's barycentric coordinate, scaled by the area.
+        auto edge_a = std::array<double, 3>();
+        auto edge_b = std::array<double, 3>();
+        auto edge_c = std::array<double, 3>();
+        for (auto j = std::size_t{0}; j < 3; j++)
+        {
+            const auto& start = positions[(j + 1) % 3];
+            const auto& end = positions[(j + 2) % 3];
+            const auto dx = static_cast<double>(end.x) - start.x;
+            const auto dy = static_cast<double>(end.y) - start.y;
+
+            edge_a[j] = -dy;
+            edge_b[j] = dx;
+            edge_c[j] = dy * start.x - dx * start.y;
+
+            triangle.edge_a[j] = static_cast<float>(edge_a[j]);
+            triangle.edge_b[j] = static_cast<float>(edge_b[j]);
+            triangle.edge_c[j] = static_cast<float>(edge_c[j]);
+            triangle.is_top_left[j] = dy < 0.0 || (dy == 0.0 && dx > 0.0);
+        }
+
+        for (auto channel = glm::length_t{0}; channel < 3; channel++)
+        {
+            auto a = 0.0;
+            auto b = 0.0;
+            auto c = 0.0;
+            for (auto j = std::size_t{0}; j < 3; j++)
+            {
+                a += colors[j][channel] * edge_a[j];
+                b += colors[j][channel] * edge_b[j];
+                c += colors[j][channel] * edge_c[j];
+            }
+            triangle.color_a[channel] = static_cast<float>(a / area);
+            triangle.color_b[channel] = static_cast<float>(b / area);
+            triangle.color_c[channel] = static_cast<float>(c / area);
+        }
+
+        const auto index =
+            static_cast<std::uint32_t>(p_bin_set.triangles.size());
+        p_bin_set.triangles.push_back(triangle);
+
+        for (auto tile_y = static_cast<std::uint32_t>(triangle.min_y) /
+                           TILE_SIZE;
+             tile_y <= static_cast<std::uint32_t>(triangle.max_y) / TILE_SIZE;
+             tile_y++)
+        {
+            for (auto tile_x = static_cast<std::uint32_t>(triangle.min_x) /
+                               TILE_SIZE;
+                 tile_x <=
+                 static_cast<std::uint32_t>(triangle.max_x) / TILE_SIZE;
+                 tile_x++)
+            {
+                p_bin_set.tiles[tile_y * m_tile_columns + tile_x].push_back(
+                    index);
+            }
+        }
+    }
+}
+
+auto software_rasterizer_t::rasterize_tile(std::uint32_t p_tile) -> void
+{
+    const auto tile_min_x =
+        static_cast<std::int32_t>((p_tile % m_tile_columns) * TILE_SIZE);
+    const auto tile_min_y =
+        static_cast<std::int32_t>((p_tile / m_tile_columns) * TILE_SIZE);
+    const auto tile_max_x =
+        (std::min)(tile_min_x + static_cast<std::int32_t>(TILE_SIZE),
+                   static_cast<std::int32_t>(m_extent.width)) -
+        1;
+    const auto tile_max_y =
+        (std::min)(tile_min_y + static_cast<std::int32_t>(TILE_SIZE),
+                   static_cast<std::int32_t>(m_extent.height)) -
+        1;
+
+    for (auto y = tile_min_y; y <= tile_max_y; y++)
+    {
+        auto pixel = m_pixels.data() +
+                     (static_cast<std::size_t>(y) * m_extent.width +
+                      static_cast<std::size_t>(tile_min_x)) *
+                         4;
+        for (auto x = tile_min_x; x <= tile_max_x; x++, pixel += 4)
+        {
+            pixel[0] = std::byte{0};
+            pixel[1] = std::byte{0};
+            pixel[2] = std::byte{0};
+            pixel[3] = std::byte{255};
+        }
+    }
+
+    const auto zero = splat(0.0f);
+    const auto lane_centers = get_lane_centers();
+
+    // The bin sets hold consecutive ranges of the draws, so going through
+    // them in order keeps the draw order.
+    for (const auto& bin_set : m_bin_sets)
+    {
+        for (const auto index : bin_set.tiles[p_tile])
+        {
+            const auto& triangle = bin_set.triangles[index];
+
+            const auto min_x = (std::max)(triangle.min_x, tile_min_x);
+            const auto min_y = (std::max)(triangle.min_y, tile_min_y);
+            const auto max_x = (std::min)(triangle.max_x, tile_max_x);
+            const auto max_y = (std::min)(triangle.max_y, tile_max_y);
+
+            // Lanes past the right end of the bounds are masked off.
+            const auto end_x = splat(static_cast<float>(max_x + 1));
+
+            lanes_t edge_a[3];
+            lanes_t is_top_left[3];
+            for (auto i = std::size_t{0}; i < 3; i++)
+            {
+                edge_a[i] = splat(triangle.edge_a[i]);
+                is_top_left[i] = make_mask(triangle.is_top_left[i]);
+            }
+
+            for (auto y = min_y; y <= max_y; y++)
+            {
+                const auto center_y = static_cast<float>(y) + 0.5f;
+
+                lanes_t row_edges[3];
+                for (auto i = std::size_t{0}; i < 3; i++)
+                {
+                    row_edges[i] = splat(triangle.edge_b[i] * center_y +
+                                         triangle.edge_c[i]);
+                }
+
+                for (auto x = min_x; x <= max_x; x += 4)
+                {
+                    const auto center_x =
+                        add(splat(static_cast<float>(x)), lane_centers);
+
+                    auto covered = greater_than(end_x, center_x);
+                    for (auto i = std::size_t{0}; i < 3; i++)
+                    {
+                        const auto edge =
+                            multiply_add(edge_a[i], center_x, row_edges[i]);
+                        const auto inside =
+                            mask_or(greater_than(edge, zero),
+                                    mask_and(equal(edge, zero),
+                                             is_top_left[i]));
+                        covered = mask_and(covered, inside);
+                    }
+
+                    const auto covered_lanes = get_mask_bits(covered);
+                    if (covered_lanes != 0)
+                    {
+                        shade_and_store(triangle, x, y, covered_lanes);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Interpolates the color for four pixels starting at p_x, p_y, runs the
+// fragment shader on them and writes the covered ones.
+auto software_rasterizer_t::shade_and_store(const triangle_t& p_triangle,
+                                            std::int32_t p_x, std::int32_t p_y,
+                                            std::uint32_t p_covered_lanes)
+    -> void
+{
+    const auto center_x =
+        add(splat(static_cast<float>(p_x)), get_lane_centers());
+    const auto center_y = static_cast<float>(p_y) + 0.5f;
+
+    lanes_t color[3];
+    for (auto i = std::size_t{0}; i < 3; i++)
+    {
+        color[i] = multiply_add(
+            splat(p_triangle.color_a[i]), center_x,
+            splat(p_triangle.color_b[i] * center_y + p_triangle.color_c[i]));
+    }
+
+    if (m_variant.color_mode == color_mode_t::grayscale)
+    {
+        const auto luminance = multiply_add(
+            color[0], splat(0.2126f),
+            multiply_add(color[1], splat(0.7152f),
+                         multiply(color[2], splat(0.0722f))));
+        for (auto& channel : color)
+        {
+            channel = luminance;
+        }
+    }
+    else if (m_variant.color_mode == color_mode_t::inverted)
+    {
+        for (auto& channel : color)
+        {
+            channel = subtract(splat(1.0f), channel);
+        }
+    }
+
+    const auto table_scale =
+        static_cast<float>(m_srgb_table.size() - 1);
+    auto indices = std::array<std::array<std::int32_t, 4>, 3>();
+    for (auto i = std::size_t{0}; i < 3; i++)
+    {
+        const auto scaled = multiply(
+            color[i],
+            splat(m_frame_uniforms.color_scale[static_cast<glm::length_t>(i)]));
+        indices[i] = round_to_integers(multiply(
+            clamp(scaled, splat(0.0f), splat(1.0f)), splat(table_scale)));
+    }
+
+    const auto row = static_cast<std::size_t>(p_y) * m_extent.width;
+    for (auto lane = std::size_t{0}; lane < 4; lane++)
+    {
+        if ((p_covered_lanes & (std::uint32_t{1} << lane)) == 0)
+        {
+            continue;
+        }
+
+        const auto pixel =
+            m_pixels.data() + (row + static_cast<std::size_t>(p_x) + lane) * 4;
+        for (auto i = std::size_t{0}; i < 3; i++)
+        {
+            pixel[i] = static_cast<std::byte>(m_srgb_table[indices[i][lane]]);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef INCLUDED_SOFTWARE_RASTERIZER_HPP
+#define INCLUDED_SOFTWARE_RASTERIZER_HPP
+
+#include "pipeline_variants.hpp"
+#include "running_statistics.hpp"
+#include "shader_interface.hpp"
+#include "thread_pool.hpp"
+
+// Draws the same vertices and per-draw push constants as the Vulkan pipeline,
+// on the CPU, for machines without a usable Vulkan device. It follows
+// shader.vert and shader.frag, except that it never samples the albedo
+// texture, so objects look like they do without VULKAN_TRIANGLE_TEXTURE. It
+// also follows the fixed function state that create_graphics_pipeline() sets
+// up: clockwise front faces, the top-left fill rule and an sRGB color target,
+// cleared to black.
+//
+// The frame is split into square tiles. Each thread of the pool first sets up
+// and bins an equal share of the triangles, then rasterizes its own set of
+// tiles, going through every thread's bins in order so that later draws still
+// end up on top. Within a tile, the edge functions and colors are evaluated
+// for four pixels of a row at a time, with SSE2 where it's available.
+//
+// Vertices behind the eye aren't clipped; triangles with any of them are
+// dropped. Colors are interpolated linearly in screen space, which is only
+// exact for an affine view_projection, like the identity that's used now.
+class software_rasterizer_t
+{
+  public:
+    static constexpr auto TILE_SIZE = std::uint32_t{64};
+
+    explicit software_rasterizer_t(thread_pool_t& p_thread_pool);
+
+    software_rasterizer_t(const software_rasterizer_t&) = delete;
+    auto operator=(const software_rasterizer_t&)
+        -> software_rasterizer_t& = delete;
+
+    // Every draw covers the first p_vertex_count vertices, as a triangle
+    // list.
+    auto render(VkExtent2D p_extent, const vertex_t* p_vertices,
+                std::uint32_t p_vertex_count,
+                const std::vector<push_constants_t>& p_draws,
+                const frame_uniforms_t& p_frame_uniforms,
+                const pipeline_variant_key_t& p_variant) -> void;
+
+    // Tightly packed sRGB encoded RGBA8, top row first, like a readback of
+    // the Vulkan render target. Valid until the next render().
+    auto get_pixels() const -> const std::byte* { return m_pixels.data(); }
+
+    auto print_statistics() const -> void;
+
+  private:
+    // A triangle in pixel coordinates, set up for rasterization. Each edge
+    // function is a * x + b * y + c, positive inside, and each color channel
+    // is a plane over the pixel coordinates in the same way.
+    struct triangle_t
+    {
+        std::array<float, 3> edge_a;
+        std::array<float, 3> edge_b;
+        std::array<float, 3> edge_c;
+
+        // Whether each edge is a top or left edge, so that pixel centers
+        // exactly on it are covered.
+        std::array<bool, 3> is_top_left;
+
+        std::array<float, 3> color_a;
+        std::array<float, 3> color_b;
+        std::array<float, 3> color_c;
+
+        // The bounding box, in whole pixels, clamped to the frame.
+        std::int32_t min_x;
+        std::int32_t min_y;
+        std::int32_t max_x;
+        std::int32_t max_y;
+    };
+
+    // The triangles that one thread set up, and for each tile, the ones that
+    // touch it.
+    struct bin_set_t
+    {
+        std::vector<triangle_t> triangles;
+        std::vector<std::vector<std::uint32_t>> tiles;
+    };
+
+    auto set_up_triangles(bin_set_t& p_bin_set, std::size_t p_first_triangle,
+                          std::size_t p_end_triangle) -> void;
+    auto rasterize_tile(std::uint32_t p_tile) -> void;
+    auto shade_and_store(const triangle_t& p_triangle, std::int32_t p_x,
+                         std::int32_t p_y, std::uint32_t p_covered_lanes)
+        -> void;
+
+    thread_pool_t& m_thread_pool;
+
+    // Inputs of the frame being rendered.
+    VkExtent2D m_extent;
+    std::uint32_t m_tile_columns;
+    const vertex_t* m_vertices;
+    std::uint32_t m_vertex_count;
+    const std::vector<push_constants_t>* m_draws;
+    frame_uniforms_t m_frame_uniforms;
+    pipeline_variant_key_t m_variant;
+
+    std::vector<bin_set_t> m_bin_sets;
+    std::vector<std::byte> m_pixels;
+
+    // Maps a linear color, quantized to 12 bits, to its 8 bit sRGB encoding.
+    std::array<std::uint8_t, 4096> m_srgb_table;
+
+    // In milliseconds.
+    running_statistics_t m_frame_times;
+    std::uint64_t m_triangle_count;
+};
+
+#endif
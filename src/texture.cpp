@@ -0,0 +1,857 @@
+#include "texture.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+// The mip tail is small enough to upload before the first frame, and the
+// rest streams in about this much at a time.
+constexpr auto TAIL_BUDGET = VkDeviceSize{64 * 1024};
+constexpr auto STREAM_BUDGET = VkDeviceSize{4 * 1024 * 1024};
+
+// Covers the texel block size of every format below, and the 4 byte
+// alignment that buffer to image copies need.
+constexpr auto STAGING_ALIGNMENT = VkDeviceSize{16};
+
+constexpr auto KTX2_IDENTIFIER = std::array<std::uint8_t, 12>{
+    0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+constexpr auto KTX2_HEADER_SIZE = std::size_t{80};
+constexpr auto KTX2_LEVEL_INDEX_ENTRY_SIZE = std::size_t{24};
+
+// Formats are block compressed in 4x4 texel blocks.
+struct texture_format_t
+{
+    VkFormat format;
+    std::uint32_t block_size;
+    std::string_view name;
+};
+
+constexpr auto TEXTURE_FORMATS = std::array<texture_format_t, 6>{
+    texture_format_t{VK_FORMAT_BC1_RGB_UNORM_BLOCK, 8, "BC1"},
+    texture_format_t{VK_FORMAT_BC1_RGB_SRGB_BLOCK, 8, "BC1 sRGB"},
+    texture_format_t{VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, "BC1"},
+    texture_format_t{VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 8, "BC1 sRGB"},
+    texture_format_t{VK_FORMAT_BC7_UNORM_BLOCK, 16, "BC7"},
+    texture_format_t{VK_FORMAT_BC7_SRGB_BLOCK, 16, "BC7 sRGB"}};
+
+auto find_texture_format(VkFormat p_format) -> const texture_format_t*
+{
+    const auto format =
+        std::find_if(TEXTURE_FORMATS.begin(), TEXTURE_FORMATS.end(),
+                     [&](const texture_format_t& p_candidate) {
+                         return p_candidate.format == p_format;
+                     });
+
+    return format != TEXTURE_FORMATS.end() ? &*format : nullptr;
+}
+
+constexpr auto WHITE_TEXEL = std::array<std::byte, 4>{
+    std::byte{0xff}, std::byte{0xff}, std::byte{0xff}, std::byte{0xff}};
+
+auto align_up(VkDeviceSize p_size, VkDeviceSize p_alignment) -> VkDeviceSize
+{
+    return (p_size + p_alignment - 1) & ~(p_alignment - 1);
+}
+
+// KTX2 is little endian, as is everything this runs on.
+template <typename T>
+auto read_value(const std::byte* p_data, std::size_t p_offset) -> T
+{
+    auto value = T{};
+    std::memcpy(&value, p_data + p_offset, sizeof(T));
+    return value;
+}
+
+auto get_milliseconds_since(std::chrono::steady_clock::time_point p_start)
+    -> double
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - p_start)
+        .count();
+}
+
+} // namespace
+
+texture_t::texture_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                     VkQueue p_queue, std::uint32_t p_queue_family,
+                     const std::filesystem::path& p_path)
+    : m_device(p_device), m_queue(p_queue), m_path(p_path),
+      m_file_data(nullptr), m_file_size(0),
+#ifdef _WIN32
+      m_file(INVALID_HANDLE_VALUE), m_file_mapping(nullptr),
+#elif !defined(__linux__)
+      m_file_contents(),
+#endif
+      m_format(VK_FORMAT_R8G8B8A8_UNORM), m_levels(), m_image(),
+      m_image_memory(), m_image_views(), m_sampler(),
+      m_descriptor_set_layout(), m_descriptor_pool(), m_descriptor_sets(),
+      m_staging_buffer(), m_staging_memory(), m_staging_data(nullptr),
+      m_staging_size(0), m_command_pool(), m_command_buffer(VK_NULL_HANDLE),
+      m_fence(), m_resident_level(0), m_uploading_level(0),
+      m_start_time(std::chrono::steady_clock::now()), m_level_times(),
+      m_uploaded_bytes(0), m_copy_times()
+{
+    if (p_path.empty())
+    {
+        m_levels.push_back(level_t{.width = 1,
+                                   .height = 1,
+                                   .data = WHITE_TEXEL.data(),
+                                   .size = WHITE_TEXEL.size()});
+    }
+    else
+    {
+        map_file(p_path);
+        parse_file(p_path);
+    }
+
+    const auto level_count = static_cast<std::uint32_t>(m_levels.size());
+    m_resident_level = level_count;
+    m_uploading_level = level_count;
+
+    auto format_properties = VkFormatProperties{};
+    vkGetPhysicalDeviceFormatProperties(p_physical_device, m_format,
+                                        &format_properties);
+    constexpr auto REQUIRED_FEATURES =
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if ((format_properties.optimalTilingFeatures & REQUIRED_FEATURES) !=
+        REQUIRED_FEATURES)
+    {
+        fmt::print("[FATAL ERROR]: The device can't sample the format of {}. "
+                   "Block compressed textures need textureCompressionBC.\n",
+                   p_path.string());
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto image_create_info = VkImageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = m_format,
+        .extent = VkExtent3D{.width = m_levels[0].width,
+                             .height = m_levels[0].height,
+                             .depth = 1},
+        .mipLevels = level_count,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+    auto image = static_cast<VkImage>(VK_NULL_HANDLE);
+    const auto image_result =
+        vkCreateImage(p_device, &image_create_info, nullptr, &image);
+    if (image_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture image. Vulkan "
+                   "error {}.\n",
+                   image_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_image = unique_image_t(image, {p_device});
+
+    auto memory_requirements = VkMemoryRequirements{};
+    vkGetImageMemoryRequirements(p_device, image, &memory_requirements);
+
+    const auto memory_type =
+        find_memory_type(p_physical_device, memory_requirements.memoryTypeBits,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!memory_type.has_value())
+    {
+        fmt::print("[FATAL ERROR]: Failed to find device local memory for the "
+                   "texture.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto memory_allocate_info =
+        VkMemoryAllocateInfo{.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                             .pNext = nullptr,
+                             .allocationSize = memory_requirements.size,
+                             .memoryTypeIndex = *memory_type};
+
+    auto image_memory = static_cast<VkDeviceMemory>(VK_NULL_HANDLE);
+    const auto memory_result = vkAllocateMemory(p_device, &memory_allocate_info,
+                                                nullptr, &image_memory);
+    if (memory_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate memory for the texture. "
+                   "Vulkan error {}.\n",
+                   memory_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_image_memory = unique_device_memory_t(image_memory, {p_device});
+    vkBindImageMemory(p_device, image, image_memory, 0);
+
+    // One view per level, reaching from it down to the smallest.
+    for (auto level = std::uint32_t{0}; level < level_count; level++)
+    {
+        const auto view_create_info = VkImageViewCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = m_format,
+            .components =
+                VkComponentMapping{.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                                   .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+            .subresourceRange =
+                VkImageSubresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                        .baseMipLevel = level,
+                                        .levelCount = level_count - level,
+                                        .baseArrayLayer = 0,
+                                        .layerCount = 1}};
+
+        auto image_view = static_cast<VkImageView>(VK_NULL_HANDLE);
+        const auto view_result = vkCreateImageView(p_device, &view_create_info,
+                                                   nullptr, &image_view);
+        if (view_result != VK_SUCCESS)
+        {
+            fmt::print("[FATAL ERROR]: Failed to create a texture image view. "
+                       "Vulkan error {}.\n",
+                       view_result);
+            std::exit(EXIT_FAILURE);
+        }
+        m_image_views.push_back(unique_image_view_t(image_view, {p_device}));
+    }
+
+    const auto sampler_create_info = VkSamplerCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE};
+
+    auto sampler = static_cast<VkSampler>(VK_NULL_HANDLE);
+    const auto sampler_result =
+        vkCreateSampler(p_device, &sampler_create_info, nullptr, &sampler);
+    if (sampler_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture sampler. "
+                   "Vulkan error {}.\n",
+                   sampler_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_sampler = unique_sampler_t(sampler, {p_device});
+
+    const auto binding = VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .pImmutableSamplers = nullptr};
+
+    const auto layout_create_info = VkDescriptorSetLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = 1,
+        .pBindings = &binding};
+
+    auto descriptor_set_layout =
+        static_cast<VkDescriptorSetLayout>(VK_NULL_HANDLE);
+    const auto layout_result = vkCreateDescriptorSetLayout(
+        p_device, &layout_create_info, nullptr, &descriptor_set_layout);
+    if (layout_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture descriptor set "
+                   "layout. Vulkan error {}.\n",
+                   layout_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_set_layout =
+        unique_descriptor_set_layout_t(descriptor_set_layout, {p_device});
+
+    const auto pool_size =
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                             .descriptorCount = level_count};
+
+    const auto pool_create_info = VkDescriptorPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = level_count,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size};
+
+    auto descriptor_pool = static_cast<VkDescriptorPool>(VK_NULL_HANDLE);
+    const auto pool_result = vkCreateDescriptorPool(
+        p_device, &pool_create_info, nullptr, &descriptor_pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture descriptor "
+                   "pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_pool = unique_descriptor_pool_t(descriptor_pool, {p_device});
+
+    const auto set_layouts = std::vector<VkDescriptorSetLayout>(
+        level_count, descriptor_set_layout);
+    const auto set_allocate_info = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = descriptor_pool,
+        .descriptorSetCount = level_count,
+        .pSetLayouts = set_layouts.data()};
+
+    m_descriptor_sets.resize(level_count);
+    const auto set_result = vkAllocateDescriptorSets(
+        p_device, &set_allocate_info, m_descriptor_sets.data());
+    if (set_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the texture descriptor "
+                   "sets. Vulkan error {}.\n",
+                   set_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto image_infos = std::vector<VkDescriptorImageInfo>();
+    auto writes = std::vector<VkWriteDescriptorSet>();
+    image_infos.reserve(level_count);
+    for (auto level = std::uint32_t{0}; level < level_count; level++)
+    {
+        image_infos.push_back(VkDescriptorImageInfo{
+            .sampler = sampler,
+            .imageView = m_image_views[level].get(),
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+        writes.push_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = m_descriptor_sets[level],
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &image_infos.back(),
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr});
+    }
+    vkUpdateDescriptorSets(p_device, level_count, writes.data(), 0, nullptr);
+
+    // Big enough for the largest level on its own, which is the most that a
+    // single upload ever needs beyond the budget.
+    m_staging_size = (std::max)(
+        align_up(static_cast<VkDeviceSize>(m_levels[0].size),
+                 STAGING_ALIGNMENT),
+        level_count > 1 ? STREAM_BUDGET : VkDeviceSize{STAGING_ALIGNMENT});
+    std::tie(m_staging_buffer, m_staging_memory) = create_buffer(
+        p_physical_device, p_device, m_staging_size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Unmapped when the memory is freed.
+    auto staging_data = static_cast<void*>(nullptr);
+    vkMapMemory(p_device, m_staging_memory.get(), 0, VK_WHOLE_SIZE, 0,
+                &staging_data);
+    m_staging_data = static_cast<std::byte*>(staging_data);
+
+    const auto command_pool_create_info = VkCommandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = p_queue_family};
+
+    auto command_pool = static_cast<VkCommandPool>(VK_NULL_HANDLE);
+    const auto command_pool_result = vkCreateCommandPool(
+        p_device, &command_pool_create_info, nullptr, &command_pool);
+    if (command_pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture's command "
+                   "pool. Vulkan error {}.\n",
+                   command_pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_command_pool = unique_command_pool_t(command_pool, {p_device});
+
+    // Freed along with the pool.
+    const auto command_buffer_allocate_info = VkCommandBufferAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1};
+
+    const auto command_buffer_result = vkAllocateCommandBuffers(
+        p_device, &command_buffer_allocate_info, &m_command_buffer);
+    if (command_buffer_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the texture's command "
+                   "buffer. Vulkan error {}.\n",
+                   command_buffer_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto fence_create_info =
+        VkFenceCreateInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                          .pNext = nullptr,
+                          .flags = 0};
+
+    auto fence = static_cast<VkFence>(VK_NULL_HANDLE);
+    const auto fence_result =
+        vkCreateFence(p_device, &fence_create_info, nullptr, &fence);
+    if (fence_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the texture's fence. "
+                   "Vulkan error {}.\n",
+                   fence_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_fence = unique_fence_t(fence, {p_device});
+
+    // The tail has to be there before anything samples the texture.
+    submit_levels(TAIL_BUDGET);
+    vkWaitForFences(p_device, 1, m_fence.get_address(), VK_TRUE, UINT64_MAX);
+    stream();
+
+    if (!p_path.empty())
+    {
+        fmt::print("[INFO]: Loaded a {}x{} {} texture with {} levels from {}. "
+                   "The smallest {} were uploaded up front.\n",
+                   m_levels[0].width, m_levels[0].height,
+                   find_texture_format(m_format)->name, level_count,
+                   p_path.string(), level_count - m_resident_level);
+    }
+}
+
+texture_t::~texture_t()
+{
+    if (m_uploading_level != m_resident_level)
+    {
+        vkWaitForFences(m_device, 1, m_fence.get_address(), VK_TRUE,
+                        UINT64_MAX);
+    }
+
+    unmap_file();
+}
+
+auto texture_t::stream() -> bool
+{
+    if (m_uploading_level != m_resident_level)
+    {
+        if (vkGetFenceStatus(m_device, m_fence.get()) != VK_SUCCESS)
+        {
+            return true;
+        }
+
+        const auto milliseconds = get_milliseconds_since(m_start_time);
+        for (auto level = m_uploading_level; level < m_resident_level; level++)
+        {
+            m_level_times.push_back(milliseconds);
+        }
+        m_resident_level = m_uploading_level;
+    }
+
+    if (m_resident_level == 0)
+    {
+        // Nothing else will be read from the file.
+        unmap_file();
+        return false;
+    }
+
+    submit_levels(STREAM_BUDGET);
+    return true;
+}
+
+auto texture_t::submit_levels(VkDeviceSize p_budget) -> void
+{
+    // Levels are taken from just below the resident one, towards the
+    // largest, for as long as they fit.
+    auto first_level = m_resident_level - 1;
+    auto size = align_up(m_levels[first_level].size, STAGING_ALIGNMENT);
+    while (first_level > 0)
+    {
+        const auto next_size =
+            align_up(m_levels[first_level - 1].size, STAGING_ALIGNMENT);
+        if (size + next_size > (std::min)(p_budget, m_staging_size))
+        {
+            break;
+        }
+
+        size += next_size;
+        first_level--;
+    }
+
+    const auto copy_start = std::chrono::steady_clock::now();
+
+    auto regions = std::vector<VkBufferImageCopy>();
+    auto offset = VkDeviceSize{0};
+    for (auto level = first_level; level < m_resident_level; level++)
+    {
+        const auto& source = m_levels[level];
+        std::memcpy(m_staging_data + offset, source.data, source.size);
+
+        regions.push_back(VkBufferImageCopy{
+            .bufferOffset = offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource =
+                VkImageSubresourceLayers{.aspectMask =
+                                             VK_IMAGE_ASPECT_COLOR_BIT,
+                                         .mipLevel = level,
+                                         .baseArrayLayer = 0,
+                                         .layerCount = 1},
+            .imageOffset = VkOffset3D{.x = 0, .y = 0, .z = 0},
+            .imageExtent = VkExtent3D{.width = source.width,
+                                      .height = source.height,
+                                      .depth = 1}});
+
+        offset += align_up(source.size, STAGING_ALIGNMENT);
+        m_uploaded_bytes += source.size;
+    }
+
+    m_copy_times.add(get_milliseconds_since(copy_start));
+
+    vkResetFences(m_device, 1, m_fence.get_address());
+    vkResetCommandBuffer(m_command_buffer, 0);
+
+    const auto begin_info = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr};
+
+    const auto begin_result =
+        vkBeginCommandBuffer(m_command_buffer, &begin_info);
+    if (begin_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to begin recording a texture upload. "
+                   "Vulkan error {}.\n",
+                   begin_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto range =
+        VkImageSubresourceRange{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                .baseMipLevel = first_level,
+                                .levelCount = m_resident_level - first_level,
+                                .baseArrayLayer = 0,
+                                .layerCount = 1};
+
+    // The levels have never been written, so their old contents can go.
+    const auto to_transfer = VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image.get(),
+        .subresourceRange = range};
+    vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &to_transfer);
+
+    vkCmdCopyBufferToImage(m_command_buffer, m_staging_buffer.get(),
+                           m_image.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<std::uint32_t>(regions.size()),
+                           regions.data());
+
+    // Nothing samples these levels until the fence says they're done, but
+    // the barrier still has to make the writes visible to the shaders.
+    const auto to_shader_read = VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_image.get(),
+        .subresourceRange = range};
+    vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &to_shader_read);
+
+    const auto end_result = vkEndCommandBuffer(m_command_buffer);
+    if (end_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to stop recording a texture upload. "
+                   "Vulkan error {}.\n",
+                   end_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto submit_info =
+        VkSubmitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                     .pNext = nullptr,
+                     .waitSemaphoreCount = 0,
+                     .pWaitSemaphores = nullptr,
+                     .pWaitDstStageMask = nullptr,
+                     .commandBufferCount = 1,
+                     .pCommandBuffers = &m_command_buffer,
+                     .signalSemaphoreCount = 0,
+                     .pSignalSemaphores = nullptr};
+
+    const auto submit_result =
+        vkQueueSubmit(m_queue, 1, &submit_info, m_fence.get());
+    if (submit_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to submit a texture upload. Vulkan "
+                   "error {}.\n",
+                   submit_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_uploading_level = first_level;
+}
+
+auto texture_t::print_statistics() const -> void
+{
+    if (m_path.empty() || m_level_times.empty())
+    {
+        return;
+    }
+
+    // What the same levels would have taken as uncompressed RGBA8.
+    auto uncompressed_bytes = std::uint64_t{0};
+    for (const auto& level : m_levels)
+    {
+        uncompressed_bytes += std::uint64_t{4} * level.width * level.height;
+    }
+
+    fmt::print("[INFO]: Uploaded {} of {} texture levels, {:.2f} MB instead "
+               "of {:.2f} MB uncompressed. Each upload spent {:.3f} ms copying "
+               "from the file on average. The smallest levels were visible "
+               "after {:.1f} ms, and the largest one {}.\n",
+               m_level_times.size(), m_levels.size(),
+               static_cast<double>(m_uploaded_bytes) / 1e6,
+               static_cast<double>(uncompressed_bytes) / 1e6,
+               m_copy_times.mean, m_level_times.front(),
+               m_resident_level == 0
+                   ? fmt::format("after {:.1f} ms", m_level_times.back())
+                   : std::string("never arrived"));
+}
+
+auto texture_t::parse_file(const std::filesystem::path& p_path) -> void
+{
+    const auto fail = [&](std::string_view p_reason) {
+        fmt::print("[FATAL ERROR]: Can't use {} as a texture: {}.\n",
+                   p_path.string(), p_reason);
+        std::exit(EXIT_FAILURE);
+    };
+
+    if (m_file_size < KTX2_HEADER_SIZE ||
+        std::memcmp(m_file_data, KTX2_IDENTIFIER.data(),
+                    KTX2_IDENTIFIER.size()) != 0)
+    {
+        fail("it isn't a KTX2 file");
+    }
+
+    m_format =
+        static_cast<VkFormat>(read_value<std::uint32_t>(m_file_data, 12));
+    const auto width = read_value<std::uint32_t>(m_file_data, 20);
+    const auto height = read_value<std::uint32_t>(m_file_data, 24);
+    const auto depth = read_value<std::uint32_t>(m_file_data, 28);
+    const auto layer_count = read_value<std::uint32_t>(m_file_data, 32);
+    const auto face_count = read_value<std::uint32_t>(m_file_data, 36);
+    const auto level_count = read_value<std::uint32_t>(m_file_data, 40);
+    const auto supercompression = read_value<std::uint32_t>(m_file_data, 44);
+
+    const auto format = find_texture_format(m_format);
+    if (format == nullptr)
+    {
+        fail("only BC1 and BC7 are supported");
+    }
+    if (supercompression != 0)
+    {
+        fail("supercompressed files aren't supported");
+    }
+    if (width == 0 || height == 0 || depth != 0 || layer_count > 1 ||
+        face_count != 1)
+    {
+        fail("it isn't a single 2D image");
+    }
+    // A level count of zero asks the loader to generate the mips.
+    if (level_count == 0)
+    {
+        fail("it has no pre-built mips");
+    }
+    if (level_count > MAX_LEVEL_COUNT ||
+        level_count > std::bit_width((std::max)(width, height)))
+    {
+        fail("it has more levels than its size allows");
+    }
+
+    const auto level_index_end =
+        KTX2_HEADER_SIZE + level_count * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+    if (m_file_size < level_index_end)
+    {
+        fail("its level index is cut short");
+    }
+
+    for (auto level = std::uint32_t{0}; level < level_count; level++)
+    {
+        const auto entry =
+            KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        const auto offset = read_value<std::uint64_t>(m_file_data, entry);
+        const auto size = read_value<std::uint64_t>(m_file_data, entry + 8);
+
+        const auto level_width = (std::max)(width >> level, 1u);
+        const auto level_height = (std::max)(height >> level, 1u);
+        const auto expected_size = std::uint64_t{(level_width + 3) / 4} *
+                                   ((level_height + 3) / 4) *
+                                   format->block_size;
+
+        if (size != expected_size)
+        {
+            fail(fmt::format("level {} is {} bytes instead of {}", level, size,
+                             expected_size));
+        }
+        if (offset > m_file_size || size > m_file_size - offset)
+        {
+            fail(fmt::format("level {} runs past the end of the file", level));
+        }
+
+        m_levels.push_back(level_t{.width = level_width,
+                                   .height = level_height,
+                                   .data = m_file_data + offset,
+                                   .size = static_cast<std::size_t>(size)});
+    }
+}
+
+#ifdef _WIN32
+
+auto texture_t::map_file(const std::filesystem::path& p_path) -> void
+{
+    m_file = CreateFileW(p_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                         nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}. Windows error {}.\n",
+                   p_path.string(), GetLastError());
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto size = LARGE_INTEGER{};
+    GetFileSizeEx(m_file, &size);
+    m_file_size = static_cast<std::size_t>(size.QuadPart);
+
+    m_file_mapping =
+        CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto view =
+        m_file_mapping != nullptr
+            ? MapViewOfFile(m_file_mapping, FILE_MAP_READ, 0, 0, 0)
+            : nullptr;
+    if (view == nullptr)
+    {
+        fmt::print("[FATAL ERROR]: Failed to map {}. Windows error {}.\n",
+                   p_path.string(), GetLastError());
+        std::exit(EXIT_FAILURE);
+    }
+    m_file_data = static_cast<const std::byte*>(view);
+}
+
+auto texture_t::unmap_file() -> void
+{
+    if (m_file_data != nullptr)
+    {
+        UnmapViewOfFile(m_file_data);
+        m_file_data = nullptr;
+    }
+    if (m_file_mapping != nullptr)
+    {
+        CloseHandle(m_file_mapping);
+        m_file_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+#elif defined(__linux__)
+
+auto texture_t::map_file(const std::filesystem::path& p_path) -> void
+{
+    const auto fd = open(p_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}: {}.\n", p_path.string(),
+                   std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto size = lseek(fd, 0, SEEK_END);
+    const auto view =
+        size > 0 ? mmap(nullptr, static_cast<std::size_t>(size), PROT_READ,
+                        MAP_PRIVATE, fd, 0)
+                 : MAP_FAILED;
+    const auto error = errno;
+
+    // The mapping keeps the file open by itself.
+    close(fd);
+
+    if (view == MAP_FAILED)
+    {
+        fmt::print("[FATAL ERROR]: Failed to map {}: {}.\n", p_path.string(),
+                   size > 0 ? std::strerror(error) : "the file is empty");
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_file_data = static_cast<const std::byte*>(view);
+    m_file_size = static_cast<std::size_t>(size);
+}
+
+auto texture_t::unmap_file() -> void
+{
+    if (m_file_data != nullptr)
+    {
+        munmap(const_cast<std::byte*>(m_file_data), m_file_size);
+        m_file_data = nullptr;
+    }
+}
+
+#else
+
+auto texture_t::map_file(const std::filesystem::path& p_path) -> void
+{
+    auto file = std::ifstream(p_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        fmt::print("[FATAL ERROR]: Failed to open {}.\n", p_path.string());
+        std::exit(EXIT_FAILURE);
+    }
+
+    m_file_contents.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_file_contents.data()),
+              static_cast<std::streamsize>(m_file_contents.size()));
+
+    m_file_data = m_file_contents.data();
+    m_file_size = m_file_contents.size();
+}
+
+auto texture_t::unmap_file() -> void
+{
+    m_file_contents = std::vector<std::byte>();
+    m_file_data = nullptr;
+}
+
+#endif
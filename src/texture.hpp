@@ -0,0 +1,124 @@
+#ifndef INCLUDED_TEXTURE_HPP
+#define INCLUDED_TEXTURE_HPP
+
+#include "running_statistics.hpp"
+#include "vulkan_handle.hpp"
+
+// A sampled 2D texture, read in shader.frag through a combined image sampler
+// at set 1, binding 0.
+//
+// Textures come from KTX2 files with pre-built mips in BC1 or BC7, which stay
+// compressed all the way to the GPU. The file is memory mapped, and each level
+// is copied straight from the mapping into a staging buffer, and from there
+// into the image. Without a file, the texture is a single white texel, which
+// leaves the vertex colors as they are.
+//
+// The levels are uploaded smallest first. The mip tail is uploaded before the
+// constructor returns, so the texture can always be sampled, and every call
+// to stream() submits the next few larger levels without waiting for them.
+// There's a descriptor set for each level, written once, that samples from it
+// down to the smallest. Once a level's upload has finished, the texture
+// switches to that level's set, so nothing is ever updated while the GPU might
+// be reading it, and sampling never touches a level that isn't there yet.
+class texture_t
+{
+  public:
+    // Enough for a 65536 texel wide texture.
+    static constexpr auto MAX_LEVEL_COUNT = std::uint32_t{17};
+
+    // An empty p_path makes the white texture. The queue is only used from
+    // the thread calling stream(), but it has to be the one that the frames
+    // are submitted to, or the levels would need an ownership transfer.
+    texture_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+              VkQueue p_queue, std::uint32_t p_queue_family,
+              const std::filesystem::path& p_path);
+
+    // Waits for the upload in flight.
+    ~texture_t();
+
+    texture_t(const texture_t&) = delete;
+    auto operator=(const texture_t&) -> texture_t& = delete;
+
+    auto get_descriptor_set_layout() const -> VkDescriptorSetLayout
+    {
+        return m_descriptor_set_layout.get();
+    }
+
+    // The set that samples every level uploaded so far.
+    auto get_descriptor_set() const -> VkDescriptorSet
+    {
+        return m_descriptor_sets[m_resident_level];
+    }
+
+    // Picks up the last upload if it's done, and submits the next one. Never
+    // waits. Returns true while there are levels left, so that the caller
+    // keeps drawing frames until the texture is complete.
+    auto stream() -> bool;
+
+    auto print_statistics() const -> void;
+
+  private:
+    struct level_t
+    {
+        std::uint32_t width;
+        std::uint32_t height;
+        const std::byte* data;
+        std::size_t size;
+    };
+
+    auto map_file(const std::filesystem::path& p_path) -> void;
+    auto unmap_file() -> void;
+    auto parse_file(const std::filesystem::path& p_path) -> void;
+
+    // Uploads the largest run of levels below the resident one that fits in
+    // p_budget bytes, and at least one.
+    auto submit_levels(VkDeviceSize p_budget) -> void;
+
+    VkDevice m_device;
+    VkQueue m_queue;
+
+    std::filesystem::path m_path;
+    const std::byte* m_file_data;
+    std::size_t m_file_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_file_mapping;
+#elif !defined(__linux__)
+    std::vector<std::byte> m_file_contents;
+#endif
+
+    VkFormat m_format;
+    std::vector<level_t> m_levels;
+
+    unique_image_t m_image;
+    unique_device_memory_t m_image_memory;
+    std::vector<unique_image_view_t> m_image_views;
+    unique_sampler_t m_sampler;
+
+    unique_descriptor_set_layout_t m_descriptor_set_layout;
+    unique_descriptor_pool_t m_descriptor_pool;
+    std::vector<VkDescriptorSet> m_descriptor_sets;
+
+    unique_buffer_t m_staging_buffer;
+    unique_device_memory_t m_staging_memory;
+    std::byte* m_staging_data;
+    VkDeviceSize m_staging_size;
+
+    unique_command_pool_t m_command_pool;
+    VkCommandBuffer m_command_buffer;
+    unique_fence_t m_fence;
+
+    // Every level from m_resident_level down to the smallest can be sampled.
+    // The levels from m_uploading_level up to it are in flight, if the two
+    // differ.
+    std::uint32_t m_resident_level;
+    std::uint32_t m_uploading_level;
+
+    std::chrono::steady_clock::time_point m_start_time;
+    // In milliseconds since m_start_time, per level that became resident.
+    std::vector<double> m_level_times;
+    std::uint64_t m_uploaded_bytes;
+    running_statistics_t m_copy_times;
+};
+
+#endif
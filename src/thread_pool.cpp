@@ -0,0 +1,69 @@
+#include "thread_pool.hpp"
+
+thread_pool_t::thread_pool_t(std::size_t p_thread_count) : m_stopping(false)
+{
+    if (p_thread_count == 0)
+    {
+        p_thread_count = (std::max)(std::thread::hardware_concurrency(), 1u);
+    }
+
+    m_threads.reserve(p_thread_count);
+    for (auto i = static_cast<std::size_t>(0); i < p_thread_count; i++)
+    {
+        m_threads.emplace_back(&thread_pool_t::run, this);
+    }
+}
+
+thread_pool_t::~thread_pool_t()
+{
+    {
+        const auto lock = std::lock_guard(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+auto thread_pool_t::submit(std::function<void()> p_job) -> std::future<void>
+{
+    auto task = std::packaged_task<void()>(std::move(p_job));
+    auto future = task.get_future();
+
+    {
+        const auto lock = std::lock_guard(m_mutex);
+        m_jobs.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+
+    return future;
+}
+
+auto thread_pool_t::run() -> void
+{
+    while (true)
+    {
+        auto job = std::packaged_task<void()>();
+
+        {
+            auto lock = std::unique_lock(m_mutex);
+            m_condition.wait(lock,
+                             [this]() { return m_stopping || !m_jobs.empty(); });
+
+            // Finish off whatever is still queued before shutting down, so
+            // that nobody is left waiting on a future that never completes.
+            if (m_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+    }
+}
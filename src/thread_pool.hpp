@@ -0,0 +1,30 @@
+#ifndef INCLUDED_THREAD_POOL_HPP
+#define INCLUDED_THREAD_POOL_HPP
+
+// A fixed set of worker threads pulling jobs off a shared queue.
+class thread_pool_t
+{
+  public:
+    // A thread count of zero means one thread per hardware thread.
+    explicit thread_pool_t(std::size_t p_thread_count = 0);
+    ~thread_pool_t();
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    auto operator=(const thread_pool_t&) -> thread_pool_t& = delete;
+
+    auto submit(std::function<void()> p_job) -> std::future<void>;
+
+    auto get_thread_count() const -> std::size_t { return m_threads.size(); }
+
+  private:
+    auto run() -> void;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::packaged_task<void()>> m_jobs;
+    bool m_stopping;
+
+    std::vector<std::thread> m_threads;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "uniform_ring.hpp"
+
+#include "buffer.hpp"
+
+namespace
+{
+
+// minUniformBufferOffsetAlignment is guaranteed to be a power of two.
+auto align_up(VkDeviceSize p_size, VkDeviceSize p_alignment) -> VkDeviceSize
+{
+    return (p_size + p_alignment - 1) & ~(p_alignment - 1);
+}
+
+} // namespace
+
+uniform_ring_t::uniform_ring_t(VkPhysicalDevice p_physical_device,
+                               VkDevice p_device, VkDeviceSize p_element_size,
+                               std::uint32_t p_slot_count,
+                               VkShaderStageFlags p_stages)
+    : m_device(p_device), m_element_size(p_element_size),
+      m_slot_count(p_slot_count), m_next_slot(0)
+{
+    auto device_properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(p_physical_device, &device_properties);
+
+    m_slot_size = align_up(
+        p_element_size,
+        (std::max)(device_properties.limits.minUniformBufferOffsetAlignment,
+                   static_cast<VkDeviceSize>(1)));
+
+    // Host coherent memory, so that writes are visible to the GPU without
+    // any flushing.
+    std::tie(m_buffer, m_memory) = create_buffer(
+        p_physical_device, p_device, m_slot_size * p_slot_count,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    auto mapped_memory = static_cast<void*>(nullptr);
+    vkMapMemory(p_device, m_memory.get(), 0, VK_WHOLE_SIZE, 0,
+                &mapped_memory);
+    m_mapped_memory = static_cast<std::byte*>(mapped_memory);
+
+    const auto binding = VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags = p_stages,
+        .pImmutableSamplers = nullptr};
+
+    const auto layout_create_info = VkDescriptorSetLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = 1,
+        .pBindings = &binding};
+
+    auto descriptor_set_layout =
+        static_cast<VkDescriptorSetLayout>(VK_NULL_HANDLE);
+    const auto layout_result = vkCreateDescriptorSetLayout(
+        p_device, &layout_create_info, nullptr, &descriptor_set_layout);
+    if (layout_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the uniform descriptor set "
+                   "layout. Vulkan error {}.\n",
+                   layout_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_set_layout =
+        unique_descriptor_set_layout_t(descriptor_set_layout, {p_device});
+
+    const auto pool_size =
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                             .descriptorCount = 1};
+
+    const auto pool_create_info = VkDescriptorPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size};
+
+    auto descriptor_pool = static_cast<VkDescriptorPool>(VK_NULL_HANDLE);
+    const auto pool_result = vkCreateDescriptorPool(
+        p_device, &pool_create_info, nullptr, &descriptor_pool);
+    if (pool_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to create the uniform descriptor "
+                   "pool. Vulkan error {}.\n",
+                   pool_result);
+        std::exit(EXIT_FAILURE);
+    }
+    m_descriptor_pool = unique_descriptor_pool_t(descriptor_pool, {p_device});
+
+    const auto allocate_info = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = m_descriptor_pool.get(),
+        .descriptorSetCount = 1,
+        .pSetLayouts = m_descriptor_set_layout.get_address()};
+
+    const auto allocate_result =
+        vkAllocateDescriptorSets(p_device, &allocate_info, &m_descriptor_set);
+    if (allocate_result != VK_SUCCESS)
+    {
+        fmt::print("[FATAL ERROR]: Failed to allocate the uniform descriptor "
+                   "set. Vulkan error {}.\n",
+                   allocate_result);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // The range only covers a single slot. The dynamic offset picks which one.
+    const auto buffer_info = VkDescriptorBufferInfo{
+        .buffer = m_buffer.get(), .offset = 0, .range = p_element_size};
+
+    const auto write = VkWriteDescriptorSet{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = m_descriptor_set,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &buffer_info,
+        .pTexelBufferView = nullptr};
+
+    vkUpdateDescriptorSets(p_device, 1, &write, 0, nullptr);
+}
+
+// The handles clean up after themselves, but the memory has to be unmapped
+// before it's freed.
+uniform_ring_t::~uniform_ring_t() { vkUnmapMemory(m_device, m_memory.get()); }
+
+auto uniform_ring_t::push(const void* p_data, VkDeviceSize p_size)
+    -> std::uint32_t
+{
+    const auto offset = m_next_slot * m_slot_size;
+    std::memcpy(m_mapped_memory + offset, p_data,
+                static_cast<std::size_t>((std::min)(p_size, m_element_size)));
+
+    m_next_slot = (m_next_slot + 1) % m_slot_count;
+
+    return static_cast<std::uint32_t>(offset);
+}
@@ -0,0 +1,60 @@
+#ifndef INCLUDED_UNIFORM_RING_HPP
+#define INCLUDED_UNIFORM_RING_HPP
+
+#include "vulkan_handle.hpp"
+
+// A persistently mapped uniform buffer, split into equally sized slots that are
+// handed out round-robin. The whole buffer is described by a single
+// VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor, written once, so moving
+// on to the next slot only means binding the set with a different dynamic
+// offset. Nothing is allocated or updated per frame.
+class uniform_ring_t
+{
+  public:
+    // The slot count has to be larger than the number of frames that can be
+    // in flight, or a slot might be overwritten while the GPU still reads it.
+    uniform_ring_t(VkPhysicalDevice p_physical_device, VkDevice p_device,
+                   VkDeviceSize p_element_size, std::uint32_t p_slot_count,
+                   VkShaderStageFlags p_stages);
+    ~uniform_ring_t();
+
+    uniform_ring_t(const uniform_ring_t&) = delete;
+    auto operator=(const uniform_ring_t&) -> uniform_ring_t& = delete;
+
+    auto get_descriptor_set_layout() const -> VkDescriptorSetLayout
+    {
+        return m_descriptor_set_layout.get();
+    }
+
+    auto get_descriptor_set() const -> VkDescriptorSet
+    {
+        return m_descriptor_set;
+    }
+
+    // Copies p_data into the next slot, and returns the dynamic offset that
+    // selects it.
+    auto push(const void* p_data, VkDeviceSize p_size) -> std::uint32_t;
+
+    template <typename T> auto push(const T& p_data) -> std::uint32_t
+    {
+        return push(&p_data, sizeof(T));
+    }
+
+  private:
+    VkDevice m_device;
+
+    VkDeviceSize m_element_size;
+    VkDeviceSize m_slot_size;
+    std::uint32_t m_slot_count;
+    std::uint32_t m_next_slot;
+
+    unique_buffer_t m_buffer;
+    unique_device_memory_t m_memory;
+    std::byte* m_mapped_memory;
+
+    unique_descriptor_set_layout_t m_descriptor_set_layout;
+    unique_descriptor_pool_t m_descriptor_pool;
+    VkDescriptorSet m_descriptor_set;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef INCLUDED_VULKAN_HANDLE_HPP
+#define INCLUDED_VULKAN_HANDLE_HPP
+
+// A move-only owner for a Vulkan (or GLFW) handle. The deleter carries
+// whatever the handle needs to be destroyed, usually the device it belongs
+// to. A default constructed or moved-from owner holds a null handle and
+// doesn't destroy anything.
+template <typename T, typename Deleter> class unique_handle_t
+{
+  public:
+    unique_handle_t() : m_handle{}, m_deleter{} {}
+
+    unique_handle_t(T p_handle, Deleter p_deleter)
+        : m_handle(p_handle), m_deleter(p_deleter)
+    {
+    }
+
+    ~unique_handle_t() { reset(); }
+
+    unique_handle_t(const unique_handle_t&) = delete;
+    auto operator=(const unique_handle_t&) -> unique_handle_t& = delete;
+
+    unique_handle_t(unique_handle_t&& p_other) noexcept
+        : m_handle(std::exchange(p_other.m_handle, T{})),
+          m_deleter(p_other.m_deleter)
+    {
+    }
+
+    auto operator=(unique_handle_t&& p_other) noexcept -> unique_handle_t&
+    {
+        if (this != &p_other)
+        {
+            reset();
+            m_handle = std::exchange(p_other.m_handle, T{});
+            m_deleter = p_other.m_deleter;
+        }
+
+        return *this;
+    }
+
+    auto get() const -> T { return m_handle; }
+
+    // Some Vulkan functions take arrays of handles. This is for passing a
+    // single one of those.
+    auto get_address() const -> const T* { return &m_handle; }
+
+    explicit operator bool() const { return m_handle != T{}; }
+
+    // Gives up ownership without destroying the handle.
+    auto release() -> T { return std::exchange(m_handle, T{}); }
+
+    auto reset() -> void
+    {
+        if (m_handle != T{})
+        {
+            m_deleter(std::exchange(m_handle, T{}));
+        }
+    }
+
+  private:
+    T m_handle;
+    Deleter m_deleter;
+};
+
+// Handles created from a VkDevice all follow the same
+// vkDestroy*(device, handle, allocator) pattern.
+#define DEFINE_DEVICE_CHILD_HANDLE(name, type, destroy_function)               \
+    struct name##_deleter_t                                                    \
+    {                                                                          \
+        VkDevice device;                                                       \
+                                                                               \
+        auto operator()(type p_handle) const -> void                           \
+        {                                                                      \
+            destroy_function(device, p_handle, nullptr);                       \
+        }                                                                      \
+    };                                                                         \
+                                                                               \
+    using unique_##name##_t = unique_handle_t<type, name##_deleter_t>
+
+DEFINE_DEVICE_CHILD_HANDLE(buffer, VkBuffer, vkDestroyBuffer);
+DEFINE_DEVICE_CHILD_HANDLE(command_pool, VkCommandPool, vkDestroyCommandPool);
+DEFINE_DEVICE_CHILD_HANDLE(descriptor_pool, VkDescriptorPool,
+                           vkDestroyDescriptorPool);
+DEFINE_DEVICE_CHILD_HANDLE(descriptor_set_layout, VkDescriptorSetLayout,
+                           vkDestroyDescriptorSetLayout);
+DEFINE_DEVICE_CHILD_HANDLE(device_memory, VkDeviceMemory, vkFreeMemory);
+DEFINE_DEVICE_CHILD_HANDLE(fence, VkFence, vkDestroyFence);
+DEFINE_DEVICE_CHILD_HANDLE(framebuffer, VkFramebuffer, vkDestroyFramebuffer);
+DEFINE_DEVICE_CHILD_HANDLE(image, VkImage, vkDestroyImage);
+DEFINE_DEVICE_CHILD_HANDLE(image_view, VkImageView, vkDestroyImageView);
+DEFINE_DEVICE_CHILD_HANDLE(pipeline, VkPipeline, vkDestroyPipeline);
+DEFINE_DEVICE_CHILD_HANDLE(pipeline_cache, VkPipelineCache,
+                           vkDestroyPipelineCache);
+DEFINE_DEVICE_CHILD_HANDLE(pipeline_layout, VkPipelineLayout,
+                           vkDestroyPipelineLayout);
+DEFINE_DEVICE_CHILD_HANDLE(query_pool, VkQueryPool, vkDestroyQueryPool);
+DEFINE_DEVICE_CHILD_HANDLE(render_pass, VkRenderPass, vkDestroyRenderPass);
+DEFINE_DEVICE_CHILD_HANDLE(sampler, VkSampler, vkDestroySampler);
+DEFINE_DEVICE_CHILD_HANDLE(semaphore, VkSemaphore, vkDestroySemaphore);
+DEFINE_DEVICE_CHILD_HANDLE(shader_module, VkShaderModule,
+                           vkDestroyShaderModule);
+DEFINE_DEVICE_CHILD_HANDLE(swapchain, VkSwapchainKHR, vkDestroySwapchainKHR);
+
+#undef DEFINE_DEVICE_CHILD_HANDLE
+
+struct device_deleter_t
+{
+    auto operator()(VkDevice p_device) const -> void
+    {
+        vkDestroyDevice(p_device, nullptr);
+    }
+};
+
+using unique_device_t = unique_handle_t<VkDevice, device_deleter_t>;
+
+struct surface_deleter_t
+{
+    VkInstance instance;
+
+    auto operator()(VkSurfaceKHR p_surface) const -> void
+    {
+        vkDestroySurfaceKHR(instance, p_surface, nullptr);
+    }
+};
+
+using unique_surface_t = unique_handle_t<VkSurfaceKHR, surface_deleter_t>;
+
+struct instance_deleter_t
+{
+    auto operator()(VkInstance p_instance) const -> void
+    {
+        vkDestroyInstance(p_instance, nullptr);
+    }
+};
+
+using unique_instance_t = unique_handle_t<VkInstance, instance_deleter_t>;
+
+#endif
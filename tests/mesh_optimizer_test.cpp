@@ -0,0 +1,67 @@
+// Checks the vertex cache simulation against cases worked out by hand. Run by
+// CTest, see CMakeLists.txt.
+
+#include "mesh_optimizer.hpp"
+
+namespace
+{
+
+struct cache_case_t
+{
+    std::string_view name;
+    std::vector<std::uint32_t> indices;
+    std::uint32_t vertex_count;
+    std::uint32_t cache_size;
+    double acmr;
+    double atvr;
+};
+
+auto check_cache_case(const cache_case_t& p_case) -> bool
+{
+    const auto statistics = analyze_vertex_cache(
+        p_case.indices, p_case.vertex_count, p_case.cache_size);
+
+    if (statistics.acmr != p_case.acmr || statistics.atvr != p_case.atvr)
+    {
+        fmt::print(stderr,
+                   "[ERROR]: {}: expected an ACMR of {} and an ATVR of {}, "
+                   "but got {} and {}.\n",
+                   p_case.name, p_case.acmr, p_case.atvr, statistics.acmr,
+                   statistics.atvr);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const auto cases = std::array{
+        // The second copy of the triangle finds all three vertices cached.
+        cache_case_t{.name = "repeated triangle",
+                     .indices = {0, 1, 2, 0, 1, 2},
+                     .vertex_count = 3,
+                     .cache_size = 3,
+                     .acmr = 1.5,
+                     .atvr = 1.0},
+        // A single entry is enough for a degenerate triangle of one vertex.
+        cache_case_t{.name = "single entry",
+                     .indices = {0, 0, 0},
+                     .vertex_count = 1,
+                     .cache_size = 1,
+                     .acmr = 1.0,
+                     .atvr = 1.0}};
+
+    auto failed_count = 0;
+    for (const auto& cache_case : cases)
+    {
+        if (!check_cache_case(cache_case))
+        {
+            failed_count++;
+        }
+    }
+
+    return failed_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
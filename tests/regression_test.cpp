@@ -0,0 +1,554 @@
+// Renders one of a few fixed scenes with the render service, then either
+// compares the image against a stored reference or measures throughput
+// against a stored baseline. Run by CTest, see CMakeLists.txt.
+//
+// Usage: vulkan-triangle-regression --mode=image|performance --scene=<name>
+//            --program=<vulkan-triangle> --references=<directory>
+//            --baselines=<directory> --output=<directory>
+//            [--channel-tolerance=<0-255>] [--pixel-tolerance=<percent>]
+//            [--max-slowdown=<percent>]
+//
+// Throughput depends on the machine, so baselines aren't committed like the
+// reference images. A performance test without one records it and exits with
+// EXIT_SKIPPED. With VULKAN_TRIANGLE_UPDATE_REFERENCES set, the references and
+// baselines are overwritten with this run's results instead of being compared
+// against.
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+// CTest's SKIP_RETURN_CODE for the performance tests.
+constexpr auto EXIT_SKIPPED = 77;
+
+struct scene_t
+{
+    std::string_view name;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t object_count;
+    std::uint32_t subdivisions;
+    float time;
+
+    // How many frames the performance test renders in one job.
+    std::uint32_t frame_count;
+};
+
+constexpr auto SCENES = std::array{
+    scene_t{.name = "triangle",
+            .width = 256,
+            .height = 256,
+            .object_count = 1,
+            .subdivisions = 0,
+            .time = 0.0f,
+            .frame_count = 120},
+    scene_t{.name = "field",
+            .width = 512,
+            .height = 512,
+            .object_count = 1024,
+            .subdivisions = 0,
+            .time = 0.5f,
+            .frame_count = 60},
+    scene_t{.name = "mesh",
+            .width = 512,
+            .height = 512,
+            .object_count = 1,
+            .subdivisions = 9,
+            .time = 0.0f,
+            .frame_count = 30}};
+
+struct arguments_t
+{
+    std::string mode;
+    std::string scene;
+    std::filesystem::path program;
+    std::filesystem::path references;
+    std::filesystem::path baselines;
+    std::filesystem::path output;
+
+    // A pixel differs if any channel is off by more than this.
+    std::uint32_t channel_tolerance = 2;
+
+    // The test fails if more than this percentage of pixels differ.
+    double pixel_tolerance = 0.1;
+
+    // The test fails if triangles per second drop by more than this
+    // percentage.
+    double max_slowdown = 10.0;
+};
+
+struct image_t
+{
+    std::uint32_t width;
+    std::uint32_t height;
+
+    // Tightly packed RGB8.
+    std::vector<std::uint8_t> pixels;
+};
+
+// The render service's reply to a job.
+struct reply_t
+{
+    double latency;
+    std::vector<std::filesystem::path> paths;
+};
+
+auto parse_arguments(int p_argc, char** p_argv) -> std::optional<arguments_t>
+{
+    auto arguments = arguments_t{};
+
+    for (auto i = 1; i < p_argc; i++)
+    {
+        const auto argument = std::string_view(p_argv[i]);
+        const auto equals = argument.find('=');
+        if (argument.substr(0, 2) != "--" || equals == std::string_view::npos)
+        {
+            fmt::print(stderr, "[ERROR]: Expected --name=value, not \"{}\".\n",
+                       argument);
+            return std::nullopt;
+        }
+
+        const auto name = argument.substr(2, equals - 2);
+        const auto value = std::string(argument.substr(equals + 1));
+
+        if (name == "mode")
+        {
+            arguments.mode = value;
+        }
+        else if (name == "scene")
+        {
+            arguments.scene = value;
+        }
+        else if (name == "program")
+        {
+            arguments.program = value;
+        }
+        else if (name == "references")
+        {
+            arguments.references = value;
+        }
+        else if (name == "baselines")
+        {
+            arguments.baselines = value;
+        }
+        else if (name == "output")
+        {
+            arguments.output = value;
+        }
+        else if (name == "channel-tolerance")
+        {
+            arguments.channel_tolerance =
+                static_cast<std::uint32_t>(std::stoul(value));
+        }
+        else if (name == "pixel-tolerance")
+        {
+            arguments.pixel_tolerance = std::stod(value);
+        }
+        else if (name == "max-slowdown")
+        {
+            arguments.max_slowdown = std::stod(value);
+        }
+        else
+        {
+            fmt::print(stderr, "[ERROR]: Unknown argument \"{}\".\n", name);
+            return std::nullopt;
+        }
+    }
+
+    if ((arguments.mode != "image" && arguments.mode != "performance") ||
+        arguments.program.empty() || arguments.references.empty() ||
+        arguments.baselines.empty() || arguments.output.empty())
+    {
+        fmt::print(stderr, "[ERROR]: --mode=image|performance, --program, "
+                           "--references, --baselines and --output are "
+                           "required.\n");
+        return std::nullopt;
+    }
+
+    return arguments;
+}
+
+auto find_scene(std::string_view p_name) -> const scene_t*
+{
+    for (const auto& scene : SCENES)
+    {
+        if (scene.name == p_name)
+        {
+            return &scene;
+        }
+    }
+
+    return nullptr;
+}
+
+auto read_text_file(const std::filesystem::path& p_path)
+    -> std::optional<std::string>
+{
+    auto file = std::ifstream(p_path, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    auto stream = std::ostringstream();
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// Reads the binary PPM files that the render service writes.
+auto read_ppm(const std::filesystem::path& p_path) -> std::optional<image_t>
+{
+    auto file = std::ifstream(p_path, std::ios::binary);
+
+    auto magic = std::string();
+    auto image = image_t{};
+    auto max_value = std::uint32_t{0};
+    file >> magic >> image.width >> image.height >> max_value;
+    if (!file || magic != "P6" || max_value != 255)
+    {
+        return std::nullopt;
+    }
+
+    // A single whitespace character separates the header from the pixels.
+    file.get();
+
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height *
+                        3);
+    file.read(reinterpret_cast<char*>(image.pixels.data()),
+              static_cast<std::streamsize>(image.pixels.size()));
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    return image;
+}
+
+auto write_ppm(const std::filesystem::path& p_path, const image_t& p_image)
+    -> void
+{
+    auto file = std::ofstream(p_path, std::ios::binary);
+    file << fmt::format("P6\n{} {}\n255\n", p_image.width, p_image.height);
+    file.write(reinterpret_cast<const char*>(p_image.pixels.data()),
+               static_cast<std::streamsize>(p_image.pixels.size()));
+}
+
+// Runs a single job through the render service, on its standard input, and
+// returns the reply. The service's whole output is kept in the output
+// directory, and printed if anything goes wrong.
+auto render(const arguments_t& p_arguments, const scene_t& p_scene,
+            std::uint32_t p_frame_count) -> std::optional<reply_t>
+{
+    const auto prefix = fmt::format("{}_{}", p_scene.name, p_arguments.mode);
+    const auto jobs_path = p_arguments.output / (prefix + ".jobs");
+    const auto log_path = p_arguments.output / (prefix + ".log");
+
+    {
+        auto jobs = std::ofstream(jobs_path);
+        jobs << fmt::format("id={} width={} height={} frames={} objects={} "
+                            "subdivisions={} time={} output={}\nquit\n",
+                            p_scene.name, p_scene.width, p_scene.height,
+                            p_frame_count, p_scene.object_count,
+                            p_scene.subdivisions, p_scene.time,
+                            (p_arguments.output / (prefix + ".ppm")).string());
+    }
+
+    // Validation would only skew the timings.
+    const auto command = fmt::format(
+        "VULKAN_TRIANGLE_SERVICE=- {}\"{}\" < \"{}\" > \"{}\" 2>&1",
+        p_arguments.mode == "performance" ? "VULKAN_TRIANGLE_VALIDATION=0 "
+                                          : "",
+        p_arguments.program.string(), jobs_path.string(), log_path.string());
+
+    const auto status = std::system(command.c_str());
+    const auto log = read_text_file(log_path).value_or("");
+
+    auto stream = std::istringstream(log);
+    auto line = std::string();
+    while (std::getline(stream, line))
+    {
+        auto words = std::istringstream(line);
+        auto id = std::string();
+        auto result = std::string();
+        words >> id >> result;
+        if (id != p_scene.name || result != "ok")
+        {
+            continue;
+        }
+
+        auto reply = reply_t{};
+        words >> reply.latency;
+
+        auto path = std::string();
+        while (words >> path)
+        {
+            reply.paths.emplace_back(path);
+        }
+
+        if (status == 0 && !reply.paths.empty())
+        {
+            return reply;
+        }
+    }
+
+    fmt::print(stderr,
+               "[ERROR]: The render service didn't render the scene (exit "
+               "status {}). Its output was:\n{}\n",
+               status, log);
+    return std::nullopt;
+}
+
+auto check_image(const arguments_t& p_arguments, const scene_t& p_scene,
+                 bool p_update) -> int
+{
+    const auto reply = render(p_arguments, p_scene, 1);
+    if (!reply.has_value())
+    {
+        return EXIT_FAILURE;
+    }
+
+    const auto image = read_ppm(reply->paths[0]);
+    if (!image.has_value())
+    {
+        fmt::print(stderr, "[ERROR]: Failed to read {}.\n",
+                   reply->paths[0].string());
+        return EXIT_FAILURE;
+    }
+
+    const auto reference_path =
+        p_arguments.references / fmt::format("{}.ppm", p_scene.name);
+
+    if (p_update)
+    {
+        write_ppm(reference_path, *image);
+        fmt::print("[INFO]: Updated {}.\n", reference_path.string());
+        return EXIT_SUCCESS;
+    }
+
+    const auto reference = read_ppm(reference_path);
+    if (!reference.has_value())
+    {
+        fmt::print(stderr, "[ERROR]: There is no reference image at {}. Run "
+                           "with VULKAN_TRIANGLE_UPDATE_REFERENCES=1 to create "
+                           "it.\n",
+                   reference_path.string());
+        return EXIT_FAILURE;
+    }
+
+    if (reference->width != image->width ||
+        reference->height != image->height)
+    {
+        fmt::print(stderr, "[ERROR]: The image is {}x{}, but the reference is "
+                           "{}x{}.\n",
+                   image->width, image->height, reference->width,
+                   reference->height);
+        return EXIT_FAILURE;
+    }
+
+    // Differing pixels are white in the difference image.
+    auto difference = image_t{.width = image->width,
+                              .height = image->height,
+                              .pixels = std::vector<std::uint8_t>(
+                                  image->pixels.size(), 0)};
+    auto differing_count = std::size_t{0};
+    auto max_channel_difference = 0;
+
+    for (auto i = std::size_t{0}; i < image->pixels.size(); i += 3)
+    {
+        auto pixel_difference = 0;
+        for (auto channel = std::size_t{0}; channel < 3; channel++)
+        {
+            pixel_difference = (std::max)(
+                pixel_difference,
+                std::abs(static_cast<int>(image->pixels[i + channel]) -
+                         static_cast<int>(reference->pixels[i + channel])));
+        }
+
+        max_channel_difference =
+            (std::max)(max_channel_difference, pixel_difference);
+
+        if (pixel_difference > static_cast<int>(p_arguments.channel_tolerance))
+        {
+            differing_count++;
+            difference.pixels[i] = 255;
+            difference.pixels[i + 1] = 255;
+            difference.pixels[i + 2] = 255;
+        }
+    }
+
+    const auto pixel_count = image->pixels.size() / 3;
+    const auto differing_percentage = 100.0 *
+                                      static_cast<double>(differing_count) /
+                                      static_cast<double>(pixel_count);
+
+    fmt::print("[INFO]: {} of {} pixels ({:.3f}%) differ from the reference "
+               "by more than {}, and the largest difference is {}.\n",
+               differing_count, pixel_count, differing_percentage,
+               p_arguments.channel_tolerance, max_channel_difference);
+
+    if (differing_percentage > p_arguments.pixel_tolerance)
+    {
+        const auto difference_path =
+            p_arguments.output /
+            fmt::format("{}_difference.ppm", p_scene.name);
+        write_ppm(difference_path, difference);
+        fmt::print(stderr, "[ERROR]: More than {}% of the pixels differ. They "
+                           "are marked in {}.\n",
+                   p_arguments.pixel_tolerance, difference_path.string());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Finds "p_key": <number> in a results file written by check_performance().
+auto find_json_number(std::string_view p_json, std::string_view p_key)
+    -> std::optional<double>
+{
+    const auto quoted_key = fmt::format("\"{}\":", p_key);
+    const auto position = p_json.find(quoted_key);
+    if (position == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    const auto value =
+        std::string(p_json.substr(position + quoted_key.size()));
+    auto end = static_cast<char*>(nullptr);
+    const auto number = std::strtod(value.c_str(), &end);
+    if (end == value.c_str())
+    {
+        return std::nullopt;
+    }
+
+    return number;
+}
+
+// The frame time covers the whole of a frame in the service: recording,
+// rendering, the readback and writing the file.
+auto check_performance(const arguments_t& p_arguments, const scene_t& p_scene,
+                       bool p_update) -> int
+{
+    const auto reply = render(p_arguments, p_scene, p_scene.frame_count);
+    if (!reply.has_value())
+    {
+        return EXIT_FAILURE;
+    }
+
+    const auto triangles_per_frame =
+        static_cast<double>(p_scene.object_count) *
+        static_cast<double>(std::uint64_t{1} << (2 * p_scene.subdivisions));
+    const auto frame_time = reply->latency / p_scene.frame_count;
+    const auto frames_per_second = 1000.0 / frame_time;
+    const auto triangles_per_second = triangles_per_frame * frames_per_second;
+
+    const auto results = fmt::format(
+        "{{\n"
+        "    \"scene\": \"{}\",\n"
+        "    \"width\": {},\n"
+        "    \"height\": {},\n"
+        "    \"frames\": {},\n"
+        "    \"triangles_per_frame\": {:.0f},\n"
+        "    \"frame_time_ms\": {:.4f},\n"
+        "    \"frames_per_second\": {:.2f},\n"
+        "    \"triangles_per_second\": {:.0f}\n"
+        "}}\n",
+        p_scene.name, p_scene.width, p_scene.height, p_scene.frame_count,
+        triangles_per_frame, frame_time, frames_per_second,
+        triangles_per_second);
+
+    const auto results_path =
+        p_arguments.output / fmt::format("{}.json", p_scene.name);
+    std::ofstream(results_path) << results;
+
+    fmt::print("[INFO]: {} frames in {:.1f} ms, {:.3f} ms per frame, {:.0f} "
+               "triangles per second. Written to {}.\n",
+               p_scene.frame_count, reply->latency, frame_time,
+               triangles_per_second, results_path.string());
+
+    const auto baseline_path =
+        p_arguments.baselines / fmt::format("{}.json", p_scene.name);
+
+    if (p_update)
+    {
+        std::ofstream(baseline_path) << results;
+        fmt::print("[INFO]: Updated {}.\n", baseline_path.string());
+        return EXIT_SUCCESS;
+    }
+
+    const auto baseline_json = read_text_file(baseline_path);
+    const auto baseline =
+        baseline_json.has_value()
+            ? find_json_number(*baseline_json, "triangles_per_second")
+            : std::nullopt;
+    if (!baseline.has_value() || *baseline <= 0.0)
+    {
+        std::ofstream(baseline_path) << results;
+        fmt::print("[INFO]: There was no baseline, so this run was recorded "
+                   "as the baseline at {}.\n",
+                   baseline_path.string());
+        return EXIT_SKIPPED;
+    }
+
+    const auto change = 100.0 * (triangles_per_second / *baseline - 1.0);
+    fmt::print("[INFO]: Throughput changed by {:+.1f}% against the "
+               "baseline.\n",
+               change);
+
+    if (-change > p_arguments.max_slowdown)
+    {
+        fmt::print(stderr, "[ERROR]: Throughput dropped by more than {}%.\n",
+                   p_arguments.max_slowdown);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int p_argc, char** p_argv)
+{
+    const auto arguments = parse_arguments(p_argc, p_argv);
+    if (!arguments.has_value())
+    {
+        return EXIT_FAILURE;
+    }
+
+    const auto scene = find_scene(arguments->scene);
+    if (scene == nullptr)
+    {
+        fmt::print(stderr, "[ERROR]: Unknown scene \"{}\".\n",
+                   arguments->scene);
+        return EXIT_FAILURE;
+    }
+
+    const auto update_variable =
+        std::getenv("VULKAN_TRIANGLE_UPDATE_REFERENCES");
+    const auto update = update_variable != nullptr &&
+                        std::string_view(update_variable) != "0";
+
+    std::filesystem::create_directories(arguments->output);
+    std::filesystem::create_directories(arguments->baselines);
+    if (update)
+    {
+        std::filesystem::create_directories(arguments->references);
+    }
+
+    return arguments->mode == "image"
+               ? check_image(*arguments, *scene, update)
+               : check_performance(*arguments, *scene, update);
+}